@@ -3,13 +3,18 @@
 #include "config.hpp"
 #include "dialog.hpp"
 #include "filesystem.hpp"
+#include "json.hpp"
 #include "terminal.hpp"
 #include "utility.hpp"
 #include <boost/algorithm/string.hpp>
 #include <boost/optional.hpp>
+#include <algorithm>
 #include <future>
 #include <regex>
 
+Mutex CMake::code_models_mutex;
+std::map<boost::filesystem::path, std::shared_ptr<CMake::CodeModel>> CMake::code_models;
+
 CMake::CMake(const boost::filesystem::path &path) {
   const auto find_cmake_project = [](const boost::filesystem::path &file_path) {
     std::ifstream input(file_path.string(), std::ios::binary);
@@ -56,6 +61,8 @@ bool CMake::update_default_build(const boost::filesystem::path &default_build_pa
     }
   }
 
+  write_file_api_query(default_build_path);
+
   if(!force && boost::filesystem::exists(default_build_path / "compile_commands.json", ec))
     return true;
 
@@ -117,6 +124,8 @@ bool CMake::update_debug_build(const boost::filesystem::path &debug_build_path,
     }
   }
 
+  write_file_api_query(debug_build_path);
+
   if(!force && boost::filesystem::exists(debug_build_path / "CMakeCache.txt", ec))
     return true;
 
@@ -145,6 +154,36 @@ bool CMake::update_debug_build(const boost::filesystem::path &debug_build_path,
 }
 
 boost::filesystem::path CMake::get_executable(const boost::filesystem::path &build_path, const boost::filesystem::path &file_path) {
+  if(auto code_model = get_code_model(build_path)) {
+    ssize_t best_match_size = -1;
+    boost::filesystem::path best_match_executable;
+    // First only consider executables added in the cmake files of this project up to the given file,
+    // and then all executables, like the compile_commands.json fallback below
+    for(bool all_executables : {false, true}) {
+      for(auto &executable : code_model->executables) {
+        if(!all_executables && std::find(paths.begin(), paths.end(), executable.cmake_directory / "CMakeLists.txt") == paths.end())
+          continue;
+        for(auto &source_file : executable.sources) {
+          if(source_file == file_path)
+            return executable.path;
+          auto source_file_directory = source_file.parent_path();
+          if(filesystem::file_in_path(file_path, source_file_directory)) {
+            auto size = std::distance(source_file_directory.begin(), source_file_directory.end());
+            if(size > best_match_size) {
+              best_match_size = size;
+              best_match_executable = executable.path;
+            }
+          }
+        }
+      }
+      if(!best_match_executable.empty())
+        return best_match_executable;
+    }
+    return best_match_executable;
+  }
+
+  // Without a codemodel reply, for instance if the build was configured by an older CMake version,
+  // the executables are guessed from compile_commands.json and the cmake files.
   // CMake does not store in compile_commands.json if an object is part of an executable or not.
   // Therefore, executables are first attempted found in the cmake files. These executables
   // are then used to identify if a file in compile_commands.json is part of an executable or not
@@ -225,6 +264,81 @@ boost::filesystem::path CMake::get_executable(const boost::filesystem::path &bui
   return best_match_executable;
 }
 
+void CMake::write_file_api_query(const boost::filesystem::path &build_path) {
+  auto query_path = build_path / ".cmake" / "api" / "v1" / "query" / "client-jucipp";
+  boost::system::error_code ec;
+  if(boost::filesystem::exists(query_path / "codemodel-v2", ec))
+    return;
+  boost::filesystem::create_directories(query_path, ec);
+  if(!ec)
+    filesystem::write(query_path / "codemodel-v2");
+}
+
+std::shared_ptr<CMake::CodeModel> CMake::get_code_model(const boost::filesystem::path &build_path) {
+  // Reply files are never modified. Instead, CMake writes a new index file that has the largest name in lexicographic order.
+  boost::filesystem::path index_path;
+  boost::system::error_code ec;
+  for(boost::filesystem::directory_iterator it(build_path / ".cmake" / "api" / "v1" / "reply", ec), end; it != end; it.increment(ec)) {
+    auto path = it->path();
+    auto filename = path.filename().string();
+    if(starts_with(filename, "index-") && path.extension() == ".json" && filename > index_path.filename().string())
+      index_path = std::move(path);
+  }
+  if(index_path.empty())
+    return nullptr;
+
+  {
+    LockGuard lock(code_models_mutex);
+    auto it = code_models.find(build_path);
+    if(it != code_models.end() && it->second->index_path == index_path)
+      return it->second;
+  }
+
+  auto code_model = read_code_model(build_path, index_path);
+  if(!code_model)
+    return nullptr;
+  LockGuard lock(code_models_mutex);
+  code_models[build_path] = code_model;
+  return code_model;
+}
+
+std::shared_ptr<CMake::CodeModel> CMake::read_code_model(const boost::filesystem::path &build_path, const boost::filesystem::path &index_path) {
+  auto reply_path = index_path.parent_path();
+  auto code_model = std::make_shared<CodeModel>();
+  code_model->index_path = index_path;
+  try {
+    JSON index(index_path);
+    auto codemodel_file = index.object("reply").object("client-jucipp").object("codemodel-v2").string("jsonFile");
+    JSON codemodel(reply_path / codemodel_file);
+    auto paths = codemodel.object("paths");
+    boost::filesystem::path source_path = paths.string("source");
+    auto configurations = codemodel.array("configurations");
+    if(configurations.empty())
+      return nullptr;
+    for(auto &target_reference : configurations.front().array("targets")) {
+      JSON target(reply_path / target_reference.string("jsonFile"));
+      if(target.string("type") != "EXECUTABLE")
+        continue;
+      auto artifacts = target.array_or_empty("artifacts");
+      if(artifacts.empty())
+        continue;
+      CodeModel::Executable executable;
+      boost::filesystem::path artifact_path = artifacts.front().string("path");
+      executable.path = filesystem::get_normal_path(artifact_path.is_absolute() ? artifact_path : build_path / artifact_path);
+      executable.cmake_directory = filesystem::get_normal_path(source_path / target.object("paths").string("source"));
+      for(auto &source : target.array_or_empty("sources")) {
+        boost::filesystem::path path = source.string("path");
+        executable.sources.emplace_back(filesystem::get_normal_path(path.is_absolute() ? path : source_path / path));
+      }
+      code_model->executables.emplace_back(std::move(executable));
+    }
+  }
+  catch(...) {
+    return nullptr;
+  }
+  return code_model;
+}
+
 void CMake::parse_file(const std::string &src, std::map<std::string, std::list<std::string>> &variables, std::function<void(Function &&)> &&on_function) {
   size_t i = 0;
 
@@ -1,7 +1,9 @@
 #pragma once
+#include "mutex.hpp"
 #include <boost/filesystem.hpp>
 #include <list>
 #include <map>
+#include <memory>
 #include <vector>
 
 class CMake {
@@ -17,6 +19,31 @@ public:
 private:
   std::vector<boost::filesystem::path> paths;
 
+  /// Executable targets read from a CMake File API codemodel reply
+  class CodeModel {
+  public:
+    class Executable {
+    public:
+      boost::filesystem::path path;
+      /// Directory of the CMakeLists.txt file that added the executable
+      boost::filesystem::path cmake_directory;
+      std::vector<boost::filesystem::path> sources;
+    };
+
+    boost::filesystem::path index_path;
+    std::vector<Executable> executables;
+  };
+
+  static Mutex code_models_mutex;
+  /// Code models by build path. A code model is replaced when CMake writes a new reply index.
+  static std::map<boost::filesystem::path, std::shared_ptr<CodeModel>> code_models GUARDED_BY(code_models_mutex);
+
+  /// Requests CMake to write a codemodel reply the next time the build is configured
+  static void write_file_api_query(const boost::filesystem::path &build_path);
+  /// Returns nullptr if the build has no codemodel reply
+  static std::shared_ptr<CodeModel> get_code_model(const boost::filesystem::path &build_path);
+  static std::shared_ptr<CodeModel> read_code_model(const boost::filesystem::path &build_path, const boost::filesystem::path &index_path);
+
   struct Function {
     std::string name;
     std::list<std::string> parameters;
@@ -3,6 +3,7 @@
 #include "config.hpp"
 #include "filesystem.hpp"
 #include "json.hpp"
+#include "meson.hpp"
 #include "terminal.hpp"
 #include "utility.hpp"
 #include <algorithm>
@@ -118,14 +119,25 @@ std::vector<std::string> CompileCommands::get_arguments(const boost::filesystem:
   auto extension = file_path.extension().string();
   bool is_header = CompileCommands::is_header(file_path) || extension.empty(); // Include std C++ headers that are without extensions
 
+  // Meson builds are looked up in the cached Meson introspection instead of in compile_commands.json
+  auto meson_introspection = !build_path.empty() ? Meson::get_introspection(build_path) : nullptr;
+
   // If header file, use source file flags if they are in the same folder
   std::vector<boost::filesystem::path> file_paths;
   if(is_header && !extension.empty()) {
     auto parent_path = file_path.parent_path();
-    CompileCommands compile_commands(build_path);
-    for(auto &command : compile_commands.commands) {
-      if(command.file.parent_path() == parent_path)
-        file_paths.emplace_back(command.file);
+    if(meson_introspection) {
+      for(auto &parameters : meson_introspection->parameters) {
+        if(parameters.first.parent_path() == parent_path)
+          file_paths.emplace_back(parameters.first);
+      }
+    }
+    else {
+      CompileCommands compile_commands(build_path);
+      for(auto &command : compile_commands.commands) {
+        if(command.file.parent_path() == parent_path)
+          file_paths.emplace_back(command.file);
+      }
     }
   }
 
@@ -133,7 +145,36 @@ std::vector<std::string> CompileCommands::get_arguments(const boost::filesystem:
     file_paths.emplace_back(file_path);
 
   std::vector<std::string> arguments;
-  if(!build_path.empty()) {
+  auto add_arguments = [&arguments, is_header](const std::vector<std::string> &cmd_arguments, size_t begin, size_t end) {
+    bool ignore_next = false;
+    for(size_t c = begin; c < end; c++) {
+      if(ignore_next)
+        ignore_next = false;
+      else if(cmd_arguments[c] == "-o" ||
+              cmd_arguments[c] == "-x" ||                          // Remove language arguments since some tools add languages not understood by clang
+              (is_header && cmd_arguments[c] == "-include-pch") || // Header files should not use precompiled headers
+              cmd_arguments[c] == "-MF") {                         // Exclude dependency file generation
+        ignore_next = true;
+      }
+      else if(cmd_arguments[c] == "-c") {
+      }
+      else
+        arguments.emplace_back(cmd_arguments[c]);
+    }
+  };
+  if(meson_introspection) {
+    bool found = false;
+    for(auto &file_path : file_paths) {
+      auto it = meson_introspection->parameters.find(file_path);
+      if(it != meson_introspection->parameters.end()) {
+        add_arguments(*it->second, 0, it->second->size());
+        found = true;
+      }
+    }
+    if(!found)
+      arguments.emplace_back(default_std_argument);
+  }
+  else if(!build_path.empty()) {
     clangmm::CompilationDatabase db(build_path.string());
     if(db) {
       for(auto &file_path : file_paths) {
@@ -141,21 +182,8 @@ std::vector<std::string> CompileCommands::get_arguments(const boost::filesystem:
         auto commands = compile_commands.get_commands();
         for(auto &command : commands) {
           auto cmd_arguments = command.get_arguments();
-          bool ignore_next = false;
-          for(size_t c = 1; c + 1 < cmd_arguments.size(); c++) { // Exclude first and last argument
-            if(ignore_next)
-              ignore_next = false;
-            else if(cmd_arguments[c] == "-o" ||
-                    cmd_arguments[c] == "-x" ||                          // Remove language arguments since some tools add languages not understood by clang
-                    (is_header && cmd_arguments[c] == "-include-pch") || // Header files should not use precompiled headers
-                    cmd_arguments[c] == "-MF") {                         // Exclude dependency file generation
-              ignore_next = true;
-            }
-            else if(cmd_arguments[c] == "-c") {
-            }
-            else
-              arguments.emplace_back(cmd_arguments[c]);
-          }
+          if(cmd_arguments.size() > 2)
+            add_arguments(cmd_arguments, 1, cmd_arguments.size() - 1); // Exclude first and last argument
         }
       }
     }
@@ -157,6 +157,8 @@ void Config::read(const JSON &cfg) {
   source.clang_tidy_enable = source_json.boolean("clang_tidy_enable", JSON::ParseOptions::accept_string);
   source.clang_tidy_checks = source_json.string("clang_tidy_checks");
   source.clang_detailed_preprocessing_record = source_json.boolean("clang_detailed_preprocessing_record", JSON::ParseOptions::accept_string);
+  auto clang_memory_budget = source_json.integer("clang_memory_budget", JSON::ParseOptions::accept_string);
+  source.clang_memory_budget = clang_memory_budget > 0 ? static_cast<unsigned>(clang_memory_budget) : 0;
   source.debug_place_cursor_at_stop = source_json.boolean("debug_place_cursor_at_stop", JSON::ParseOptions::accept_string);
 
   for(auto &documentation_searches : cfg.children("documentation_searches")) {
@@ -294,6 +296,8 @@ std::string Config::default_config() {
     "clang_usages_threads": -1,
     "clang_detailed_preprocessing_record_comment": "Set to true to, at the cost of increased resource use, include all macro definitions and instantiations when parsing new C/C++ buffers. You should reopen buffers and delete build/.usages_clang after changing this option.",
     "clang_detailed_preprocessing_record": false,
+    "clang_memory_budget_comment": "Memory in megabytes that the translation units of open C/C++ buffers may use. When exceeded, the translation units of the least recently focused buffers are unloaded and parsed again when focused. Use 0 to keep all translation units loaded",
+    "clang_memory_budget": 2048,
     "debug_place_cursor_at_stop": false
   },
   "terminal": {
@@ -445,7 +449,8 @@ std::string Config::default_config() {
     "window_toggle_menu": "",
     "window_toggle_tabs": "",
     "window_toggle_zen_mode": "",
-    "window_clear_terminal": ""
+    "window_clear_terminal": "",
+    "window_toggle_trace_recording": ""
   },
   "documentation_searches": {
     "clang": {
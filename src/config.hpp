@@ -102,6 +102,8 @@ public:
     std::string clang_tidy_checks;
 
     bool clang_detailed_preprocessing_record = false;
+    /// In megabytes, where 0 means no limit
+    unsigned clang_memory_budget = 0;
 
     bool debug_place_cursor_at_stop;
 
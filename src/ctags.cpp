@@ -2,8 +2,10 @@
 #include "config.hpp"
 #include "dialog.hpp"
 #include "filesystem.hpp"
+#include "json.hpp"
 #include "project_build.hpp"
 #include "terminal.hpp"
+#include "trace.hpp"
 #include "utility.hpp"
 #include <climits>
 #include <vector>
@@ -11,6 +13,9 @@
 Ctags::Ctags(const boost::filesystem::path &path, bool enable_scope, bool enable_kind, const std::string &languages) : enable_scope(enable_scope), enable_kind(enable_kind) {
   if(path.empty())
     return;
+  Trace::Span span("Ctags");
+  if(Trace::is_recording())
+    span.set_args("\"path\":\"" + JSON::escape_string(path.string()) + '"');
   // TODO: When universal ctags is available on all platforms (Ubuntu 20.04 LTS does), add: --pattern-length-limit=0
   auto options = " --sort=foldcase -I \"override noexcept\" -f -" + (!languages.empty() ? " --languages=" + languages : std::string());
   std::string fields(" --fields=n");
@@ -2,10 +2,143 @@
 #include "entrybox.hpp"
 #include "filesystem.hpp"
 #include "notebook.hpp"
+#include "project_build.hpp"
+#include "project_files.hpp"
 #include "source.hpp"
 #include "terminal.hpp"
 #include "utility.hpp"
 #include <algorithm>
+#include <chrono>
+
+namespace {
+  /// Natural comparison supporting UTF-8 and locale
+  struct Natural {
+    static bool is_digit(char chr) {
+      return chr >= '0' && chr <= '9';
+    }
+
+    static int compare_characters(size_t &i1, size_t &i2, const std::string &s1, const std::string &s2) {
+      ScopeGuard scope_guard{[&i1, &i2] {
+        ++i1;
+        ++i2;
+      }};
+      auto c1 = static_cast<unsigned char>(s1[i1]);
+      auto c2 = static_cast<unsigned char>(s2[i2]);
+      if(c1 < 0b10000000 && c2 < 0b10000000) { // Both characters are ascii
+        auto at = std::tolower(s1[i1]);
+        auto bt = std::tolower(s2[i2]);
+        if(at < bt)
+          return -1;
+        else if(at == bt)
+          return 0;
+        else
+          return 1;
+      }
+
+      Glib::ustring u1;
+      if(c1 >= 0b11110000)
+        u1 = s1.substr(i1, 4);
+      else if(c1 >= 0b11100000)
+        u1 = s1.substr(i1, 3);
+      else if(c1 >= 0b11000000)
+        u1 = s1.substr(i1, 2);
+      else
+        u1 = s1[i1];
+
+      Glib::ustring u2;
+      if(c2 >= 0b11110000)
+        u2 = s2.substr(i2, 4);
+      else if(c2 >= 0b11100000)
+        u2 = s2.substr(i2, 3);
+      else if(c2 >= 0b11000000)
+        u2 = s2.substr(i2, 2);
+      else
+        u2 = s2[i2];
+
+      i1 += u1.bytes() - 1;
+      i2 += u2.bytes() - 1;
+
+      u1 = u1.lowercase();
+      u2 = u2.lowercase();
+
+      if(u1 < u2)
+        return -1;
+      else if(u1 == u2)
+        return 0;
+      else
+        return 1;
+    }
+
+    static int compare_numbers(size_t &i1, size_t &i2, const std::string &s1, const std::string &s2) {
+      int result = 0;
+      while(true) {
+        if(i1 >= s1.size() || !is_digit(s1[i1])) {
+          if(i2 >= s2.size() || !is_digit(s2[i2])) // a and b has equal number of digits
+            return result;
+          return -1; // a has fewer digits
+        }
+        if(i2 >= s2.size() || !is_digit(s2[i2]))
+          return 1; // b has fewer digits
+
+        if(result == 0) {
+          if(s1[i1] < s2[i2])
+            result = -1;
+          if(s1[i1] > s2[i2])
+            result = 1;
+        }
+        ++i1;
+        ++i2;
+      }
+    }
+
+    static int compare(const std::string &s1, const std::string &s2) {
+      size_t i1 = 0;
+      size_t i2 = 0;
+      while(i1 < s1.size() && i2 < s2.size()) {
+        if(is_digit(s1[i1]) && !is_digit(s2[i2]))
+          return -1;
+        if(!is_digit(s1[i1]) && is_digit(s2[i2]))
+          return 1;
+        if(!is_digit(s1[i1]) && !is_digit(s2[i2])) {
+          auto result = compare_characters(i1, i2, s1, s2);
+          if(result != 0)
+            return result;
+        }
+        else {
+          auto result = compare_numbers(i1, i2, s1, s2);
+          if(result != 0)
+            return result;
+        }
+      }
+      if(i1 >= s1.size())
+        return -1;
+      return 1;
+    }
+  };
+
+  /// Directories first, then hidden files, then natural order of names
+  int compare_entries(bool is_directory1, const std::string &name1, bool is_directory2, const std::string &name2) {
+    if(name1.empty())
+      return -1;
+    if(name2.empty())
+      return 1;
+    if(is_directory1 == is_directory2 && name1 == name2)
+      return 0;
+
+    std::string prefix1, prefix2;
+    prefix1 += is_directory1 ? 'a' : 'b';
+    prefix2 += is_directory2 ? 'a' : 'b';
+    prefix1 += name1[0] == '.' ? 'a' : 'b';
+    prefix2 += name2[0] == '.' ? 'a' : 'b';
+
+    return Natural::compare(prefix1 + name1, prefix2 + name2);
+  }
+
+  /// Number of rows that are shown before a load more row is added
+  const size_t page_size = 5000;
+  /// Maximum time used to insert rows before giving control back to the main loop
+  const std::chrono::milliseconds insert_time_budget(10);
+} // namespace
 
 bool Directories::TreeStore::row_drop_possible_vfunc(const Gtk::TreeModel::Path &path, const Gtk::SelectionData &selection_data) const {
   return true;
@@ -119,125 +252,12 @@ Directories::Directories() : Gtk::ListViewText(1) {
 
   tree_store->set_sort_column(column_record.name, Gtk::SortType::SORT_ASCENDING);
   tree_store->set_sort_func(column_record.name, [this](const Gtk::TreeModel::iterator &it1, const Gtk::TreeModel::iterator &it2) {
-    /// Natural comparison supporting UTF-8 and locale
-    struct Natural {
-      static bool is_digit(char chr) {
-        return chr >= '0' && chr <= '9';
-      }
-
-      static int compare_characters(size_t &i1, size_t &i2, const std::string &s1, const std::string &s2) {
-        ScopeGuard scope_guard{[&i1, &i2] {
-          ++i1;
-          ++i2;
-        }};
-        auto c1 = static_cast<unsigned char>(s1[i1]);
-        auto c2 = static_cast<unsigned char>(s2[i2]);
-        if(c1 < 0b10000000 && c2 < 0b10000000) { // Both characters are ascii
-          auto at = std::tolower(s1[i1]);
-          auto bt = std::tolower(s2[i2]);
-          if(at < bt)
-            return -1;
-          else if(at == bt)
-            return 0;
-          else
-            return 1;
-        }
-
-        Glib::ustring u1;
-        if(c1 >= 0b11110000)
-          u1 = s1.substr(i1, 4);
-        else if(c1 >= 0b11100000)
-          u1 = s1.substr(i1, 3);
-        else if(c1 >= 0b11000000)
-          u1 = s1.substr(i1, 2);
-        else
-          u1 = s1[i1];
-
-        Glib::ustring u2;
-        if(c2 >= 0b11110000)
-          u2 = s2.substr(i2, 4);
-        else if(c2 >= 0b11100000)
-          u2 = s2.substr(i2, 3);
-        else if(c2 >= 0b11000000)
-          u2 = s2.substr(i2, 2);
-        else
-          u2 = s2[i2];
-
-        i1 += u1.bytes() - 1;
-        i2 += u2.bytes() - 1;
-
-        u1 = u1.lowercase();
-        u2 = u2.lowercase();
-
-        if(u1 < u2)
-          return -1;
-        else if(u1 == u2)
-          return 0;
-        else
-          return 1;
-      }
-
-      static int compare_numbers(size_t &i1, size_t &i2, const std::string &s1, const std::string &s2) {
-        int result = 0;
-        while(true) {
-          if(i1 >= s1.size() || !is_digit(s1[i1])) {
-            if(i2 >= s2.size() || !is_digit(s2[i2])) // a and b has equal number of digits
-              return result;
-            return -1; // a has fewer digits
-          }
-          if(i2 >= s2.size() || !is_digit(s2[i2]))
-            return 1; // b has fewer digits
-
-          if(result == 0) {
-            if(s1[i1] < s2[i2])
-              result = -1;
-            if(s1[i1] > s2[i2])
-              result = 1;
-          }
-          ++i1;
-          ++i2;
-        }
-      }
-
-      static int compare(const std::string &s1, const std::string &s2) {
-        size_t i1 = 0;
-        size_t i2 = 0;
-        while(i1 < s1.size() && i2 < s2.size()) {
-          if(is_digit(s1[i1]) && !is_digit(s2[i2]))
-            return -1;
-          if(!is_digit(s1[i1]) && is_digit(s2[i2]))
-            return 1;
-          if(!is_digit(s1[i1]) && !is_digit(s2[i2])) {
-            auto result = compare_characters(i1, i2, s1, s2);
-            if(result != 0)
-              return result;
-          }
-          else {
-            auto result = compare_numbers(i1, i2, s1, s2);
-            if(result != 0)
-              return result;
-          }
-        }
-        if(i1 >= s1.size())
-          return -1;
-        return 1;
-      }
-    };
-
-    auto name1 = it1->get_value(column_record.name);
-    auto name2 = it2->get_value(column_record.name);
-    if(name1.empty())
-      return -1;
-    if(name2.empty())
+    if(it1->get_value(column_record.type) == PathType::load_more)
       return 1;
-
-    std::string prefix1, prefix2;
-    prefix1 += it1->get_value(column_record.is_directory) ? 'a' : 'b';
-    prefix2 += it2->get_value(column_record.is_directory) ? 'a' : 'b';
-    prefix1 += name1[0] == '.' ? 'a' : 'b';
-    prefix2 += name2[0] == '.' ? 'a' : 'b';
-
-    return Natural::compare(prefix1 + name1, prefix2 + name2);
+    if(it2->get_value(column_record.type) == PathType::load_more)
+      return -1;
+    return compare_entries(it1->get_value(column_record.is_directory), it1->get_value(column_record.name),
+                           it2->get_value(column_record.is_directory), it2->get_value(column_record.name));
   });
 
   set_enable_search(true); //TODO: why does this not work in OS X?
@@ -246,6 +266,16 @@ Directories::Directories() : Gtk::ListViewText(1) {
   signal_row_activated().connect([this](const Gtk::TreeModel::Path &path, Gtk::TreeViewColumn *column) {
     auto iter = tree_store->get_iter(path);
     if(iter) {
+      if(iter->get_value(column_record.type) == PathType::load_more) {
+        auto parent = iter->parent();
+        auto it = directories.find(parent ? parent->get_value(column_record.path).string() : this->path.string());
+        if(it != directories.end()) {
+          it->second.rows_limit += page_size;
+          tree_store->erase(iter);
+          add_or_update_path(it->first, it->second.row, false);
+        }
+        return;
+      }
       auto filesystem_path = iter->get_value(column_record.path);
       if(filesystem_path != "") {
         boost::system::error_code ec;
@@ -539,6 +569,10 @@ void Directories::open(const boost::filesystem::path &dir_path) {
 
   add_or_update_path(path, Gtk::TreeModel::Row(), true);
 
+  // Start building the file list used by Find File in the background
+  auto build = Project::Build::create(path);
+  ProjectFiles::get(!build->project_path.empty() ? build->project_path : path, build->get_exclude_folders());
+
   if(auto view = Notebook::get().get_current_view())
     view->update_status_file_path(view);
 }
@@ -598,7 +632,13 @@ void Directories::select(const boost::filesystem::path &select_path) {
     parent_path = select_path.parent_path();
 
   //check if select_path is already expanded
-  if(directories.find(parent_path.string()) != directories.end()) {
+  auto parent_it = directories.find(parent_path.string());
+  if(parent_it != directories.end()) {
+    // Rows are added in the background, so make sure they are added before searching
+    if(parent_it->second.loading) {
+      auto row = parent_it->second.row;
+      add_or_update_path(parent_path, row, false, true);
+    }
     //set cursor at select_path and return
     tree_store->foreach_iter([this, &select_path](const Gtk::TreeModel::iterator &iter) {
       if(iter->get_value(column_record.path) == select_path) {
@@ -619,10 +659,13 @@ void Directories::select(const boost::filesystem::path &select_path) {
   }
 
   //expand to select_path
+  auto path_it = directories.find(path.string());
+  if(path_it != directories.end() && path_it->second.loading)
+    add_or_update_path(path, Gtk::TreeModel::Row(), false, true);
   for(auto &a_path : paths) {
     tree_store->foreach_iter([this, &a_path](const Gtk::TreeModel::iterator &iter) {
       if(iter->get_value(column_record.path) == a_path) {
-        add_or_update_path(a_path, *iter, true);
+        add_or_update_path(a_path, *iter, true, true);
         return true;
       }
       return false;
@@ -670,7 +713,7 @@ bool Directories::on_button_press_event(GdkEventButton *event) {
   return Gtk::TreeView::on_button_press_event(event);
 }
 
-void Directories::add_or_update_path(const boost::filesystem::path &dir_path, const Gtk::TreeModel::Row &row, bool include_parent_paths) {
+void Directories::add_or_update_path(const boost::filesystem::path &dir_path, const Gtk::TreeModel::Row &row, bool include_parent_paths, bool synchronous) {
   auto path_it = directories.find(dir_path.string());
   boost::system::error_code ec;
   if(!boost::filesystem::exists(dir_path, ec)) {
@@ -680,10 +723,7 @@ void Directories::add_or_update_path(const boost::filesystem::path &dir_path, co
   }
 
   if(path_it == directories.end()) {
-    auto g_file = Gio::File::create_for_path(dir_path.string());
-    auto monitor = g_file->monitor_directory(Gio::FileMonitorFlags::FILE_MONITOR_WATCH_MOVES);
     auto path_and_row = std::make_shared<std::pair<boost::filesystem::path, Gtk::TreeModel::Row>>(dir_path, row);
-    auto connection = std::make_shared<sigc::connection>();
 
     std::shared_ptr<Git::Repository> repository;
     try {
@@ -692,64 +732,81 @@ void Directories::add_or_update_path(const boost::filesystem::path &dir_path, co
     catch(const std::exception &) {
     }
 
-    monitor->signal_changed().connect([this, connection, path_and_row, repository](const Glib::RefPtr<Gio::File> &file,
-                                                                                   const Glib::RefPtr<Gio::File> &,
-                                                                                   Gio::FileMonitorEvent monitor_event) {
-      if(monitor_event != Gio::FileMonitorEvent::FILE_MONITOR_EVENT_CHANGES_DONE_HINT) {
-        if(repository)
-          repository->clear_saved_status();
-        connection->disconnect();
-        *connection = Glib::signal_timeout().connect(
-            [this, path_and_row]() {
-              if(directories.find(path_and_row->first.string()) != directories.end())
-                add_or_update_path(path_and_row->first, path_and_row->second, true);
-              return false;
-            },
-            500);
-      }
+    std::shared_ptr<FileWatcher::Subscription> monitor = FileWatcher::get().subscribe(dir_path, true, [this, path_and_row, repository](std::vector<boost::filesystem::path> &&) {
+      if(repository)
+        repository->clear_saved_status();
+      if(directories.find(path_and_row->first.string()) != directories.end())
+        add_or_update_path(path_and_row->first, path_and_row->second, true);
     });
 
-    std::shared_ptr<sigc::connection> repository_connection(new sigc::connection(), [](sigc::connection *connection) {
+    std::shared_ptr<FileWatcher::Subscription> repository_monitor;
+    if(repository) {
+      repository_monitor = FileWatcher::get().subscribe(repository->get_path(), true, [this, path_and_row](std::vector<boost::filesystem::path> &&) {
+        if(directories.find(path_and_row->first.string()) != directories.end())
+          colorize_path(path_and_row->first, false);
+      });
+    }
+    std::shared_ptr<sigc::connection> insert_connection(new sigc::connection(), [](sigc::connection *connection) {
       connection->disconnect();
       delete connection;
     });
 
-    if(repository) {
-      auto connection = std::make_shared<sigc::connection>();
-      *repository_connection = repository->monitor->signal_changed().connect([this, connection, path_and_row](const Glib::RefPtr<Gio::File> &file,
-                                                                                                              const Glib::RefPtr<Gio::File> &,
-                                                                                                              Gio::FileMonitorEvent monitor_event) {
-        if(monitor_event != Gio::FileMonitorEvent::FILE_MONITOR_EVENT_CHANGES_DONE_HINT) {
-          connection->disconnect();
-          *connection = Glib::signal_timeout().connect(
-              [this, path_and_row] {
-                if(directories.find(path_and_row->first.string()) != directories.end())
-                  colorize_path(path_and_row->first, false);
-                return false;
-              },
-              500);
-        }
-      });
-    }
-    directories[dir_path.string()] = {row, monitor, repository, repository_connection};
+    directories[dir_path.string()] = {row, monitor, repository, repository_monitor, insert_connection};
   }
 
-  Gtk::TreeNodeChildren children(row ? row.children() : tree_store->children());
-  if(!children.empty()) {
-    if(children.begin()->get_value(column_record.path) == "")
-      tree_store->erase(children.begin());
+  auto &data = directories[dir_path.string()];
+  auto read_generation = data.read_generation = ++read_count;
+
+  if(synchronous) {
+    update_rows(dir_path.string(), get_entries(dir_path), include_parent_paths, true);
+    return;
   }
 
-  std::unordered_map<std::string, boost::filesystem::path> filenames;
-  for(boost::filesystem::directory_iterator it(dir_path, ec), end; it != end; it++) {
+  data.loading = true;
+  thread_pool.push([this, dir_path, include_parent_paths, read_generation] {
+    auto entries = get_entries(dir_path);
+    dispatcher.post([this, dir_path = dir_path.string(), include_parent_paths, read_generation, entries = std::move(entries)]() mutable {
+      auto it = directories.find(dir_path);
+      if(it != directories.end() && it->second.read_generation == read_generation) // Skip if the directory has been read again since
+        update_rows(dir_path, std::move(entries), include_parent_paths, false);
+    });
+  });
+}
+
+std::vector<Directories::Entry> Directories::get_entries(const boost::filesystem::path &dir_path) {
+  std::vector<Entry> entries;
+  boost::system::error_code ec;
+  for(boost::filesystem::directory_iterator it(dir_path, ec), end; it != end; it.increment(ec)) {
+    if(ec)
+      break;
     auto path = it->path();
-    filenames.emplace(path.filename().string(), path);
+    boost::system::error_code status_ec;
+    auto is_directory = boost::filesystem::is_directory(it->status(status_ec));
+    entries.emplace_back(Entry{path.filename().string(), std::move(path), is_directory});
   }
+  std::sort(entries.begin(), entries.end(), [](const Entry &entry1, const Entry &entry2) {
+    return compare_entries(entry1.is_directory, entry1.name, entry2.is_directory, entry2.name) < 0;
+  });
+  return entries;
+}
 
+void Directories::update_rows(const std::string &dir_path, std::vector<Entry> entries, bool include_parent_paths, bool synchronous) {
+  auto &data = directories.find(dir_path)->second;
+  data.insert_connection->disconnect();
+
+  std::unordered_set<std::string> names;
+  for(auto &entry : entries)
+    names.emplace(entry.name);
+
+  Gtk::TreeNodeChildren children(data.row ? data.row.children() : tree_store->children());
   std::unordered_set<std::string> already_added;
   for(auto it = children.begin(); it != children.end();) {
+    if(it->get_value(column_record.path).empty()) { // Remove (empty) and load more rows
+      it = tree_store->erase(it);
+      continue;
+    }
     auto filename = it->get_value(column_record.name);
-    if(filenames.find(filename) != filenames.end()) {
+    if(names.find(filename) != names.end()) {
       already_added.emplace(filename);
       ++it;
     }
@@ -761,38 +818,85 @@ void Directories::add_or_update_path(const boost::filesystem::path &dir_path, co
     }
   }
 
-  for(auto &filename : filenames) {
-    if(already_added.find(filename.first) == already_added.end()) {
-      auto child = tree_store->append(children);
-      boost::system::error_code ec;
-      auto is_directory = boost::filesystem::is_directory(filename.second, ec);
-      child->set_value(column_record.is_directory, is_directory);
-      child->set_value(column_record.name, filename.first);
-      child->set_value(column_record.markup, Glib::Markup::escape_text(filename.first));
-      child->set_value(column_record.path, filename.second);
-      if(is_directory) {
-        auto grandchild = tree_store->append(child->children());
-        grandchild->set_value(column_record.is_directory, false);
-        grandchild->set_value(column_record.name, std::string("(empty)"));
-        grandchild->set_value(column_record.markup, Glib::Markup::escape_text("(empty)"));
-        grandchild->set_value(column_record.type, PathType::unknown);
-      }
-      else {
-        auto language = Source::guess_language(filename.first);
-        if(!language)
-          child->set_value(column_record.type, PathType::unknown);
+  data.pending_entries.clear();
+  data.pending_entries_index = 0;
+  for(auto &entry : entries) {
+    if(already_added.find(entry.name) == already_added.end())
+      data.pending_entries.emplace_back(std::move(entry));
+  }
+  data.rows_count = already_added.size();
+  data.rows_limit = std::max(data.rows_limit, data.rows_count + page_size);
+
+  if(insert_pending_rows(dir_path, include_parent_paths, synchronous)) {
+    *data.insert_connection = Glib::signal_idle().connect([this, dir_path, include_parent_paths] {
+      return insert_pending_rows(dir_path, include_parent_paths, false);
+    });
+  }
+}
+
+bool Directories::insert_pending_rows(const std::string &dir_path, bool include_parent_paths, bool insert_all) {
+  auto it = directories.find(dir_path);
+  if(it == directories.end())
+    return false;
+  auto &data = it->second;
+  Gtk::TreeNodeChildren children(data.row ? data.row.children() : tree_store->children());
+
+  // Entries are sorted, so each row is appended at its sorted position
+  auto start_time = std::chrono::steady_clock::now();
+  while(data.pending_entries_index < data.pending_entries.size()) {
+    if(!insert_all) {
+      if(data.rows_count >= data.rows_limit) {
+        auto child = tree_store->append(children);
+        child->set_value(column_record.is_directory, false);
+        child->set_value(column_record.type, PathType::load_more);
+        auto name = "(" + std::to_string(data.pending_entries.size() - data.pending_entries_index) + " more)";
+        child->set_value(column_record.name, name);
+        child->set_value(column_record.markup, "<i>" + Glib::Markup::escape_text(name) + "</i>");
+        data.loading = false;
+        return false;
       }
+      if(std::chrono::steady_clock::now() - start_time > insert_time_budget)
+        return true;
     }
-  }
-  if(children.empty()) {
+
+    auto &entry = data.pending_entries[data.pending_entries_index++];
     auto child = tree_store->append(children);
-    child->set_value(column_record.is_directory, false);
-    child->set_value(column_record.name, std::string("(empty)"));
-    child->set_value(column_record.markup, Glib::Markup::escape_text("(empty)"));
-    child->set_value(column_record.type, PathType::unknown);
+    child->set_value(column_record.is_directory, entry.is_directory);
+    child->set_value(column_record.name, entry.name);
+    child->set_value(column_record.markup, Glib::Markup::escape_text(entry.name));
+    child->set_value(column_record.path, entry.path);
+    if(entry.is_directory) {
+      auto grandchild = tree_store->append(child->children());
+      grandchild->set_value(column_record.is_directory, false);
+      grandchild->set_value(column_record.name, std::string("(empty)"));
+      grandchild->set_value(column_record.markup, Glib::Markup::escape_text("(empty)"));
+      grandchild->set_value(column_record.type, PathType::unknown);
+    }
+    else {
+      auto language = Source::guess_language(entry.name);
+      if(!language)
+        child->set_value(column_record.type, PathType::unknown);
+    }
+    ++data.rows_count;
   }
+  data.pending_entries.clear();
+  data.pending_entries.shrink_to_fit();
+  data.pending_entries_index = 0;
+  data.loading = false;
+
+  if(children.empty())
+    add_empty_row(children);
 
   colorize_path(dir_path, include_parent_paths);
+  return false;
+}
+
+void Directories::add_empty_row(const Gtk::TreeNodeChildren &children) {
+  auto child = tree_store->append(children);
+  child->set_value(column_record.is_directory, false);
+  child->set_value(column_record.name, std::string("(empty)"));
+  child->set_value(column_record.markup, Glib::Markup::escape_text("(empty)"));
+  child->set_value(column_record.type, PathType::unknown);
 }
 
 void Directories::remove_path(const boost::filesystem::path &dir_path) {
@@ -812,11 +916,7 @@ void Directories::remove_path(const boost::filesystem::path &dir_path) {
     while(children) {
       tree_store->erase(children.begin());
     }
-    auto child = tree_store->append(children);
-    child->set_value(column_record.is_directory, false);
-    child->set_value(column_record.name, std::string("(empty)"));
-    child->set_value(column_record.markup, Glib::Markup::escape_text("(empty)"));
-    child->set_value(column_record.type, PathType::unknown);
+    add_empty_row(children);
   }
 }
 
@@ -834,7 +934,7 @@ void Directories::colorize_path(boost::filesystem::path dir_path_, bool include_
 
   if(it->second.repository) {
     auto repository = it->second.repository;
-    thread_pool.push([this, dir_path, repository, include_parent_paths] {
+    thread_pool.push([this, dir_path, repository = std::move(repository), include_parent_paths]() mutable {
       Git::Repository::Status status;
       try {
         status = repository->get_status();
@@ -843,7 +943,8 @@ void Directories::colorize_path(boost::filesystem::path dir_path_, bool include_
         Terminal::get().async_print(std::string("\e[31mError (git)\e[m: ") + e.what() + '\n', true);
       }
 
-      dispatcher.post([this, dir_path, include_parent_paths, status = std::move(status)] {
+      // Hand the repository back, so that it is released in the main GUI thread
+      dispatcher.post([this, dir_path, include_parent_paths, status = std::move(status), repository = std::move(repository)] {
         auto it = directories.find(dir_path->string());
         if(it == directories.end())
           return;
@@ -1,6 +1,7 @@
 #pragma once
 #include "boost/filesystem.hpp"
 #include "dispatcher.hpp"
+#include "file_watcher.hpp"
 #include "git.hpp"
 #include <atomic>
 #include <gtkmm.h>
@@ -10,17 +11,38 @@
 #include <vector>
 
 class Directories : public Gtk::ListViewText {
+  class Entry {
+  public:
+    std::string name;
+    boost::filesystem::path path;
+    bool is_directory;
+  };
+
   class DirectoryData {
   public:
     Gtk::TreeModel::Row row;
-    Glib::RefPtr<Gio::FileMonitor> monitor;
+    std::shared_ptr<FileWatcher::Subscription> monitor;
     std::shared_ptr<Git::Repository> repository;
-    std::shared_ptr<sigc::connection> connection;
+    std::shared_ptr<FileWatcher::Subscription> repository_monitor;
+    /// Connection to the idle handler that inserts pending_entries
+    std::shared_ptr<sigc::connection> insert_connection;
+    /// Sorted entries that are not yet added to the tree
+    std::vector<Entry> pending_entries = {};
+    size_t pending_entries_index = 0;
+    /// Number of entry rows added to the tree
+    size_t rows_count = 0;
+    /// Maximum number of entry rows before a load more row is shown
+    size_t rows_limit = 0;
+    /// True while the directory is read or its rows are inserted
+    bool loading = false;
+    /// Generation of the latest read of the directory. Results from older reads are discarded.
+    size_t read_generation = 0;
   };
 
   enum class PathType {
     known,
-    unknown
+    unknown,
+    load_more
   };
 
   class TreeStore : public Gtk::TreeStore {
@@ -72,7 +94,15 @@ protected:
   bool on_button_press_event(GdkEventButton *event) override;
 
 private:
-  void add_or_update_path(const boost::filesystem::path &dir_path, const Gtk::TreeModel::Row &row, bool include_parent_paths);
+  /// The directory is read in a background thread and rows are added in batches, unless synchronous is true
+  void add_or_update_path(const boost::filesystem::path &dir_path, const Gtk::TreeModel::Row &row, bool include_parent_paths, bool synchronous = false);
+  /// Returns the directory entries sorted in the order they are shown. Can be called from any thread.
+  static std::vector<Entry> get_entries(const boost::filesystem::path &dir_path);
+  /// Removes rows that are no longer in entries, and adds the new entries
+  void update_rows(const std::string &dir_path, std::vector<Entry> entries, bool include_parent_paths, bool synchronous);
+  /// Returns true if there are more rows to insert in a later call
+  bool insert_pending_rows(const std::string &dir_path, bool include_parent_paths, bool insert_all);
+  void add_empty_row(const Gtk::TreeNodeChildren &children);
   void remove_path(const boost::filesystem::path &dir_path);
   void colorize_path(boost::filesystem::path dir_path_, bool include_parent_paths);
 
@@ -80,6 +110,8 @@ private:
   TreeStore::ColumnRecord column_record;
 
   std::unordered_map<std::string, DirectoryData> directories;
+  /// Number of directory reads started, used to give each read a unique generation
+  size_t read_count = 0;
 
   Glib::ThreadPool thread_pool;
   Dispatcher dispatcher;
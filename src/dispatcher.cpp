@@ -1,5 +1,6 @@
 #include "dispatcher.hpp"
-#include <vector>
+#include "trace.hpp"
+#include <algorithm>
 
 Dispatcher::Dispatcher() {
   connect();
@@ -7,21 +8,29 @@ Dispatcher::Dispatcher() {
 
 void Dispatcher::connect() {
   connection = dispatcher.connect([this] {
-    std::vector<std::list<std::function<void()>>::iterator> its;
+    std::vector<Function> batch;
     {
       LockGuard lock(functions_mutex);
       if(functions.empty())
         return;
-      its.reserve(functions.size());
-      for(auto it = functions.begin(); it != functions.end(); ++it)
-        its.emplace_back(it);
+      batch.swap(functions);
     }
-    for(auto &it : its)
-      (*it)();
-    {
-      LockGuard lock(functions_mutex);
-      for(auto &it : its)
-        functions.erase(it);
+    Trace::Span span("Dispatcher batch");
+    long long batch_latency_us = 0, batch_max_latency_us = 0;
+    for(auto &function : batch) {
+      long long latency_us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - function.time).count();
+      batch_latency_us += latency_us;
+      batch_max_latency_us = std::max(batch_max_latency_us, latency_us);
+      function.function();
+    }
+    total_latency_us += batch_latency_us;
+    if(batch_max_latency_us > max_latency_us)
+      max_latency_us = batch_max_latency_us;
+    processed += batch.size();
+    if(Trace::is_recording()) {
+      Trace::counter("Dispatcher batch size", static_cast<long long>(batch.size()));
+      Trace::counter("Dispatcher max latency (us)", batch_max_latency_us);
+      span.set_args("\"size\":" + std::to_string(batch.size()) + ",\"max_latency_us\":" + std::to_string(batch_max_latency_us));
     }
   });
 }
@@ -40,3 +49,17 @@ void Dispatcher::reset() {
   functions.clear();
   connect();
 }
+
+Dispatcher::Statistics Dispatcher::get_statistics() {
+  Statistics statistics;
+  {
+    LockGuard lock(functions_mutex);
+    statistics.queue_depth = functions.size();
+    statistics.max_queue_depth = max_queue_depth;
+  }
+  statistics.posted = posted;
+  statistics.processed = processed;
+  statistics.max_latency = std::chrono::microseconds(max_latency_us);
+  statistics.average_latency = std::chrono::microseconds(statistics.processed > 0 ? total_latency_us / static_cast<long long>(statistics.processed) : 0);
+  return statistics;
+}
@@ -1,16 +1,46 @@
 #pragma once
 #include "mutex.hpp"
+#include <atomic>
+#include <chrono>
 #include <functional>
 #include <gtkmm.h>
-#include <list>
+#include <vector>
 
 class Dispatcher {
+public:
+  struct Statistics {
+    /// Number of functions waiting to be processed
+    size_t queue_depth;
+    size_t max_queue_depth;
+    size_t posted;
+    size_t processed;
+    /// Time from post() to the function being run in the main GUI thread
+    std::chrono::microseconds max_latency;
+    std::chrono::microseconds average_latency;
+  };
+
 private:
+  struct Function {
+    template <typename T>
+    Function(T &&function) : function(std::forward<T>(function)), time(std::chrono::steady_clock::now()) {}
+
+    std::function<void()> function;
+    std::chrono::steady_clock::time_point time;
+  };
+
   Mutex functions_mutex;
-  std::list<std::function<void()>> functions GUARDED_BY(functions_mutex);
+  /// Functions are moved out in one batch by the main GUI thread.
+  /// The Glib::Dispatcher pipe is only signalled when this goes from empty to non-empty.
+  std::vector<Function> functions GUARDED_BY(functions_mutex);
+  size_t max_queue_depth GUARDED_BY(functions_mutex) = 0;
   Glib::Dispatcher dispatcher;
   sigc::connection connection;
 
+  std::atomic<size_t> posted = {0};
+  std::atomic<size_t> processed = {0};
+  std::atomic<long long> total_latency_us = {0};
+  std::atomic<long long> max_latency_us = {0};
+
   void connect();
 
 public:
@@ -23,8 +53,13 @@ public:
   template <typename T>
   void post(T &&function) {
     LockGuard lock(functions_mutex);
+    bool signal = functions.empty();
     functions.emplace_back(std::forward<T>(function));
-    dispatcher();
+    if(functions.size() > max_queue_depth)
+      max_queue_depth = functions.size();
+    ++posted;
+    if(signal)
+      dispatcher();
   }
 
   /// Must be called from main GUI thread
@@ -32,4 +67,7 @@ public:
 
   /// Must be called from main GUI thread
   void reset();
+
+  /// Can be called from any thread.
+  Statistics get_statistics();
 };
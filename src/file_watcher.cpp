@@ -0,0 +1,77 @@
+#include "file_watcher.hpp"
+#include <algorithm>
+
+FileWatcher::Subscription::~Subscription() {
+  delayed_changed_connection.disconnect();
+  auto &subscriptions = directory->subscriptions;
+  subscriptions.erase(std::remove(subscriptions.begin(), subscriptions.end(), this), subscriptions.end());
+}
+
+FileWatcher::Directory::~Directory() {
+  monitor_changed_connection.disconnect();
+  if(monitor)
+    monitor->cancel();
+}
+
+void FileWatcher::Directory::on_changed(const boost::filesystem::path &path) {
+  for(auto &subscription : subscriptions) {
+    if(path == subscription->path || (subscription->is_directory && path.parent_path() == subscription->path)) {
+      if(std::find(subscription->changed_paths.begin(), subscription->changed_paths.end(), path) == subscription->changed_paths.end())
+        subscription->changed_paths.emplace_back(path);
+      subscription->delayed_changed_connection.disconnect();
+      subscription->delayed_changed_connection = Glib::signal_timeout().connect(
+          [subscription] {
+            auto paths = std::move(subscription->changed_paths);
+            subscription->changed_paths.clear();
+            auto on_changed = subscription->on_changed; // The subscription might be destroyed in on_changed
+            on_changed(std::move(paths));
+            return false;
+          },
+          subscription->delay);
+    }
+  }
+}
+
+std::unique_ptr<FileWatcher::Subscription> FileWatcher::subscribe(const boost::filesystem::path &path, bool is_directory, std::function<void(std::vector<boost::filesystem::path> &&paths)> on_changed, unsigned delay) {
+  auto directory_path = is_directory ? path : path.parent_path();
+
+  std::shared_ptr<Directory> directory;
+  auto it = directories.find(directory_path.string());
+  if(it != directories.end())
+    directory = it->second.lock();
+  if(!directory) {
+    for(auto it = directories.begin(); it != directories.end();) {
+      if(it->second.expired())
+        it = directories.erase(it);
+      else
+        ++it;
+    }
+
+    directory = std::make_shared<Directory>();
+    try {
+      directory->monitor = Gio::File::create_for_path(directory_path.string())->monitor_directory(Gio::FileMonitorFlags::FILE_MONITOR_WATCH_MOVES);
+      auto directory_ptr = directory.get();
+      directory->monitor_changed_connection = directory->monitor->signal_changed().connect([directory_ptr](const Glib::RefPtr<Gio::File> &file,
+                                                                                                           const Glib::RefPtr<Gio::File> &other_file,
+                                                                                                           Gio::FileMonitorEvent monitor_event) {
+        if(monitor_event == Gio::FileMonitorEvent::FILE_MONITOR_EVENT_CHANGES_DONE_HINT)
+          return;
+        directory_ptr->on_changed(file->get_path());
+        if(other_file)
+          directory_ptr->on_changed(other_file->get_path());
+      });
+    }
+    catch(const Glib::Error &) {
+    }
+    directories[directory_path.string()] = directory;
+  }
+
+  std::unique_ptr<Subscription> subscription(new Subscription());
+  subscription->directory = std::move(directory);
+  subscription->path = path;
+  subscription->is_directory = is_directory;
+  subscription->delay = delay;
+  subscription->on_changed = std::move(on_changed);
+  subscription->directory->subscriptions.emplace_back(subscription.get());
+  return subscription;
+}
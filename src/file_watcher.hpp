@@ -0,0 +1,58 @@
+#pragma once
+#include <boost/filesystem.hpp>
+#include <functional>
+#include <giomm.h>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+/// Process wide file system watcher. Each directory is monitored at most once, however many views,
+/// directory tree rows, repositories and file lists subscribe to it or to files in it.
+/// Changes are coalesced per subscription, and delivered when no further changes have happened for the subscription's delay.
+/// Must be used from main GUI thread.
+class FileWatcher {
+  class Directory;
+
+public:
+  class Subscription {
+    friend class FileWatcher;
+    friend class Directory;
+    std::shared_ptr<Directory> directory;
+    boost::filesystem::path path;
+    bool is_directory;
+    unsigned delay;
+    std::function<void(std::vector<boost::filesystem::path> &&paths)> on_changed;
+    std::vector<boost::filesystem::path> changed_paths;
+    sigc::connection delayed_changed_connection;
+
+  public:
+    ~Subscription();
+  };
+
+private:
+  class Directory {
+  public:
+    ~Directory();
+
+    Glib::RefPtr<Gio::FileMonitor> monitor;
+    sigc::connection monitor_changed_connection;
+    std::vector<Subscription *> subscriptions;
+
+    void on_changed(const boost::filesystem::path &path);
+  };
+
+  FileWatcher() = default;
+
+  std::unordered_map<std::string, std::weak_ptr<Directory>> directories;
+
+public:
+  static FileWatcher &get() {
+    static FileWatcher instance;
+    return instance;
+  }
+
+  /// Calls on_changed with the changed paths when path has not changed for delay milliseconds.
+  /// If is_directory is true, changes to the directory and the files directly in it are reported. Otherwise only changes to the file path.
+  /// The subscription ends when the returned object is destroyed, which must also be done in the main GUI thread.
+  std::unique_ptr<Subscription> subscribe(const boost::filesystem::path &path, bool is_directory, std::function<void(std::vector<boost::filesystem::path> &&paths)> on_changed, unsigned delay = 500);
+};
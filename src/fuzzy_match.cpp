@@ -0,0 +1,258 @@
+#include "fuzzy_match.hpp"
+#include <algorithm>
+#include <cstring>
+#include <thread>
+
+namespace {
+  const int score_match = 16;
+  const int score_gap_start = -3;
+  const int score_gap_extension = -1;
+  const int bonus_boundary = score_match / 2;
+  const int bonus_non_word = score_match / 2;
+  const int bonus_camel_case = bonus_boundary + score_gap_extension;
+  const int bonus_consecutive = -(score_gap_start + score_gap_extension);
+  const int bonus_first_character_multiplier = 2;
+
+  /// Number of candidates each thread should at least process when filtering in parallel
+  const size_t parallel_chunk_size = 10000;
+
+  enum class CharacterClass { non_word,
+                              lower,
+                              upper,
+                              number };
+
+  CharacterClass get_character_class(char chr) {
+    if(chr >= 'a' && chr <= 'z')
+      return CharacterClass::lower;
+    if(chr >= 'A' && chr <= 'Z')
+      return CharacterClass::upper;
+    if(chr >= '0' && chr <= '9')
+      return CharacterClass::number;
+    if(static_cast<unsigned char>(chr) >= 128) // Treat UTF-8 bytes as letters
+      return CharacterClass::lower;
+    return CharacterClass::non_word;
+  }
+
+  int get_bonus(CharacterClass previous, CharacterClass current) {
+    if(previous == CharacterClass::non_word && current != CharacterClass::non_word)
+      return bonus_boundary;
+    if((previous == CharacterClass::lower && current == CharacterClass::upper) ||
+       (previous != CharacterClass::number && current == CharacterClass::number))
+      return bonus_camel_case;
+    if(current == CharacterClass::non_word)
+      return bonus_non_word;
+    return 0;
+  }
+
+  char to_lower(char chr) {
+    return chr >= 'A' && chr <= 'Z' ? chr + ('a' - 'A') : chr;
+  }
+
+  uint64_t get_character_bit(char chr) {
+    auto uchr = static_cast<unsigned char>(chr);
+    if(uchr >= 'a' && uchr <= 'z')
+      return uint64_t(1) << (uchr - 'a');
+    if(uchr >= '0' && uchr <= '9')
+      return uint64_t(1) << (26 + uchr - '0');
+    if(uchr >= 128)
+      return uint64_t(1) << 63;
+    return uint64_t(1) << (36 + uchr % 27);
+  }
+
+  uint64_t get_character_mask(const std::string &text_lc) {
+    uint64_t mask = 0;
+    for(auto &chr : text_lc)
+      mask |= get_character_bit(chr);
+    return mask;
+  }
+} // namespace
+
+FuzzyMatch::Candidate::Candidate(const std::string &text_, bool markup) {
+  if(markup) {
+    text.reserve(text_.size());
+    for(size_t i = 0; i < text_.size(); ++i) {
+      if(text_[i] == '<') {
+        auto pos = text_.find('>', i + 1);
+        if(pos == std::string::npos)
+          break;
+        i = pos;
+      }
+      else if(text_[i] == '&') {
+        auto pos = text_.find(';', i + 1);
+        if(pos != std::string::npos) {
+          static const std::vector<std::pair<std::string, char>> entities = {{"amp", '&'}, {"lt", '<'}, {"gt", '>'}, {"quot", '"'}, {"apos", '\''}};
+          auto it = std::find_if(entities.begin(), entities.end(), [&text_, i, pos](const std::pair<std::string, char> &entity) {
+            return text_.compare(i + 1, pos - i - 1, entity.first) == 0;
+          });
+          if(it != entities.end()) {
+            text += it->second;
+            i = pos;
+            continue;
+          }
+        }
+        text += text_[i];
+      }
+      else
+        text += text_[i];
+    }
+  }
+  else
+    text = text_;
+
+  text_lc.resize(text.size());
+  std::transform(text.begin(), text.end(), text_lc.begin(), to_lower);
+  character_mask = get_character_mask(text_lc);
+}
+
+FuzzyMatch::FuzzyMatch(const std::string &query) : query(query) {
+  query_lc.resize(query.size());
+  std::transform(query.begin(), query.end(), query_lc.begin(), to_lower);
+  query_character_mask = get_character_mask(query_lc);
+}
+
+int FuzzyMatch::score(const Candidate &candidate) const {
+  if(query_lc.empty())
+    return 0;
+  if((query_character_mask & ~candidate.character_mask) != 0)
+    return -1;
+
+  auto &text_lc = candidate.text_lc;
+
+  // Find the end of the first match by scanning forward
+  const char *data = text_lc.data();
+  size_t size = text_lc.size();
+  size_t start = std::string::npos, end = 0;
+  size_t pos = 0;
+  for(auto &chr : query_lc) {
+    auto found = static_cast<const char *>(std::memchr(data + pos, chr, size - pos));
+    if(!found)
+      return -1;
+    pos = found - data;
+    if(start == std::string::npos)
+      start = pos;
+    ++pos;
+  }
+  end = pos;
+
+  // Find the shortest match ending at end by scanning backward
+  size_t query_pos = query_lc.size();
+  for(size_t i = end; i > start;) {
+    --i;
+    if(text_lc[i] == query_lc[query_pos - 1]) {
+      --query_pos;
+      if(query_pos == 0) {
+        start = i;
+        break;
+      }
+    }
+  }
+
+  auto &text = candidate.text;
+  int score = 0;
+  int first_bonus = 0;
+  size_t consecutive = 0;
+  bool in_gap = false;
+  auto previous_class = start > 0 ? get_character_class(text[start - 1]) : CharacterClass::non_word;
+  query_pos = 0;
+  for(size_t i = start; i < end; ++i) {
+    auto current_class = get_character_class(text[i]);
+    if(query_pos < query_lc.size() && text_lc[i] == query_lc[query_pos]) {
+      score += score_match;
+      auto bonus = get_bonus(previous_class, current_class);
+      if(consecutive == 0)
+        first_bonus = bonus;
+      else {
+        if(bonus >= bonus_boundary && bonus > first_bonus)
+          first_bonus = bonus;
+        bonus = std::max(std::max(bonus, first_bonus), bonus_consecutive);
+      }
+      score += query_pos == 0 ? bonus * bonus_first_character_multiplier : bonus;
+      in_gap = false;
+      ++consecutive;
+      ++query_pos;
+    }
+    else {
+      score += in_gap ? score_gap_extension : score_gap_start;
+      in_gap = true;
+      consecutive = 0;
+      first_bonus = 0;
+    }
+    previous_class = current_class;
+  }
+  return std::max(score, 0);
+}
+
+bool FuzzyMatch::refines(const std::string &previous_query) const {
+  return query.size() >= previous_query.size() && query.compare(0, previous_query.size(), previous_query) == 0;
+}
+
+std::vector<size_t> FuzzyMatch::filter(const std::vector<Candidate> &candidates, const std::vector<size_t> *subset) const {
+  size_t size = subset ? subset->size() : candidates.size();
+  auto get_index = [subset](size_t i) {
+    return subset ? (*subset)[i] : i;
+  };
+
+  if(query_lc.empty()) {
+    std::vector<size_t> indices;
+    indices.reserve(size);
+    for(size_t i = 0; i < size; ++i)
+      indices.emplace_back(get_index(i));
+    std::sort(indices.begin(), indices.end());
+    return indices;
+  }
+
+  struct Match {
+    int score;
+    size_t index;
+  };
+
+  auto filter_range = [this, &candidates, &get_index](size_t begin, size_t end, std::vector<Match> &matches) {
+    for(size_t i = begin; i < end; ++i) {
+      auto index = get_index(i);
+      auto score = this->score(candidates[index]);
+      if(score >= 0)
+        matches.emplace_back(Match{score, index});
+    }
+  };
+
+  std::vector<Match> matches;
+  size_t threads_count = std::min(static_cast<size_t>(std::max(std::thread::hardware_concurrency(), 1u)), size / parallel_chunk_size);
+  if(threads_count <= 1)
+    filter_range(0, size, matches);
+  else {
+    std::vector<std::vector<Match>> thread_matches(threads_count);
+    std::vector<std::thread> threads;
+    threads.reserve(threads_count);
+    size_t chunk_size = (size + threads_count - 1) / threads_count;
+    for(size_t c = 0; c < threads_count; ++c) {
+      threads.emplace_back([&filter_range, &thread_matches, c, chunk_size, size] {
+        filter_range(c * chunk_size, std::min((c + 1) * chunk_size, size), thread_matches[c]);
+      });
+    }
+    for(auto &thread : threads)
+      thread.join();
+    size_t matches_count = 0;
+    for(auto &chunk_matches : thread_matches)
+      matches_count += chunk_matches.size();
+    matches.reserve(matches_count);
+    for(auto &chunk_matches : thread_matches)
+      matches.insert(matches.end(), chunk_matches.begin(), chunk_matches.end());
+  }
+
+  // Prefer higher scores, then shorter candidates, then original order
+  std::sort(matches.begin(), matches.end(), [&candidates](const Match &lhs, const Match &rhs) {
+    if(lhs.score != rhs.score)
+      return lhs.score > rhs.score;
+    auto lhs_size = candidates[lhs.index].text.size();
+    auto rhs_size = candidates[rhs.index].text.size();
+    if(lhs_size != rhs_size)
+      return lhs_size < rhs_size;
+    return lhs.index < rhs.index;
+  });
+
+  std::vector<size_t> indices;
+  indices.reserve(matches.size());
+  for(auto &match : matches)
+    indices.emplace_back(match.index);
+  return indices;
+}
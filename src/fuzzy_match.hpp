@@ -0,0 +1,40 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/// fzf-style fuzzy matching of a query against a list of candidates
+class FuzzyMatch {
+public:
+  class Candidate {
+  public:
+    /// If markup is true, tags are removed and entities are unescaped before matching
+    Candidate(const std::string &text, bool markup = false);
+
+    /// Plain text, without markup
+    std::string text;
+    /// Lowercase version of text
+    std::string text_lc;
+    /// Characters present in text, used to quickly reject candidates
+    uint64_t character_mask;
+  };
+
+  FuzzyMatch(const std::string &query);
+
+  /// Returns a score that is larger for better matches, or -1 if candidate does not match
+  int score(const Candidate &candidate) const;
+
+  /// Returns true if the candidates matching this query is a subset of the candidates matching previous_query
+  bool refines(const std::string &previous_query) const;
+
+  /// Returns the indices of candidates matching the query, ordered by descending score.
+  /// If subset is given, only these candidate indices are considered.
+  /// Large candidate lists are filtered in parallel.
+  std::vector<size_t> filter(const std::vector<Candidate> &candidates, const std::vector<size_t> *subset = nullptr) const;
+
+  const std::string query;
+
+private:
+  std::string query_lc;
+  uint64_t query_character_mask;
+};
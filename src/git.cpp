@@ -1,4 +1,5 @@
 #include "git.hpp"
+#include "filesystem.hpp"
 #include <cstring>
 #include <unordered_map>
 
@@ -114,21 +115,11 @@ Git::Repository::Repository(const boost::filesystem::path &path) {
   if(work_path.empty())
     throw std::runtime_error("Could not find work path");
 
-  auto git_directory = Gio::File::create_for_path(get_path().string());
-  monitor = git_directory->monitor_directory(Gio::FileMonitorFlags::FILE_MONITOR_WATCH_MOVES);
-  monitor_changed_connection = monitor->signal_changed().connect(
-      [this](const Glib::RefPtr<Gio::File> &file,
-             const Glib::RefPtr<Gio::File> &,
-             Gio::FileMonitorEvent monitor_event) {
-        if(monitor_event != Gio::FileMonitorEvent::FILE_MONITOR_EVENT_CHANGES_DONE_HINT) {
-          this->clear_saved_status();
-        }
+  monitor = FileWatcher::get().subscribe(
+      get_path(), true, [this](std::vector<boost::filesystem::path> &&) {
+        clear_saved_status();
       },
-      false);
-}
-
-Git::Repository::~Repository() {
-  monitor_changed_connection.disconnect();
+      0);
 }
 
 Git::Repository::Status Git::Repository::get_status() {
@@ -236,6 +227,14 @@ std::string Git::Repository::get_branch() noexcept {
   return branch;
 }
 
+bool Git::Repository::is_ignored(const boost::filesystem::path &path) noexcept {
+  auto relative_path = filesystem::get_relative_path(path, work_path).generic_string();
+  int ignored = 0;
+  LockGuard lock(mutex);
+  error.code = git_ignore_path_is_ignored(&ignored, repository.get(), relative_path.c_str());
+  return !error && ignored == 1;
+}
+
 void Git::initialize() noexcept {
   if(!initialized) {
     git_libgit2_init();
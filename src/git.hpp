@@ -1,4 +1,5 @@
 #pragma once
+#include "file_watcher.hpp"
 #include "mutex.hpp"
 #include <boost/filesystem.hpp>
 #include <boost/optional.hpp>
@@ -66,14 +67,12 @@ public:
     std::unique_ptr<git_repository, std::function<void(git_repository *)>> repository;
 
     boost::filesystem::path work_path;
-    sigc::connection monitor_changed_connection;
+    std::unique_ptr<FileWatcher::Subscription> monitor;
     Mutex saved_status_mutex;
     Status saved_status GUARDED_BY(saved_status_mutex);
     bool has_saved_status GUARDED_BY(saved_status_mutex) = false;
 
   public:
-    ~Repository();
-
     Status get_status();
     void clear_saved_status();
 
@@ -85,7 +84,8 @@ public:
 
     std::string get_branch() noexcept;
 
-    Glib::RefPtr<Gio::FileMonitor> monitor;
+    /// Returns true if path is ignored through for instance .gitignore
+    bool is_ignored(const boost::filesystem::path &path) noexcept;
   };
 
 private:
@@ -102,5 +102,7 @@ private:
   static boost::filesystem::path path(const char *cpath, boost::optional<size_t> cpath_length = {}) noexcept REQUIRES(mutex);
 
 public:
+  /// Must be called from main GUI thread. Since a repository owns a FileWatcher subscription,
+  /// the last reference to the repository must also be released in the main GUI thread.
   static std::shared_ptr<Repository> get_repository(const boost::filesystem::path &path);
 };
@@ -2,13 +2,18 @@
 #include "config.hpp"
 #include "dialog.hpp"
 #include "filesystem.hpp"
+#include "json.hpp"
 #include "project_build.hpp"
 #include "terminal.hpp"
+#include "trace.hpp"
 #include "utility.hpp"
 
 Grep::Grep(const boost::filesystem::path &path, const std::string &pattern, bool case_sensitive, bool extended_regex) {
   if(path.empty())
     return;
+  Trace::Span span("Grep");
+  if(Trace::is_recording())
+    span.set_args("\"pattern\":\"" + JSON::escape_string(pattern) + '"');
   auto build = Project::Build::create(path);
   std::string exclude;
   for(auto &exclude_folder : build->get_exclude_folders())
@@ -4,9 +4,12 @@
 #include "filesystem.hpp"
 #include "menu.hpp"
 #include "notebook.hpp"
+#include "startup_profile.hpp"
 #include "terminal.hpp"
+#include "trace.hpp"
 #include "utility.hpp"
 #include "window.hpp"
+#include <cstdlib>
 #ifndef _WIN32
 #include <csignal>
 #endif
@@ -18,6 +21,12 @@
 int Application::on_command_line(const Glib::RefPtr<Gio::ApplicationCommandLine> &cmd) {
   Glib::set_prgname("juci");
   Glib::OptionContext ctx("[PATH ...]");
+  Glib::OptionGroup main_group("juci", "juCi++ options");
+  Glib::OptionEntry startup_profile_entry;
+  startup_profile_entry.set_long_name("startup-profile");
+  startup_profile_entry.set_description("Print the time spent in each startup phase");
+  main_group.add_entry(startup_profile_entry, StartupProfile::print);
+  ctx.set_main_group(main_group);
   Glib::OptionGroup gtk_group(gtk_get_option_group(true));
   ctx.add_group(gtk_group);
   int argc;
@@ -55,11 +64,20 @@ void Application::on_activate() {
   std::vector<std::pair<int, int>> file_offsets;
   boost::filesystem::path current_file;
   Window::get().load_session(directories, files, file_offsets, current_file, directories.empty() && files.empty());
+  StartupProfile::phase("load session");
 
   Window::get().add_widgets();
 
   add_window(Window::get());
   Window::get().show();
+  StartupProfile::phase("show window");
+
+  auto first_draw_connection = std::make_shared<sigc::connection>();
+  *first_draw_connection = Window::get().signal_draw().connect([first_draw_connection](const Cairo::RefPtr<Cairo::Context> &) {
+    first_draw_connection->disconnect();
+    StartupProfile::finish("first frame");
+    return false;
+  });
 
   bool first_directory = true;
   for(auto &directory : directories) {
@@ -85,17 +103,19 @@ void Application::on_activate() {
       another_juci_app.detach();
     }
   }
+  StartupProfile::phase("open directory");
 
   for(size_t i = 0; i < files.size(); ++i) {
-    if(Notebook::get().open(files[i].first, files[i].second == 0 ? Notebook::Position::left : Notebook::Position::right)) {
-      if(i < file_offsets.size()) {
-        auto view = Notebook::get().get_current_view();
-        view->place_cursor_at_line_offset(file_offsets[i].first, file_offsets[i].second);
-        view->scroll_to_cursor_delayed(true, false);
-      }
-    }
+    auto position = files[i].second == 0 ? Notebook::Position::left : Notebook::Position::right;
+    // Files from the last session are opened when their tabs are first activated
+    if(i < file_offsets.size())
+      Notebook::get().add_placeholder(files[i].first, position, file_offsets[i].first, file_offsets[i].second);
+    else
+      Notebook::get().open(files[i].first, position);
   }
 
+  StartupProfile::phase("open files");
+
   for(auto &error : errors)
     Terminal::get().print(std::move(error), true);
 
@@ -108,6 +128,7 @@ void Application::on_activate() {
       view->scroll_to_cursor_delayed(true, false);
     }
   }
+  StartupProfile::phase("open current file");
 
 #ifdef __APPLE__
   static Dispatcher dispatcher;
@@ -129,6 +150,7 @@ void Application::on_startup() {
     set_app_menu(Menu::get().juci_menu);
     set_menubar(Menu::get().window_menu);
   }
+  StartupProfile::phase("build menu");
 }
 
 Application::Application() : Gtk::Application("no.sout.juci", Gio::APPLICATION_NON_UNIQUE | Gio::APPLICATION_HANDLES_COMMAND_LINE) {
@@ -142,5 +164,15 @@ int main(int argc, char *argv[]) {
 #ifndef _WIN32
   signal(SIGPIPE, SIG_IGN); // Do not terminate application when writing to a process fails
 #endif
-  return Application().run(argc, argv);
+  StartupProfile::start();
+  Trace::set_thread_name("main");
+  auto trace_path = std::getenv("JUCI_TRACE");
+  if(trace_path)
+    Trace::start();
+
+  auto exit_status = Application().run(argc, argv);
+
+  if(trace_path && !Trace::write(trace_path))
+    std::cerr << "Error: could not write trace to " << trace_path << std::endl;
+  return exit_status;
 }
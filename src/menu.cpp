@@ -567,6 +567,12 @@ const Glib::ustring menu_xml = R"RAW(<interface>
           <attribute name='action'>app.window_clear_terminal</attribute>
         </item>
       </section>
+      <section>
+        <item>
+          <attribute name='label' translatable='yes'>_Toggle _Trace _Recording</attribute>
+          <attribute name='action'>app.window_toggle_trace_recording</attribute>
+        </item>
+      </section>
     </submenu>
   </menu>
 </interface>
@@ -10,6 +10,9 @@
 #include <future>
 #include <regex>
 
+Mutex Meson::introspections_mutex;
+std::map<boost::filesystem::path, std::shared_ptr<Meson::Introspection>> Meson::introspections;
+
 Meson::Meson(const boost::filesystem::path &path) {
   const auto find_project = [](const boost::filesystem::path &file_path) {
     std::ifstream input(file_path.string(), std::ios::binary);
@@ -127,11 +130,29 @@ bool Meson::update_debug_build(const boost::filesystem::path &debug_build_path,
 }
 
 boost::filesystem::path Meson::get_executable(const boost::filesystem::path &build_path, const boost::filesystem::path &file_path) {
-  CompileCommands compile_commands(build_path);
-
   ssize_t best_match_size = -1;
   boost::filesystem::path best_match_executable;
 
+  if(auto introspection = get_introspection(build_path)) {
+    for(auto &executable : introspection->executables) {
+      for(auto &source_file : executable.sources) {
+        if(source_file == file_path)
+          return executable.path;
+        auto source_file_directory = source_file.parent_path();
+        if(filesystem::file_in_path(file_path, source_file_directory)) {
+          auto size = std::distance(source_file_directory.begin(), source_file_directory.end());
+          if(size > best_match_size) {
+            best_match_size = size;
+            best_match_executable = executable.path;
+          }
+        }
+      }
+    }
+    return best_match_executable;
+  }
+
+  // Older Meson versions do not output intro-targets.json, but executables can be found from the object file paths in compile_commands.json
+  CompileCommands compile_commands(build_path);
   for(auto &command : compile_commands.commands) {
     auto source_file = filesystem::get_normal_path(command.file);
     auto values = command.parameter_values("-o");
@@ -155,36 +176,70 @@ boost::filesystem::path Meson::get_executable(const boost::filesystem::path &bui
     }
   }
 
-  if(best_match_executable.empty()) { // Newer Meson outputs intro-targets.json that can be used to find executable
-    try {
-      JSON targets(build_path / "meson-info" / "intro-targets.json");
-      for(auto &target : targets.array()) {
-        if(target.string("type") == "executable") {
-          auto filenames = target.array("filename");
-          if(filenames.empty()) // No executable file found
-            break;
-          auto executable = filesystem::get_normal_path(filenames.begin()->string());
-          for(auto &target_source : target.array("target_sources")) {
-            for(auto &source : target_source.array("sources")) {
-              auto source_file = filesystem::get_normal_path(source.string());
-              if(source_file == file_path)
-                return executable;
-              auto source_file_directory = source_file.parent_path();
-              if(filesystem::file_in_path(file_path, source_file_directory)) {
-                auto size = std::distance(source_file_directory.begin(), source_file_directory.end());
-                if(size > best_match_size) {
-                  best_match_size = size;
-                  best_match_executable = executable;
-                }
-              }
-            }
-          }
+  return best_match_executable;
+}
+
+std::shared_ptr<Meson::Introspection> Meson::get_introspection(const boost::filesystem::path &build_path) {
+  boost::system::error_code ec;
+  // build.ninja is rewritten each time the build is reconfigured, which is also when the introspection files are updated
+  auto build_ninja_time = boost::filesystem::last_write_time(build_path / "build.ninja", ec);
+  if(ec)
+    build_ninja_time = -1;
+
+  {
+    LockGuard lock(introspections_mutex);
+    auto it = introspections.find(build_path);
+    if(it != introspections.end()) {
+      if(it->second->build_ninja_time == build_ninja_time)
+        return it->second;
+      introspections.erase(it);
+    }
+  }
+
+  auto introspection = read_introspection(build_path, build_ninja_time);
+  if(!introspection)
+    return nullptr;
+  LockGuard lock(introspections_mutex);
+  introspections[build_path] = introspection;
+  return introspection;
+}
+
+std::shared_ptr<Meson::Introspection> Meson::read_introspection(const boost::filesystem::path &build_path, std::time_t build_ninja_time) {
+  boost::system::error_code ec;
+  auto targets_path = build_path / "meson-info" / "intro-targets.json";
+  if(!boost::filesystem::exists(targets_path, ec))
+    return nullptr;
+
+  auto introspection = std::make_shared<Introspection>();
+  introspection->build_ninja_time = build_ninja_time;
+  try {
+    JSON targets(targets_path);
+    for(auto &target : targets.array()) {
+      boost::optional<Introspection::Executable> executable;
+      if(target.string("type") == "executable") {
+        auto filenames = target.array("filename");
+        if(!filenames.empty()) {
+          executable = Introspection::Executable();
+          executable->path = filesystem::get_normal_path(filenames.begin()->string());
         }
       }
-    }
-    catch(...) {
+      for(auto &target_source : target.array("target_sources")) {
+        auto parameters = std::make_shared<std::vector<std::string>>();
+        for(auto &parameter : target_source.array_or_empty("parameters"))
+          parameters->emplace_back(parameter.string());
+        for(auto &source : target_source.array("sources")) {
+          auto source_file = filesystem::get_normal_path(source.string());
+          introspection->parameters.emplace(source_file, parameters);
+          if(executable)
+            executable->sources.emplace_back(std::move(source_file));
+        }
+      }
+      if(executable)
+        introspection->executables.emplace_back(std::move(*executable));
     }
   }
-
-  return best_match_executable;
+  catch(...) {
+    return nullptr;
+  }
+  return introspection;
 }
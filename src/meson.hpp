@@ -1,9 +1,28 @@
 #pragma once
+#include "mutex.hpp"
 #include <boost/filesystem.hpp>
+#include <ctime>
+#include <map>
+#include <memory>
 #include <vector>
 
 class Meson {
 public:
+  /// Targets and compile parameters read from the introspection files of a build directory
+  class Introspection {
+  public:
+    class Executable {
+    public:
+      boost::filesystem::path path;
+      std::vector<boost::filesystem::path> sources;
+    };
+
+    std::time_t build_ninja_time;
+    std::vector<Executable> executables;
+    /// Compile parameters of each source file, excluding the compiler, output and source file
+    std::map<boost::filesystem::path, std::shared_ptr<std::vector<std::string>>> parameters;
+  };
+
   Meson(const boost::filesystem::path &path);
 
   boost::filesystem::path project_path;
@@ -12,4 +31,14 @@ public:
   bool update_debug_build(const boost::filesystem::path &debug_build_path, bool force = false);
 
   boost::filesystem::path get_executable(const boost::filesystem::path &build_path, const boost::filesystem::path &file_path);
+
+  /// Returns nullptr if the build has no introspection files, for instance if it was configured by an older Meson version.
+  /// The introspection files are only read again when build.ninja has changed.
+  static std::shared_ptr<Introspection> get_introspection(const boost::filesystem::path &build_path);
+
+private:
+  static Mutex introspections_mutex;
+  static std::map<boost::filesystem::path, std::shared_ptr<Introspection>> introspections GUARDED_BY(introspections_mutex);
+
+  static std::shared_ptr<Introspection> read_introspection(const boost::filesystem::path &build_path, std::time_t build_ninja_time);
 };
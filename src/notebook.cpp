@@ -9,6 +9,7 @@
 #include "source_generic.hpp"
 #include "source_language_protocol.hpp"
 #include "utility.hpp"
+#include <algorithm>
 #include <fstream>
 #include <gtksourceview-3.0/gtksourceview/gtksourcemap.h>
 #include <regex>
@@ -55,6 +56,12 @@ Notebook::Notebook() : Gtk::Paned(), notebooks(2) {
           break;
         }
       }
+      for(auto &placeholder : placeholders) {
+        if(&placeholder->hbox == hbox) {
+          open_delayed(placeholder.get());
+          break;
+        }
+      }
       last_index.reset();
     });
     notebook.signal_page_added().connect([this](Gtk::Widget *widget, guint) {
@@ -118,8 +125,10 @@ Source::View *Notebook::get_current_view() {
   //In case there exist a tab that has not yet received focus again in a different notebook
   for(int notebook_index = 0; notebook_index < 2; ++notebook_index) {
     auto page = notebooks[notebook_index].get_current_page();
-    if(page >= 0)
-      return get_view(notebook_index, page);
+    if(page >= 0) {
+      if(auto view = get_view(notebook_index, page))
+        return view;
+    }
   }
   return nullptr;
 }
@@ -153,6 +162,13 @@ bool Notebook::open(const boost::filesystem::path &file_path_, Position position
     toggle_split();
 
   // Use canonical path to follow symbolic links
+  if(position != Position::split) {
+    auto canonical_file_path = filesystem::get_canonical_path(file_path);
+    for(auto &placeholder : placeholders) {
+      if(filesystem::get_canonical_path(placeholder->file_path) == canonical_file_path)
+        return open(placeholder.get());
+    }
+  }
   if(position == Position::infer) {
     auto canonical_file_path = filesystem::get_canonical_path(file_path);
     for(size_t c = 0; c < size(); c++) {
@@ -618,6 +634,88 @@ bool Notebook::open(const boost::filesystem::path &file_path_, Position position
   return true;
 }
 
+void Notebook::add_placeholder(const boost::filesystem::path &file_path_, Position position, int line, int line_offset) {
+  auto file_path = filesystem::get_normal_path(file_path_);
+
+  if(position == Position::right && !split)
+    toggle_split();
+
+  placeholders.emplace_back(new Placeholder(file_path, line, line_offset));
+  auto placeholder = placeholders.back().get();
+  placeholder->tab_label.reset(new TabLabel([this, placeholder]() {
+    close(placeholder);
+  }));
+  placeholder->tab_label->label.set_text(file_path.filename().string() + ' ');
+  placeholder->tab_label->set_tooltip_text(filesystem::get_short_path(file_path).string());
+
+  auto &notebook = notebooks[position == Position::right ? 1 : 0];
+  notebook.append_page(placeholder->hbox, *placeholder->tab_label);
+  notebook.set_tab_reorderable(placeholder->hbox, true);
+  notebook.set_tab_detachable(placeholder->hbox, true);
+  placeholder->hbox.show();
+
+  prefetch_thread_pool.push([file_path = std::move(file_path)] {
+    std::ifstream stream(file_path.string(), std::ifstream::binary);
+    std::vector<char> buffer(131072);
+    while(stream.read(buffer.data(), buffer.size())) {
+    }
+  });
+}
+
+bool Notebook::open(Placeholder *placeholder_) {
+  auto it = std::find_if(placeholders.begin(), placeholders.end(), [placeholder_](const std::unique_ptr<Placeholder> &placeholder) {
+    return placeholder.get() == placeholder_;
+  });
+  if(it == placeholders.end())
+    return false;
+  auto notebook_page = get_notebook_page(placeholder_);
+  auto placeholder = std::move(*it);
+  placeholders.erase(it);
+
+  auto &notebook = notebooks[notebook_page.first];
+  if(!open(placeholder->file_path, notebook_page.first == 0 ? Position::left : Position::right)) {
+    notebook.remove_page(placeholder->hbox);
+    return false;
+  }
+  // The new view is the current page, so removing the placeholder does not switch page
+  notebook.remove_page(placeholder->hbox);
+  notebook.reorder_child(*hboxes.back(), notebook_page.second);
+
+  auto view = source_views.back();
+  view->place_cursor_at_line_offset(placeholder->line, placeholder->line_offset);
+  view->scroll_to_cursor_delayed(true, false);
+  return true;
+}
+
+void Notebook::open_delayed(Placeholder *placeholder) {
+  if(placeholder->delayed_open_connection.connected())
+    return;
+  placeholder->delayed_open_connection = Glib::signal_idle().connect([this, placeholder] {
+    auto notebook_page = get_notebook_page(placeholder);
+    if(notebooks[notebook_page.first].get_current_page() == notebook_page.second)
+      open(placeholder);
+    return false;
+  });
+}
+
+void Notebook::close(Placeholder *placeholder) {
+  for(auto it = placeholders.begin(); it != placeholders.end(); ++it) {
+    if(it->get() == placeholder) {
+      auto notebook_page = get_notebook_page(placeholder);
+      notebooks[notebook_page.first].remove_page(notebook_page.second);
+      placeholders.erase(it);
+      return;
+    }
+  }
+}
+
+void Notebook::close_placeholders(const boost::filesystem::path &path) {
+  for(size_t c = placeholders.size() - 1; c != static_cast<size_t>(-1); --c) {
+    if(path.empty() || filesystem::file_in_path(placeholders[c]->file_path, path))
+      close(placeholders[c].get());
+  }
+}
+
 void Notebook::install_rust() {
   static bool show_dialog = true;
   if(show_dialog) {
@@ -736,12 +834,19 @@ bool Notebook::close(size_t index) {
       }
       if(!focused) {
         auto notebook_page = get_notebook_page(view);
-        if(notebook_page.second > 0)
-          focus_view(get_view(notebook_page.first, notebook_page.second - 1));
+        if(notebook_page.second > 0) {
+          if(auto previous_view = get_view(notebook_page.first, notebook_page.second - 1))
+            focus_view(previous_view);
+          else {
+            set_current_view(nullptr);
+            notebooks[notebook_page.first].set_current_page(notebook_page.second - 1); // Opens placeholder
+          }
+        }
         else {
           size_t notebook_index = notebook_page.first == 0 ? 1 : 0;
-          if(notebooks[notebook_index].get_n_pages() > 0)
-            focus_view(get_view(notebook_index, notebooks[notebook_index].get_current_page()));
+          auto page = notebooks[notebook_index].get_current_page();
+          if(auto other_view = page >= 0 ? get_view(notebook_index, page) : nullptr)
+            focus_view(other_view);
           else
             set_current_view(nullptr);
         }
@@ -846,6 +951,10 @@ void Notebook::toggle_split() {
         200);
   }
   else {
+    for(size_t c = placeholders.size() - 1; c != static_cast<size_t>(-1); --c) {
+      if(get_notebook_page(placeholders[c].get()).first == 1)
+        close(placeholders[c].get());
+    }
     for(size_t c = size() - 1; c != static_cast<size_t>(-1); --c) {
       if(get_notebook_page(c).first == 1 && !close(c))
         return;
@@ -855,13 +964,26 @@ void Notebook::toggle_split() {
   split = !split;
 }
 
-std::vector<std::pair<size_t, Source::View *>> Notebook::get_notebook_views() {
-  std::vector<std::pair<size_t, Source::View *>> notebook_views;
+std::vector<Notebook::TabLocation> Notebook::get_tab_locations() {
+  std::vector<TabLocation> tab_locations;
   for(size_t notebook_index = 0; notebook_index < notebooks.size(); ++notebook_index) {
-    for(int page = 0; page < notebooks[notebook_index].get_n_pages(); ++page)
-      notebook_views.emplace_back(notebook_index, get_view(notebook_index, page));
+    for(int page = 0; page < notebooks[notebook_index].get_n_pages(); ++page) {
+      if(auto view = get_view(notebook_index, page)) {
+        auto iter = view->get_buffer()->get_insert()->get_iter();
+        tab_locations.emplace_back(TabLocation{notebook_index, view->file_path, iter.get_line(), iter.get_line_offset()});
+      }
+      else {
+        auto widget = notebooks[notebook_index].get_nth_page(page);
+        for(auto &placeholder : placeholders) {
+          if(&placeholder->hbox == widget) {
+            tab_locations.emplace_back(TabLocation{notebook_index, placeholder->file_path, placeholder->line, placeholder->line_offset});
+            break;
+          }
+        }
+      }
+    }
   }
-  return notebook_views;
+  return tab_locations;
 }
 
 void Notebook::update_status(Source::BaseView *view) {
@@ -892,7 +1014,10 @@ Source::View *Notebook::get_view(size_t notebook_index, int page) {
   if(!widget)
     throw std::out_of_range("page number out of bounds");
   auto hbox = dynamic_cast<Gtk::Box *>(widget);
-  auto scrolled_window = dynamic_cast<Gtk::ScrolledWindow *>(hbox->get_children()[0]);
+  auto children = hbox->get_children();
+  if(children.empty()) // Placeholder
+    return nullptr;
+  auto scrolled_window = dynamic_cast<Gtk::ScrolledWindow *>(children[0]);
   return dynamic_cast<Source::View *>(scrolled_window->get_children()[0]);
 }
 
@@ -922,6 +1047,15 @@ std::pair<size_t, int> Notebook::get_notebook_page(Source::View *view) {
   return get_notebook_page(get_index(view));
 }
 
+std::pair<size_t, int> Notebook::get_notebook_page(Placeholder *placeholder) {
+  for(size_t c = 0; c < notebooks.size(); ++c) {
+    auto page_num = notebooks[c].page_num(placeholder->hbox);
+    if(page_num >= 0)
+      return {c, page_num};
+  }
+  throw std::out_of_range("placeholder not found");
+}
+
 void Notebook::set_current_view(Source::View *view) {
   intermediate_view = nullptr;
   if(current_view != view) {
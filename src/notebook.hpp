@@ -16,6 +16,18 @@ class Notebook : public Gtk::Paned {
     Gtk::Label label;
   };
 
+  /// Tab that only holds a path and cursor position until it is first activated
+  class Placeholder {
+  public:
+    Placeholder(boost::filesystem::path file_path, int line, int line_offset) : file_path(std::move(file_path)), line(line), line_offset(line_offset) {}
+    ~Placeholder() { delayed_open_connection.disconnect(); }
+    boost::filesystem::path file_path;
+    int line, line_offset;
+    Gtk::Box hbox;
+    std::unique_ptr<TabLabel> tab_label;
+    sigc::connection delayed_open_connection;
+  };
+
   class CursorLocation {
   public:
     CursorLocation(Source::View *view, const Gtk::TextIter &iter) : view(view), mark(iter, false) {}
@@ -45,6 +57,11 @@ public:
   };
   bool open(Source::View *view);
   bool open(const boost::filesystem::path &file_path, Position position = Position::infer);
+  /// Adds a tab that is opened when it is first activated, used when restoring sessions with many files.
+  /// Position must be left or right.
+  void add_placeholder(const boost::filesystem::path &file_path, Position position, int line, int line_offset);
+  /// Closes the placeholder tabs of files in the given path, or all placeholder tabs if path is empty
+  void close_placeholders(const boost::filesystem::path &path = {});
   void install_rust();
   void open_uri(const std::string &uri);
   void configure(size_t index);
@@ -56,7 +73,16 @@ public:
   void next();
   void previous();
   void toggle_split();
-  std::vector<std::pair<size_t, Source::View *>> get_notebook_views();
+
+  class TabLocation {
+  public:
+    size_t notebook_index;
+    boost::filesystem::path file_path;
+    int line;
+    int line_offset;
+  };
+  /// Returns the tabs in order, including placeholder tabs
+  std::vector<TabLocation> get_tab_locations();
 
   Gtk::Label status_location;
   Gtk::Label status_file_path;
@@ -77,7 +103,7 @@ public:
   void delete_cursor_locations(Source::View *view);
 
 private:
-  /// Throws on out of bounds arguments
+  /// Throws on out of bounds arguments. Returns nullptr for placeholder tabs.
   Source::View *get_view(size_t notebook_index, int page);
   void focus_view(Source::View *view);
   /// Throws if view is not found
@@ -86,6 +112,8 @@ private:
   std::pair<size_t, int> get_notebook_page(size_t index);
   /// Throws if view is not found
   std::pair<size_t, int> get_notebook_page(Source::View *view);
+  /// Throws if placeholder is not found
+  std::pair<size_t, int> get_notebook_page(Placeholder *placeholder);
 
   std::vector<Source::View *> source_views; //Is NOT freed in destructor, this is intended for quick program exit.
   std::vector<std::unique_ptr<Gtk::Widget>> source_maps;
@@ -93,6 +121,15 @@ private:
   std::vector<std::unique_ptr<Gtk::Box>> hboxes;
   std::vector<std::unique_ptr<TabLabel>> tab_labels;
 
+  std::vector<std::unique_ptr<Placeholder>> placeholders;
+  /// Reads the files of placeholder tabs in the background, so that their content is in the file system cache when opened
+  Glib::ThreadPool prefetch_thread_pool;
+  /// Replaces the placeholder tab with a view
+  bool open(Placeholder *placeholder);
+  /// Opens the placeholder after pending events if its tab is still the current page
+  void open_delayed(Placeholder *placeholder);
+  void close(Placeholder *placeholder);
+
   bool split = false;
   boost::optional<size_t> last_index;
 
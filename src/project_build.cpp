@@ -6,6 +6,9 @@
 #include <boost/algorithm/string.hpp>
 #include <regex>
 
+Mutex Project::Build::cache_mutex;
+std::map<boost::filesystem::path, Project::Build::CacheEntry> Project::Build::cache;
+
 std::unique_ptr<Project::Build> Project::Build::create(const boost::filesystem::path &path) {
   if(path.empty())
     return std::make_unique<Project::Build>();
@@ -13,6 +16,82 @@ std::unique_ptr<Project::Build> Project::Build::create(const boost::filesystem::
   boost::system::error_code ec;
   auto search_path = boost::filesystem::is_directory(path, ec) ? path : path.parent_path();
 
+  auto now = std::chrono::steady_clock::now();
+  {
+    LockGuard lock(cache_mutex);
+    auto it = cache.find(search_path);
+    if(it != cache.end() && it->second.default_build_path == Config::get().project.default_build_path) {
+      auto &entry = it->second;
+      if(now - entry.last_validated < std::chrono::seconds(1))
+        return entry.build->clone();
+      bool valid = true;
+      for(auto &dependency : entry.dependencies) {
+        auto last_write_time = boost::filesystem::last_write_time(dependency.first, ec);
+        // Last write times have a resolution of one second, so changes made in the second of the resolution might not be visible
+        if((ec ? static_cast<std::time_t>(-1) : last_write_time) != dependency.second || dependency.second + 1 >= entry.resolve_time) {
+          valid = false;
+          break;
+        }
+      }
+      if(valid) {
+        entry.last_validated = now;
+        return entry.build->clone();
+      }
+      cache.erase(it);
+    }
+  }
+
+  // Dependencies are read before resolving, so that changes made while resolving are detected later
+  auto resolve_time = std::time(nullptr);
+  auto dependencies = get_dependencies(search_path);
+  auto build = create_uncached(path, search_path);
+
+  LockGuard lock(cache_mutex);
+  auto &entry = cache[search_path];
+  entry.build = build->clone();
+  entry.default_build_path = Config::get().project.default_build_path;
+  entry.dependencies = std::move(dependencies);
+  entry.resolve_time = resolve_time;
+  entry.last_validated = now;
+  return build;
+}
+
+void Project::Build::clear_cache() {
+  LockGuard lock(cache_mutex);
+  cache.clear();
+}
+
+std::vector<std::pair<boost::filesystem::path, std::time_t>> Project::Build::get_dependencies(const boost::filesystem::path &search_path_) {
+  std::vector<std::pair<boost::filesystem::path, std::time_t>> dependencies;
+  auto add_dependency = [&dependencies](boost::filesystem::path path) {
+    boost::system::error_code ec;
+    auto last_write_time = boost::filesystem::last_write_time(path, ec);
+    dependencies.emplace_back(std::move(path), ec ? static_cast<std::time_t>(-1) : last_write_time);
+  };
+
+  // Adding or removing build files changes the last write time of their directory,
+  // while editing CMakeLists.txt or meson.build, for instance their project() call, changes the files themselves
+  auto search_path = search_path_;
+  while(true) {
+    add_dependency(search_path);
+    add_dependency(search_path / Config::get().project.default_build_path);
+    boost::system::error_code ec;
+    if(boost::filesystem::exists(search_path / "CMakeLists.txt", ec))
+      add_dependency(search_path / "CMakeLists.txt");
+    if(boost::filesystem::exists(search_path / "meson.build", ec))
+      add_dependency(search_path / "meson.build");
+
+    if(search_path == search_path.root_directory() || !search_path.has_parent_path())
+      break;
+    search_path = search_path.parent_path();
+  }
+  return dependencies;
+}
+
+std::unique_ptr<Project::Build> Project::Build::create_uncached(const boost::filesystem::path &path, const boost::filesystem::path &search_path_) {
+  boost::system::error_code ec;
+  auto search_path = search_path_;
+
   while(true) {
     if(boost::filesystem::exists(search_path / "CMakeLists.txt", ec)) {
       std::unique_ptr<Project::Build> build(new CMakeBuild(path));
@@ -22,7 +101,7 @@ std::unique_ptr<Project::Build> Project::Build::create(const boost::filesystem::
         return std::make_unique<Project::Build>();
     }
 
-    if(boost::filesystem::exists(search_path / "meson.build"), ec) {
+    if(boost::filesystem::exists(search_path / "meson.build", ec)) {
       std::unique_ptr<Project::Build> build(new MesonBuild(path));
       if(!build->project_path.empty())
         return build;
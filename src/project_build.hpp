@@ -1,7 +1,11 @@
 #pragma once
 #include "cmake.hpp"
 #include "meson.hpp"
+#include "mutex.hpp"
 #include <boost/filesystem.hpp>
+#include <chrono>
+#include <ctime>
+#include <map>
 
 namespace Project {
   class Build {
@@ -23,7 +27,30 @@ namespace Project {
 
     std::vector<std::string> get_exclude_folders();
 
+    /// Returns a copy of this build, with the same build system and project path
+    virtual std::unique_ptr<Build> clone() const { return std::make_unique<Build>(*this); }
+
+    /// The build system of a directory is resolved once, and then reused until the directory
+    /// or one of its parent directories change. Changes are checked at most once per second.
     static std::unique_ptr<Build> create(const boost::filesystem::path &path);
+    /// Resolve build systems again, for instance after a build file has been created
+    static void clear_cache();
+
+  private:
+    class CacheEntry {
+    public:
+      std::unique_ptr<Build> build;
+      std::string default_build_path;
+      /// Directories and build files that the resolution depends on, with their last write times
+      std::vector<std::pair<boost::filesystem::path, std::time_t>> dependencies;
+      std::time_t resolve_time;
+      std::chrono::steady_clock::time_point last_validated;
+    };
+    static Mutex cache_mutex;
+    static std::map<boost::filesystem::path, CacheEntry> cache GUARDED_BY(cache_mutex);
+
+    static std::unique_ptr<Build> create_uncached(const boost::filesystem::path &path, const boost::filesystem::path &search_path);
+    static std::vector<std::pair<boost::filesystem::path, std::time_t>> get_dependencies(const boost::filesystem::path &search_path);
   };
 
   class CMakeBuild : public Build {
@@ -32,6 +59,8 @@ namespace Project {
   public:
     CMakeBuild(const boost::filesystem::path &path);
 
+    std::unique_ptr<Build> clone() const override { return std::make_unique<CMakeBuild>(*this); }
+
     bool update_default(bool force = false) override;
     bool update_debug(bool force = false) override;
 
@@ -47,6 +76,8 @@ namespace Project {
   public:
     MesonBuild(const boost::filesystem::path &path);
 
+    std::unique_ptr<Build> clone() const override { return std::make_unique<MesonBuild>(*this); }
+
     bool update_default(bool force = false) override;
     bool update_debug(bool force = false) override;
 
@@ -58,10 +89,13 @@ namespace Project {
 
   class CompileCommandsBuild : public Build {
   public:
+    std::unique_ptr<Build> clone() const override { return std::make_unique<CompileCommandsBuild>(*this); }
   };
 
   class CargoBuild : public Build {
   public:
+    std::unique_ptr<Build> clone() const override { return std::make_unique<CargoBuild>(*this); }
+
     boost::filesystem::path get_default_path() override { return project_path / "target" / "debug"; }
     bool update_default(bool force = false) override;
     boost::filesystem::path get_debug_path() override { return get_default_path(); }
@@ -72,11 +106,17 @@ namespace Project {
   };
 
   class NpmBuild : public Build {
+  public:
+    std::unique_ptr<Build> clone() const override { return std::make_unique<NpmBuild>(*this); }
   };
 
   class PythonMain : public Build {
+  public:
+    std::unique_ptr<Build> clone() const override { return std::make_unique<PythonMain>(*this); }
   };
 
   class GoBuild : public Build {
+  public:
+    std::unique_ptr<Build> clone() const override { return std::make_unique<GoBuild>(*this); }
   };
 } // namespace Project
@@ -0,0 +1,237 @@
+#include "project_files.hpp"
+#include "filesystem.hpp"
+#include "utility.hpp"
+#include <algorithm>
+
+namespace {
+  /// Avoid using too many file monitors in large projects
+  const size_t max_monitored_directories = 1000;
+} // namespace
+
+ProjectFiles::ProjectFiles(const boost::filesystem::path &project_path, const std::vector<std::string> &exclude_folders)
+    : project_path(project_path), exclude_folders(exclude_folders), crawl_thread_pool(1) {
+  try {
+    repository = Git::get_repository(project_path);
+  }
+  catch(const std::exception &) {
+  }
+  start_crawl();
+}
+
+ProjectFiles::~ProjectFiles() {
+  stop = true;
+  crawl_thread_pool.shutdown(true);
+  dispatcher.disconnect();
+}
+
+std::shared_ptr<ProjectFiles> ProjectFiles::get(const boost::filesystem::path &project_path, const std::vector<std::string> &exclude_folders) {
+  static std::unordered_map<std::string, std::shared_ptr<ProjectFiles>> cache;
+
+  auto it = cache.find(project_path.string());
+  if(it != cache.end() && it->second->exclude_folders == exclude_folders) {
+    if(it->second->unmonitored_directories > 0 && !it->second->crawling)
+      it->second->start_crawl(); // Not all directories are monitored, so the file list might be outdated
+    return it->second;
+  }
+  auto project_files = std::shared_ptr<ProjectFiles>(new ProjectFiles(project_path, exclude_folders));
+  cache[project_path.string()] = project_files;
+  return project_files;
+}
+
+bool ProjectFiles::is_ready() {
+  LockGuard lock(mutex);
+  return ready;
+}
+
+std::vector<std::string> ProjectFiles::get_files() {
+  LockGuard lock(mutex);
+  return files;
+}
+
+void ProjectFiles::start_crawl() {
+  unmonitored_directories = 0;
+  crawling = true;
+  {
+    LockGuard lock(mutex);
+    crawl_changes.clear();
+    record_crawl_changes = true;
+  }
+  crawl_thread_pool.push([this] {
+    std::vector<std::string> files;
+    std::vector<boost::filesystem::path> directories;
+    crawl(project_path, files, directories);
+    crawling = false;
+    if(stop)
+      return;
+    std::sort(files.begin(), files.end());
+    {
+      LockGuard lock(mutex);
+      this->files = std::move(files);
+      for(auto &change : crawl_changes) {
+        if(change.second)
+          remove_path(change.first);
+        else
+          add_file(change.first);
+      }
+      crawl_changes.clear();
+      record_crawl_changes = false;
+      ready = true;
+    }
+    dispatcher.post([this, directories = std::move(directories)] {
+      monitor_directories(directories);
+      if(on_changed)
+        on_changed();
+    });
+  });
+}
+
+void ProjectFiles::start_crawl(const boost::filesystem::path &directory) {
+  crawl_thread_pool.push([this, directory] {
+    std::vector<std::string> new_files;
+    std::vector<boost::filesystem::path> new_directories;
+    crawl(directory, new_files, new_directories);
+    if(stop)
+      return;
+    {
+      LockGuard lock(mutex);
+      for(auto &file : new_files)
+        add_file(file);
+    }
+    dispatcher.post([this, new_directories = std::move(new_directories)] {
+      monitor_directories(new_directories);
+      if(on_changed)
+        on_changed();
+    });
+  });
+}
+
+void ProjectFiles::crawl(const boost::filesystem::path &directory, std::vector<std::string> &files, std::vector<boost::filesystem::path> &directories) {
+  std::vector<boost::filesystem::path> current_directories = {directory};
+  while(!current_directories.empty() && !stop) {
+    directories.insert(directories.end(), current_directories.begin(), current_directories.end());
+
+    auto threads_count = std::min(static_cast<size_t>(std::max(std::thread::hardware_concurrency(), 1u)), current_directories.size());
+    std::vector<std::vector<std::string>> thread_files(threads_count);
+    std::vector<std::vector<boost::filesystem::path>> thread_subdirectories(threads_count);
+    std::atomic<size_t> next_directory = {0};
+    auto read_directories = [&](size_t thread_index) {
+      size_t index;
+      while((index = next_directory++) < current_directories.size() && !stop)
+        read_directory(current_directories[index], thread_files[thread_index], thread_subdirectories[thread_index]);
+    };
+    std::vector<std::thread> threads;
+    for(size_t thread_index = 1; thread_index < threads_count; ++thread_index)
+      threads.emplace_back(read_directories, thread_index);
+    read_directories(0);
+    for(auto &thread : threads)
+      thread.join();
+
+    current_directories.clear();
+    for(size_t thread_index = 0; thread_index < threads_count; ++thread_index) {
+      std::move(thread_files[thread_index].begin(), thread_files[thread_index].end(), std::back_inserter(files));
+      std::move(thread_subdirectories[thread_index].begin(), thread_subdirectories[thread_index].end(), std::back_inserter(current_directories));
+    }
+  }
+}
+
+void ProjectFiles::read_directory(const boost::filesystem::path &directory, std::vector<std::string> &files, std::vector<boost::filesystem::path> &subdirectories) {
+  boost::system::error_code ec;
+  for(boost::filesystem::directory_iterator it(directory, ec), end; it != end; it.increment(ec)) {
+    if(ec)
+      break;
+    auto &path = it->path();
+    if(boost::filesystem::is_directory(it->symlink_status(ec))) { // Do not follow symbolic links to directories
+      if(!is_excluded(path, true))
+        subdirectories.emplace_back(path);
+    }
+    else if(boost::filesystem::is_regular_file(it->status(ec))) {
+      if(!is_excluded(path, false))
+        files.emplace_back(get_relative_path(path));
+    }
+  }
+}
+
+bool ProjectFiles::is_excluded(const boost::filesystem::path &path, bool is_directory) {
+  if(is_directory) {
+    auto filename = path.filename();
+    if(std::any_of(exclude_folders.begin(), exclude_folders.end(), [&filename](const std::string &exclude_folder) {
+         return filename == exclude_folder;
+       }))
+      return true;
+  }
+  return repository && repository->is_ignored(path);
+}
+
+std::string ProjectFiles::get_relative_path(const boost::filesystem::path &path) {
+  return filesystem::get_relative_path(path, project_path).string();
+}
+
+void ProjectFiles::monitor_directories(const std::vector<boost::filesystem::path> &directories) {
+  for(auto &directory : directories) {
+    if(monitors.size() >= max_monitored_directories) {
+      ++unmonitored_directories;
+      continue;
+    }
+    if(monitors.count(directory.string()))
+      continue;
+    auto monitor = FileWatcher::get().subscribe(
+        directory, true, [this](std::vector<boost::filesystem::path> &&paths) {
+          for(auto &path : paths)
+            on_file_changed(path);
+        },
+        100);
+    monitors.emplace(directory.string(), std::move(monitor));
+  }
+}
+
+void ProjectFiles::on_file_changed(const boost::filesystem::path &path) {
+  if(!filesystem::file_in_path(path, project_path))
+    return;
+  auto relative_path = get_relative_path(path);
+  boost::system::error_code ec;
+  auto status = boost::filesystem::symlink_status(path, ec);
+
+  if(boost::filesystem::is_directory(status)) {
+    if(monitors.count(path.string()) || is_excluded(path, true))
+      return;
+    start_crawl(path);
+  }
+  else if(boost::filesystem::exists(status)) {
+    if(!boost::filesystem::is_regular_file(boost::filesystem::status(path, ec)) || is_excluded(path, false))
+      return;
+    LockGuard lock(mutex);
+    add_file(relative_path);
+    if(record_crawl_changes)
+      crawl_changes.emplace_back(relative_path, false);
+  }
+  else { // Removed file or directory
+    for(auto it = monitors.begin(); it != monitors.end();) {
+      if(filesystem::file_in_path(it->first, path))
+        it = monitors.erase(it);
+      else
+        ++it;
+    }
+    LockGuard lock(mutex);
+    remove_path(relative_path);
+    if(record_crawl_changes)
+      crawl_changes.emplace_back(relative_path, true);
+  }
+}
+
+void ProjectFiles::add_file(const std::string &relative_path) {
+  auto it = std::lower_bound(files.begin(), files.end(), relative_path);
+  if(it == files.end() || *it != relative_path)
+    files.insert(it, relative_path);
+}
+
+void ProjectFiles::remove_path(const std::string &relative_path) {
+  auto it = std::lower_bound(files.begin(), files.end(), relative_path);
+  if(it != files.end() && *it == relative_path)
+    files.erase(it);
+  auto prefix = relative_path + '/';
+  auto start = std::lower_bound(files.begin(), files.end(), prefix);
+  auto end = start;
+  while(end != files.end() && starts_with(*end, prefix))
+    ++end;
+  files.erase(start, end);
+}
@@ -0,0 +1,75 @@
+#pragma once
+#include "dispatcher.hpp"
+#include "file_watcher.hpp"
+#include "git.hpp"
+#include "mutex.hpp"
+#include <atomic>
+#include <boost/filesystem.hpp>
+#include <functional>
+#include <glibmm.h>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+/// List of the files in a project, built by a background crawler and kept up to date through file monitors.
+/// All crawls, including those of new directories, are done in the crawler thread.
+class ProjectFiles {
+  ProjectFiles(const boost::filesystem::path &project_path, const std::vector<std::string> &exclude_folders);
+
+public:
+  ~ProjectFiles();
+
+  /// Returns the file list of the given project, and starts building it in the background if needed.
+  /// Must be called from main GUI thread.
+  static std::shared_ptr<ProjectFiles> get(const boost::filesystem::path &project_path, const std::vector<std::string> &exclude_folders);
+
+  /// Returns true if the initial crawl is finished
+  bool is_ready();
+  /// Returns paths relative to project_path, sorted
+  std::vector<std::string> get_files();
+
+  /// Called in the main GUI thread when a crawl has updated the file list
+  std::function<void()> on_changed;
+
+  const boost::filesystem::path project_path;
+  const std::vector<std::string> exclude_folders;
+
+private:
+  Mutex mutex;
+  bool ready GUARDED_BY(mutex) = false;
+  std::vector<std::string> files GUARDED_BY(mutex);
+  /// Files added (false) or paths removed (true) while a full crawl is running, in the order they happened.
+  /// Applied to the crawl result, since the crawler might have read the directories before these changes.
+  std::vector<std::pair<std::string, bool>> crawl_changes GUARDED_BY(mutex);
+  bool record_crawl_changes GUARDED_BY(mutex) = false;
+
+  std::shared_ptr<Git::Repository> repository;
+  Dispatcher dispatcher;
+  /// Runs one crawl at a time, in the order they were started
+  Glib::ThreadPool crawl_thread_pool;
+  std::atomic<bool> crawling = {false};
+  std::atomic<bool> stop = {false};
+
+  /// Number of directories that are not monitored. If larger than 0, the project is crawled again on the next get().
+  size_t unmonitored_directories = 0;
+  std::unordered_map<std::string, std::unique_ptr<FileWatcher::Subscription>> monitors;
+
+  void start_crawl();
+  /// Adds the files in a new directory to the file list
+  void start_crawl(const boost::filesystem::path &directory);
+  /// Returns files (relative to project_path) and directories in the given directory and its subdirectories.
+  /// Directories are read in parallel.
+  void crawl(const boost::filesystem::path &directory, std::vector<std::string> &files, std::vector<boost::filesystem::path> &directories);
+  void read_directory(const boost::filesystem::path &directory, std::vector<std::string> &files, std::vector<boost::filesystem::path> &subdirectories);
+  bool is_excluded(const boost::filesystem::path &path, bool is_directory);
+  std::string get_relative_path(const boost::filesystem::path &path);
+
+  void add_file(const std::string &relative_path) REQUIRES(mutex);
+  /// Removes the given file, or all the files in the given directory
+  void remove_path(const std::string &relative_path) REQUIRES(mutex);
+
+  /// Must be called from main GUI thread
+  void monitor_directories(const std::vector<boost::filesystem::path> &directories);
+  /// Must be called from main GUI thread
+  void on_file_changed(const boost::filesystem::path &path);
+};
@@ -1,15 +1,170 @@
 #include "selection_dialog.hpp"
+#include "utility.hpp"
 #include <algorithm>
 
+SelectionDialogBase::ListViewText::Model::Model() : Glib::ObjectBase(typeid(Model)), Glib::Object() {}
+
+void SelectionDialogBase::ListViewText::Model::append(const std::string &text) {
+  buffer += text;
+  row_ends.emplace_back(buffer.size());
+}
+
+void SelectionDialogBase::ListViewText::Model::clear() {
+  buffer.clear();
+  buffer.shrink_to_fit();
+  row_ends.clear();
+  row_ends.shrink_to_fit();
+  all_rows_visible_ = true;
+  visible_rows.clear();
+  visible_rows.shrink_to_fit();
+  invalidate_iterators();
+}
+
+std::string SelectionDialogBase::ListViewText::Model::get_text(unsigned int index) const {
+  auto start = index > 0 ? row_ends[index - 1] : 0;
+  return buffer.substr(start, row_ends[index] - start);
+}
+
+unsigned int SelectionDialogBase::ListViewText::Model::get_longest_row() const {
+  unsigned int longest_row = 0;
+  size_t longest_size = 0;
+  size_t start = 0;
+  for(unsigned int index = 0; index < row_ends.size(); ++index) {
+    if(row_ends[index] - start > longest_size) {
+      longest_size = row_ends[index] - start;
+      longest_row = index;
+    }
+    start = row_ends[index];
+  }
+  return longest_row;
+}
+
+void SelectionDialogBase::ListViewText::Model::set_visible_rows(std::vector<unsigned int> indices) {
+  all_rows_visible_ = false;
+  visible_rows = std::move(indices);
+  invalidate_iterators();
+}
+
+void SelectionDialogBase::ListViewText::Model::set_all_rows_visible() {
+  all_rows_visible_ = true;
+  visible_rows.clear();
+  invalidate_iterators();
+}
+
+Gtk::TreeModelFlags SelectionDialogBase::ListViewText::Model::get_flags_vfunc() const {
+  return Gtk::TreeModelFlags::TREE_MODEL_LIST_ONLY;
+}
+
+int SelectionDialogBase::ListViewText::Model::get_n_columns_vfunc() const {
+  return 2;
+}
+
+GType SelectionDialogBase::ListViewText::Model::get_column_type_vfunc(int index) const {
+  if(index == 0)
+    return Glib::Value<std::string>::value_type();
+  return Glib::Value<unsigned int>::value_type();
+}
+
+void SelectionDialogBase::ListViewText::Model::get_value_vfunc(const iterator &iter, int column, Glib::ValueBase &value) const {
+  auto position = get_position(iter);
+  if(position < 0)
+    return;
+  auto index = get_index(position);
+  if(column == 0) {
+    Glib::Value<std::string> text_value;
+    text_value.init(Glib::Value<std::string>::value_type());
+    text_value.set(get_text(index));
+    value.init(Glib::Value<std::string>::value_type());
+    value = text_value;
+  }
+  else if(column == 1) {
+    Glib::Value<unsigned int> index_value;
+    index_value.init(Glib::Value<unsigned int>::value_type());
+    index_value.set(index);
+    value.init(Glib::Value<unsigned int>::value_type());
+    value = index_value;
+  }
+}
+
+bool SelectionDialogBase::ListViewText::Model::iter_next_vfunc(const iterator &iter, iterator &iter_next) const {
+  auto position = get_position(iter);
+  return set_iter(iter_next, position < 0 ? -1 : position + 1);
+}
+
+bool SelectionDialogBase::ListViewText::Model::iter_children_vfunc(const iterator &parent, iterator &iter) const {
+  return set_iter(iter, -1);
+}
+
+bool SelectionDialogBase::ListViewText::Model::iter_has_child_vfunc(const iterator &iter) const {
+  return false;
+}
+
+int SelectionDialogBase::ListViewText::Model::iter_n_children_vfunc(const iterator &iter) const {
+  return 0;
+}
+
+int SelectionDialogBase::ListViewText::Model::iter_n_root_children_vfunc() const {
+  return visible_size();
+}
+
+bool SelectionDialogBase::ListViewText::Model::iter_nth_child_vfunc(const iterator &parent, int n, iterator &iter) const {
+  return set_iter(iter, -1);
+}
+
+bool SelectionDialogBase::ListViewText::Model::iter_nth_root_child_vfunc(int n, iterator &iter) const {
+  return set_iter(iter, n);
+}
+
+bool SelectionDialogBase::ListViewText::Model::iter_parent_vfunc(const iterator &child, iterator &iter) const {
+  return set_iter(iter, -1);
+}
+
+Gtk::TreeModel::Path SelectionDialogBase::ListViewText::Model::get_path_vfunc(const iterator &iter) const {
+  Path path;
+  auto position = get_position(iter);
+  if(position >= 0)
+    path.push_back(position);
+  return path;
+}
+
+bool SelectionDialogBase::ListViewText::Model::get_iter_vfunc(const Path &path, iterator &iter) const {
+  if(path.size() != 1)
+    return set_iter(iter, -1);
+  return set_iter(iter, path[0]);
+}
+
+bool SelectionDialogBase::ListViewText::Model::set_iter(iterator &iter, int position) const {
+  if(position < 0 || static_cast<unsigned int>(position) >= visible_size()) {
+    iter = iterator();
+    return false;
+  }
+  iter.set_stamp(stamp);
+  iter.gobj()->user_data = GINT_TO_POINTER(position);
+  return true;
+}
+
+int SelectionDialogBase::ListViewText::Model::get_position(const iterator &iter) const {
+  if(iter.get_stamp() != stamp)
+    return -1;
+  auto position = GPOINTER_TO_INT(iter.gobj()->user_data);
+  if(position < 0 || static_cast<unsigned int>(position) >= visible_size())
+    return -1;
+  return position;
+}
+
 SelectionDialogBase::ListViewText::ListViewText(bool use_markup) : Gtk::TreeView(), use_markup(use_markup) {
-  list_store = Gtk::ListStore::create(column_record);
-  set_model(list_store);
+  model = Model::create();
+  set_model(model);
   append_column("", cell_renderer);
   if(use_markup)
     get_column(0)->add_attribute(cell_renderer.property_markup(), column_record.text);
   else
     get_column(0)->add_attribute(cell_renderer.property_text(), column_record.text);
 
+  // All rows have the same height, so only visible rows need to be measured
+  get_column(0)->set_sizing(Gtk::TreeViewColumnSizing::TREE_VIEW_COLUMN_FIXED);
+  set_fixed_height_mode(true);
+
   get_selection()->set_mode(Gtk::SelectionMode::SELECTION_BROWSE);
   set_enable_search(true);
   set_headers_visible(false);
@@ -19,20 +174,146 @@ SelectionDialogBase::ListViewText::ListViewText(bool use_markup) : Gtk::TreeView
 }
 
 void SelectionDialogBase::ListViewText::append(const std::string &value) {
-  auto new_row = list_store->append();
-  new_row->set_value(column_record.text, value);
-  new_row->set_value(column_record.index, size++);
+  model->append(value);
+  if(!model->all_rows_visible()) {
+    auto index = model->size() - 1;
+    if(!visible_func || !visible_func(index))
+      return;
+    model->add_visible_row(index);
+  }
+  if(model_changed || !get_realized()) {
+    model_changed = true;
+    return;
+  }
+  Gtk::TreeModel::Path path;
+  path.push_back(model->visible_size() - 1);
+  model->row_inserted(path, model->get_iter(path));
+}
+
+void SelectionDialogBase::ListViewText::replace_rows(const std::vector<std::string> &rows) {
+  if(!model)
+    return;
+  model->clear();
+  for(auto &row : rows)
+    model->append(row);
+  model_changed = true;
+  cursor_position.reset();
 }
 
 void SelectionDialogBase::ListViewText::erase_rows() {
-  list_store->clear();
-  size = 0;
+  model->clear();
+  model_changed = true;
+  cursor_position.reset();
+  update();
 }
 
 void SelectionDialogBase::ListViewText::clear() {
   unset_model();
-  list_store.reset();
-  size = 0;
+  model->clear();
+  model.reset();
+  model_changed = false;
+  cursor_position.reset();
+}
+
+void SelectionDialogBase::ListViewText::set_visible_rows(std::vector<unsigned int> indices) {
+  if(!model)
+    return;
+  auto selected_index = get_selected_index(); // Must be read before the visible rows are changed
+  model->set_visible_rows(std::move(indices));
+  model_changed = true;
+  update(selected_index);
+}
+
+void SelectionDialogBase::ListViewText::set_all_rows_visible() {
+  if(!model)
+    return;
+  auto selected_index = get_selected_index(); // Must be read before the visible rows are changed
+  model->set_all_rows_visible();
+  model_changed = true;
+  update(selected_index);
+}
+
+void SelectionDialogBase::ListViewText::refilter() {
+  if(!model)
+    return;
+  if(!visible_func) {
+    set_all_rows_visible();
+    return;
+  }
+  std::vector<unsigned int> indices;
+  for(unsigned int index = 0; index < model->size(); ++index) {
+    if(visible_func(index))
+      indices.emplace_back(index);
+  }
+  set_visible_rows(std::move(indices));
+}
+
+void SelectionDialogBase::ListViewText::update() {
+  if(!model || !model_changed)
+    return;
+  update(get_selected_index());
+}
+
+boost::optional<unsigned int> SelectionDialogBase::ListViewText::get_selected_index() {
+  if(!model)
+    return {};
+  if(auto it = get_selection()->get_selected())
+    return it->get_value(column_record.index);
+  return {};
+}
+
+void SelectionDialogBase::ListViewText::update(const boost::optional<unsigned int> &selected_index) {
+  if(!model || !model_changed)
+    return;
+  model_changed = false;
+
+  // Setting the model again makes the tree view read all rows at once
+  unset_model();
+  model->invalidate_iterators();
+
+  if(model->size() > 0) {
+    // Measure only the longest row instead of every row
+    if(use_markup)
+      cell_renderer.property_markup() = model->get_text(model->get_longest_row());
+    else
+      cell_renderer.property_text() = model->get_text(model->get_longest_row());
+    int minimum_width, natural_width;
+    cell_renderer.get_preferred_width(*this, minimum_width, natural_width);
+    get_column(0)->set_fixed_width(natural_width);
+  }
+
+  set_model(model);
+
+  if(cursor_position) {
+    if(*cursor_position < model->visible_size()) {
+      Gtk::TreeModel::Path path;
+      path.push_back(*cursor_position);
+      set_cursor(path);
+    }
+    cursor_position.reset();
+  }
+  else if(selected_index) {
+    for(unsigned int position = 0; position < model->visible_size(); ++position) {
+      if(model->get_index(position) == *selected_index) {
+        Gtk::TreeModel::Path path;
+        path.push_back(position);
+        set_cursor(path);
+        break;
+      }
+    }
+  }
+}
+
+void SelectionDialogBase::ListViewText::set_cursor_at_last_row() {
+  if(model->visible_size() == 0)
+    return;
+  if(model_changed) {
+    cursor_position = model->visible_size() - 1; // Set cursor when the rows are shown
+    return;
+  }
+  Gtk::TreeModel::Path path;
+  path.push_back(model->visible_size() - 1);
+  set_cursor(path);
 }
 
 SelectionDialogBase::SelectionDialogBase(Source::BaseView *view_, const boost::optional<Gtk::TextIter> &start_iter, bool show_search_entry_, bool use_markup)
@@ -156,13 +437,17 @@ void SelectionDialogBase::cursor_changed() {
 }
 void SelectionDialogBase::add_row(const std::string &row) {
   list_view_text.append(row);
+  if(show_search_entry)
+    row_candidates.emplace_back(row, list_view_text.use_markup);
 }
 
 void SelectionDialogBase::erase_rows() {
   list_view_text.erase_rows();
+  row_candidates.clear();
 }
 
 void SelectionDialogBase::show() {
+  list_view_text.update();
   window.show_all();
   if(view)
     view->grab_focus();
@@ -185,11 +470,8 @@ void SelectionDialogBase::show() {
 }
 
 void SelectionDialogBase::set_cursor_at_last_row() {
-  auto children = list_view_text.get_model()->children();
-  if(children.size() > 0) {
-    list_view_text.set_cursor(list_view_text.get_model()->get_path(children[children.size() - 1]));
-    cursor_changed();
-  }
+  list_view_text.set_cursor_at_last_row();
+  cursor_changed();
 }
 
 void SelectionDialogBase::hide() {
@@ -199,6 +481,7 @@ void SelectionDialogBase::hide() {
   if(on_hide)
     on_hide();
   list_view_text.clear();
+  row_candidates.clear();
   last_index.reset();
 }
 
@@ -206,42 +489,15 @@ std::unique_ptr<SelectionDialog> SelectionDialog::instance;
 
 SelectionDialog::SelectionDialog(Source::BaseView *view, const boost::optional<Gtk::TextIter> &start_iter, bool show_search_entry, bool use_markup)
     : SelectionDialogBase(view, start_iter, show_search_entry, use_markup) {
-  auto search_text = std::make_shared<std::string>();
-  auto filter_model = Gtk::TreeModelFilter::create(list_view_text.get_model());
-
-  filter_model->set_visible_func([this, search_text](const Gtk::TreeModel::const_iterator &iter) {
-    std::string row_lc;
-    iter->get_value(0, row_lc);
-    auto search_text_lc = *search_text;
-    std::transform(row_lc.begin(), row_lc.end(), row_lc.begin(), ::tolower);
-    std::transform(search_text_lc.begin(), search_text_lc.end(), search_text_lc.begin(), ::tolower);
-    if(list_view_text.use_markup) {
-      size_t pos = 0;
-      while((pos = row_lc.find('<', pos)) != std::string::npos) {
-        auto pos2 = row_lc.find('>', pos + 1);
-        row_lc.erase(pos, pos2 - pos + 1);
-      }
-      search_text_lc = Glib::Markup::escape_text(search_text_lc);
-    }
-    if(row_lc.find(search_text_lc) != std::string::npos)
-      return true;
-    return false;
-  });
-
-  list_view_text.set_model(filter_model);
-
   list_view_text.set_search_equal_func([](const Glib::RefPtr<Gtk::TreeModel> &model, int column, const Glib::ustring &key, const Gtk::TreeModel::iterator &iter) {
     return false;
   });
 
-  search_entry.signal_changed().connect([this, search_text, filter_model]() {
-    *search_text = search_entry.get_text();
-    filter_model->refilter();
+  search_entry.signal_changed().connect([this]() {
+    update_matches(search_entry.get_text());
     list_view_text.set_search_entry(search_entry); //TODO:Report the need of this to GTK's git (bug)
-    if(search_text->empty()) {
-      if(list_view_text.get_model()->children().size() > 0)
-        list_view_text.set_cursor(list_view_text.get_model()->get_path(list_view_text.get_model()->children().begin()));
-    }
+    if(list_view_text.get_model()->children().size() > 0)
+      list_view_text.set_cursor(list_view_text.get_model()->get_path(list_view_text.get_model()->children().begin()));
   });
 
   auto activate = [this]() {
@@ -258,6 +514,41 @@ SelectionDialog::SelectionDialog(Source::BaseView *view, const boost::optional<G
   });
 }
 
+void SelectionDialog::replace_rows(const std::vector<std::string> &rows) {
+  if(!is_visible())
+    return;
+  list_view_text.replace_rows(rows);
+  row_candidates.clear();
+  if(show_search_entry) {
+    row_candidates.reserve(rows.size());
+    for(auto &row : rows)
+      row_candidates.emplace_back(row, list_view_text.use_markup);
+  }
+  last_search_text.clear(); // Search all the new rows
+  update_matches(search_entry.get_text());
+  if(list_view_text.get_model()->children().size() > 0)
+    list_view_text.set_cursor(list_view_text.get_model()->get_path(list_view_text.get_model()->children().begin()));
+  cursor_changed();
+}
+
+void SelectionDialog::update_matches(const std::string &search_text) {
+  FuzzyMatch fuzzy_match(search_text);
+  if(search_text.empty())
+    matches.clear();
+  else if(!last_search_text.empty() && fuzzy_match.refines(last_search_text) && matches_rows_size == row_candidates.size())
+    matches = fuzzy_match.filter(row_candidates, &matches); // Only rows matching the previous search text can match
+  else
+    matches = fuzzy_match.filter(row_candidates);
+  last_search_text = search_text;
+  matches_rows_size = row_candidates.size();
+
+  if(search_text.empty()) {
+    list_view_text.set_all_rows_visible();
+    return;
+  }
+  list_view_text.set_visible_rows(std::vector<unsigned int>(matches.begin(), matches.end()));
+}
+
 bool SelectionDialog::on_key_press(GdkEventKey *event) {
   if((event->keyval == GDK_KEY_Down || event->keyval == GDK_KEY_KP_Down) && list_view_text.get_model()->children().size() > 0) {
     auto it = list_view_text.get_selection()->get_selected();
@@ -353,32 +644,24 @@ CompletionDialog::CompletionDialog(Source::BaseView *view, const Gtk::TextIter &
   show_offset = view->get_buffer()->get_insert()->get_iter().get_offset();
 
   auto search_text = std::make_shared<std::string>();
-  auto filter_model = Gtk::TreeModelFilter::create(list_view_text.get_model());
-  if(show_offset == start_mark->get_iter().get_offset()) {
-    filter_model->set_visible_func([search_text](const Gtk::TreeModel::const_iterator &iter) {
-      std::string row_lc;
-      iter->get_value(0, row_lc);
-      auto search_text_lc = *search_text;
+  bool case_insensitive_search = show_offset == start_mark->get_iter().get_offset();
+  if(case_insensitive_search) {
+    list_view_text.visible_func = [this, search_text](unsigned int index) {
+      auto row_lc = list_view_text.get_text(index);
       std::transform(row_lc.begin(), row_lc.end(), row_lc.begin(), ::tolower);
-      std::transform(search_text_lc.begin(), search_text_lc.end(), search_text_lc.begin(), ::tolower);
-      if(row_lc.find(search_text_lc) != std::string::npos)
-        return true;
-      return false;
-    });
+      return row_lc.find(*search_text) != std::string::npos;
+    };
   }
   else {
-    filter_model->set_visible_func([search_text](const Gtk::TreeModel::const_iterator &iter) {
-      std::string row;
-      iter->get_value(0, row);
-      if(row.find(*search_text) == 0)
-        return true;
-      return false;
-    });
+    list_view_text.visible_func = [this, search_text](unsigned int index) {
+      return starts_with(list_view_text.get_text(index), *search_text);
+    };
   }
-  list_view_text.set_model(filter_model);
-  search_entry.signal_changed().connect([this, search_text, filter_model]() {
+  search_entry.signal_changed().connect([this, search_text, case_insensitive_search]() {
     *search_text = search_entry.get_text();
-    filter_model->refilter();
+    if(case_insensitive_search)
+      std::transform(search_text->begin(), search_text->end(), search_text->begin(), ::tolower);
+    list_view_text.refilter();
     list_view_text.set_search_entry(search_entry); //TODO:Report the need of this to GTK's git (bug)
   });
 
@@ -1,4 +1,5 @@
 #pragma once
+#include "fuzzy_match.hpp"
 #include "source_base.hpp"
 #include <boost/optional.hpp>
 #include <functional>
@@ -18,17 +19,94 @@ class SelectionDialogBase {
     };
 
   public:
+    /// List model that stores all rows in one string buffer, and only exposes the visible rows.
+    /// Row values are created on demand, so memory use is proportional to the row text.
+    class Model : public Glib::Object, public Gtk::TreeModel {
+      Model();
+
+    public:
+      static Glib::RefPtr<Model> create() { return Glib::RefPtr<Model>(new Model()); }
+
+      void append(const std::string &text);
+      void clear();
+      /// Returns number of rows, including rows that are not visible
+      unsigned int size() const { return row_ends.size(); }
+      std::string get_text(unsigned int index) const;
+      /// Returns index of the row with the most bytes
+      unsigned int get_longest_row() const;
+
+      /// Only show the rows with the given indices, in the given order
+      void set_visible_rows(std::vector<unsigned int> indices);
+      void set_all_rows_visible();
+      /// Shows the row with the given index after the currently visible rows
+      void add_visible_row(unsigned int index) { visible_rows.emplace_back(index); }
+      bool all_rows_visible() const { return all_rows_visible_; }
+      unsigned int visible_size() const { return all_rows_visible_ ? size() : visible_rows.size(); }
+      /// Returns index of the row at the given visible position
+      unsigned int get_index(unsigned int position) const { return all_rows_visible_ ? position : visible_rows[position]; }
+
+      /// Invalidates iterators given out by the model
+      void invalidate_iterators() { ++stamp; }
+
+    protected:
+      Gtk::TreeModelFlags get_flags_vfunc() const override;
+      int get_n_columns_vfunc() const override;
+      GType get_column_type_vfunc(int index) const override;
+      void get_value_vfunc(const iterator &iter, int column, Glib::ValueBase &value) const override;
+      bool iter_next_vfunc(const iterator &iter, iterator &iter_next) const override;
+      bool iter_children_vfunc(const iterator &parent, iterator &iter) const override;
+      bool iter_has_child_vfunc(const iterator &iter) const override;
+      int iter_n_children_vfunc(const iterator &iter) const override;
+      int iter_n_root_children_vfunc() const override;
+      bool iter_nth_child_vfunc(const iterator &parent, int n, iterator &iter) const override;
+      bool iter_nth_root_child_vfunc(int n, iterator &iter) const override;
+      bool iter_parent_vfunc(const iterator &child, iterator &iter) const override;
+      Path get_path_vfunc(const iterator &iter) const override;
+      bool get_iter_vfunc(const Path &path, iterator &iter) const override;
+
+    private:
+      bool set_iter(iterator &iter, int position) const;
+      int get_position(const iterator &iter) const;
+
+      std::string buffer;
+      /// End offsets in buffer of each row
+      std::vector<size_t> row_ends;
+      bool all_rows_visible_ = true;
+      std::vector<unsigned int> visible_rows;
+      int stamp = 1;
+    };
+
     bool use_markup;
     ColumnRecord column_record;
     ListViewText(bool use_markup);
     void append(const std::string &value);
+    /// Replaces all rows. The rows are shown on the next update(), set_visible_rows() or set_all_rows_visible().
+    void replace_rows(const std::vector<std::string> &rows);
     void erase_rows();
     void clear();
+    /// Returns number of rows, including rows that are not visible
+    unsigned int size() const { return model ? model->size() : 0; }
+    std::string get_text(unsigned int index) const { return model->get_text(index); }
+    /// Only show the rows with the given indices, in the given order
+    void set_visible_rows(std::vector<unsigned int> indices);
+    void set_all_rows_visible();
+    /// If set, refilter() and append() only shows the rows where visible_func returns true
+    std::function<bool(unsigned int index)> visible_func;
+    void refilter();
+    /// Shows rows that have been appended while the tree view was not realized.
+    /// Rows are added in bulk instead of one signal emission per row.
+    void update();
+    void set_cursor_at_last_row();
 
   private:
-    Glib::RefPtr<Gtk::ListStore> list_store;
+    Glib::RefPtr<Model> model;
     Gtk::CellRendererText cell_renderer;
-    unsigned int size = 0;
+    /// Returns index of the selected row. Must be called before the visible rows of the model are changed.
+    boost::optional<unsigned int> get_selected_index();
+    /// Like update(), but selects the row with selected_index, if visible, instead of the currently selected row
+    void update(const boost::optional<unsigned int> &selected_index);
+    bool model_changed = false;
+    boost::optional<unsigned int> cursor_position;
   };
 
   class SearchEntry : public Gtk::SearchEntry {
@@ -66,6 +144,8 @@ protected:
   ListViewText list_view_text;
   SearchEntry search_entry;
   bool show_search_entry;
+  /// Plain text and lowercase versions of the rows, used when searching. Only kept if show_search_entry is true.
+  std::vector<FuzzyMatch::Candidate> row_candidates;
 
   boost::optional<unsigned int> last_index;
 };
@@ -84,6 +164,18 @@ public:
     instance = std::unique_ptr<SelectionDialog>(new SelectionDialog(nullptr, {}, show_search_entry, use_markup));
   }
   static std::unique_ptr<SelectionDialog> &get() { return instance; }
+
+  /// Replaces all rows while the dialog is shown, and keeps the current search
+  void replace_rows(const std::vector<std::string> &rows);
+
+private:
+  void update_matches(const std::string &search_text);
+
+  std::string last_search_text;
+  /// Row indices matching last_search_text, ordered by score
+  std::vector<size_t> matches;
+  /// Number of rows when matches was computed
+  size_t matches_rows_size = 0;
 };
 
 class CompletionDialog : public SelectionDialogBase {
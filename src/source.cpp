@@ -148,6 +148,49 @@ Source::View::View(const boost::filesystem::path &file_path, const Glib::RefPtr<
   get_buffer()->create_tag("def:warning_underline");
   get_buffer()->create_tag("def:error_underline");
 
+  // Update the curly bracket offsets, and check the curly brackets around the changes again on next use
+  get_buffer()->signal_insert().connect(
+      [this](const Gtk::TextIter &iter, const Glib::ustring &text, int) {
+        if(!curly_brackets)
+          return;
+        auto offset = iter.get_offset();
+        int count = text.size();
+        curly_brackets->shift(offset, count);
+        for(auto &range : curly_brackets_changed_ranges) {
+          if(range.first >= offset)
+            range.first += count;
+          if(range.second > offset)
+            range.second += count;
+        }
+        add_curly_brackets_changed_range(offset - 1, offset + count + 1);
+      },
+      false);
+  get_buffer()->signal_erase().connect(
+      [this](const Gtk::TextIter &start_iter, const Gtk::TextIter &end_iter) {
+        if(!curly_brackets)
+          return;
+        auto start = start_iter.get_offset();
+        auto end = end_iter.get_offset();
+        curly_brackets->erase(start, end);
+        curly_brackets->shift(start, start - end);
+        for(auto &range : curly_brackets_changed_ranges) {
+          for(auto *offset : {&range.first, &range.second}) {
+            if(*offset > end)
+              *offset -= end - start;
+            else if(*offset > start)
+              *offset = start;
+          }
+        }
+        add_curly_brackets_changed_range(start - 1, start + 1);
+      },
+      false);
+  auto on_tag_changed = [this](const Glib::RefPtr<Gtk::TextTag> &tag, const Gtk::TextIter &start, const Gtk::TextIter &end) {
+    if(curly_brackets && (tag == comment_tag || tag == string_tag || tag == no_spellcheck_tag))
+      add_curly_brackets_changed_range(start.get_offset() - 1, end.get_offset() + 1);
+  };
+  get_buffer()->signal_apply_tag().connect(on_tag_changed);
+  get_buffer()->signal_remove_tag().connect(on_tag_changed);
+
   auto mark_attr_debug_breakpoint = Gsv::MarkAttributes::create();
   Gdk::RGBA rgba;
   rgba.set_red(1.0);
@@ -328,7 +371,7 @@ Source::View::View(const boost::filesystem::path &file_path, const Glib::RefPtr<
         return methods;
       }
       file_path /= this->file_path.filename().string() + (is_cpp_standard_header ? ".hpp" : "");
-      filesystem::write(file_path, this->get_buffer()->get_text().raw());
+      filesystem::write(file_path, *this->get_snapshot());
     }
     else
       file_path = this->file_path;
@@ -933,7 +976,7 @@ void Source::View::setup_format_style(bool is_generic_view) {
         else
           options += ", cursorOffset: " + std::to_string(get_buffer()->get_insert()->get_iter().get_offset());
         prettier_background_process->write("{prettier.clearConfigCache();let _ = prettier.resolveConfig(\"" + escape(file_path.string(), {'"'}) + "\").then(options => {try{let _ = process.stdout.write(JSON.stringify(prettier.formatWithCursor(Buffer.from('");
-        prettier_background_process->write(to_hex_string(get_buffer()->get_text().raw()));
+        prettier_background_process->write(to_hex_string(*get_snapshot()));
         prettier_background_process->write("', 'hex').toString(), {...options, " + options + "})));}catch(error){let _ = process.stderr.write('ParseError: ' + error.message);}}).catch(error => {let _ = process.stderr.write('ConfigError: ' + error.message);});}\n");
 
         int exit_status = -1;
@@ -966,7 +1009,7 @@ void Source::View::setup_format_style(bool is_generic_view) {
                 if(start == end)
                   start.backward_char();
 
-                add_diagnostic_tooltip(start, end, true, [error_message = std::move(error->message)](Tooltip &tooltip) {
+                add_diagnostic_tooltip(start, end, true, error->message, [error_message = error->message](Tooltip &tooltip) {
                   tooltip.insert_with_links_tagged(error_message);
                 });
               }
@@ -991,7 +1034,7 @@ void Source::View::setup_format_style(bool is_generic_view) {
         else
           command += " --cursor-offset " + std::to_string(get_buffer()->get_insert()->get_iter().get_offset());
 
-        std::stringstream stdin_stream(get_buffer()->get_text().raw()), stdout_stream, stderr_stream;
+        std::stringstream stdin_stream(*get_snapshot()), stdout_stream, stderr_stream;
         auto exit_status = Terminal::get().process(stdin_stream, stdout_stream, command, this->file_path.parent_path(), &stderr_stream);
         if(exit_status == 0) {
           replace_text(stdout_stream.str());
@@ -1026,7 +1069,7 @@ void Source::View::setup_format_style(bool is_generic_view) {
                 if(start == end)
                   start.backward_char();
 
-                add_diagnostic_tooltip(start, end, true, [error_message = sm[1].str()](Tooltip &tooltip) {
+                add_diagnostic_tooltip(start, end, true, sm[1].str(), [error_message = sm[1].str()](Tooltip &tooltip) {
                   tooltip.insert_with_links_tagged(error_message);
                 });
               }
@@ -1094,7 +1137,7 @@ void Source::View::setup_format_style(bool is_generic_view) {
         command += "}\"";
       }
 
-      std::stringstream stdin_stream(get_buffer()->get_text()), stdout_stream;
+      std::stringstream stdin_stream(*get_snapshot()), stdout_stream;
 
       auto exit_status = Terminal::get().process(stdin_stream, stdout_stream, command, this->file_path.parent_path());
       if(exit_status == 0) {
@@ -1197,7 +1240,7 @@ void Source::View::setup_format_style(bool is_generic_view) {
           }
         }
 
-        std::stringstream stdin_stream(get_buffer()->get_text()), stdout_stream;
+        std::stringstream stdin_stream(*get_snapshot()), stdout_stream;
 
         auto exit_status = Terminal::get().process(stdin_stream, stdout_stream, command, this->file_path.parent_path());
         if(exit_status == 0)
@@ -2151,34 +2194,90 @@ void Source::View::show_or_hide() {
   get_buffer()->apply_tag(hide_tag, start, end);
 }
 
-void Source::View::add_diagnostic_tooltip(const Gtk::TextIter &start, const Gtk::TextIter &end, bool error, std::function<void(Tooltip &)> &&set_buffer) {
+void Source::View::add_diagnostic_tooltip(const Gtk::TextIter &start, const Gtk::TextIter &end, bool error, std::string message, std::function<void(Tooltip &)> &&set_buffer) {
   diagnostic_offsets.emplace(start.get_offset());
 
   std::string severity_tag_name = error ? "def:error" : "def:warning";
 
-  diagnostic_tooltips.emplace_back(this, start, end, [error, severity_tag_name, set_buffer = std::move(set_buffer)](Tooltip &tooltip) {
-    tooltip.buffer->insert_with_tag(tooltip.buffer->get_insert()->get_iter(), error ? "Error" : "Warning", severity_tag_name);
-    tooltip.buffer->insert(tooltip.buffer->get_insert()->get_iter(), ":\n");
-    set_buffer(tooltip);
-  });
+  bool keep = false;
+  auto range = previous_diagnostics.equal_range(std::make_tuple(start.get_offset(), end.get_offset(), error));
+  for(auto it = range.first; it != range.second; ++it) {
+    if(it->second->message == message) { // Keep the tooltip of an unchanged diagnostic
+      previous_diagnostics.erase(it);
+      keep = true;
+      break;
+    }
+  }
 
-  get_buffer()->apply_tag_by_name(severity_tag_name + "_underline", start, end);
+  if(!keep) {
+    auto tooltip = diagnostic_tooltips.emplace_back(this, start, end, [error, severity_tag_name, set_buffer = std::move(set_buffer)](Tooltip &tooltip) {
+      tooltip.buffer->insert_with_tag(tooltip.buffer->get_insert()->get_iter(), error ? "Error" : "Warning", severity_tag_name);
+      tooltip.buffer->insert(tooltip.buffer->get_insert()->get_iter(), ":\n");
+      set_buffer(tooltip);
+    });
+    diagnostics.emplace_back(DiagnosticTooltip{tooltip, error, std::move(message)});
+  }
+
+  // The underline is also applied to kept diagnostics, since edits might have removed it from parts of the range
+  apply_diagnostic_underline(error, start, end);
+}
+
+void Source::View::apply_diagnostic_underline(bool error, const Gtk::TextIter &start, const Gtk::TextIter &end) {
+  std::string underline_tag_name = error ? "def:error_underline" : "def:warning_underline";
+  get_buffer()->apply_tag_by_name(underline_tag_name, start, end);
 
   auto iter = get_buffer()->get_insert()->get_iter();
   if(iter.ends_line()) {
     auto next_iter = iter;
     if(next_iter.forward_char())
-      get_buffer()->remove_tag_by_name(severity_tag_name + "_underline", iter, next_iter);
+      get_buffer()->remove_tag_by_name(underline_tag_name, iter, next_iter);
   }
 }
 
 void Source::View::clear_diagnostic_tooltips() {
   diagnostic_offsets.clear();
+  diagnostics.clear();
+  previous_diagnostics.clear();
   diagnostic_tooltips.clear();
   get_buffer()->remove_tag_by_name("def:warning_underline", get_buffer()->begin(), get_buffer()->end());
   get_buffer()->remove_tag_by_name("def:error_underline", get_buffer()->begin(), get_buffer()->end());
 }
 
+void Source::View::begin_diagnostics_update() {
+  diagnostic_offsets.clear();
+  previous_diagnostics.clear();
+  for(auto it = diagnostics.begin(); it != diagnostics.end(); ++it)
+    previous_diagnostics.emplace(std::make_tuple(it->tooltip->start_mark->get_iter().get_offset(), it->tooltip->end_mark->get_iter().get_offset(), it->error), it);
+}
+
+void Source::View::end_diagnostics_update() {
+  if(previous_diagnostics.empty())
+    return;
+
+  // Sorted by start offset, with the maximum end offset so far
+  std::vector<std::pair<int, int>> removed_ranges;
+  removed_ranges.reserve(previous_diagnostics.size());
+  for(auto &pair : previous_diagnostics) {
+    auto &diagnostic = *pair.second;
+    auto start = diagnostic.tooltip->start_mark->get_iter();
+    auto end = diagnostic.tooltip->end_mark->get_iter();
+    get_buffer()->remove_tag_by_name(diagnostic.error ? "def:error_underline" : "def:warning_underline", start, end);
+    removed_ranges.emplace_back(start.get_offset(), std::max(end.get_offset(), removed_ranges.empty() ? 0 : removed_ranges.back().second));
+    diagnostic_tooltips.erase(diagnostic.tooltip);
+    diagnostics.erase(pair.second);
+  }
+  previous_diagnostics.clear();
+
+  // Restore underlines of remaining diagnostics that overlapped removed diagnostics
+  for(auto &diagnostic : diagnostics) {
+    auto start = diagnostic.tooltip->start_mark->get_iter();
+    auto end = diagnostic.tooltip->end_mark->get_iter();
+    auto it = std::lower_bound(removed_ranges.begin(), removed_ranges.end(), std::make_pair(end.get_offset(), std::numeric_limits<int>::min()));
+    if(it != removed_ranges.begin() && std::prev(it)->second > start.get_offset())
+      apply_diagnostic_underline(diagnostic.error, start, end);
+  }
+}
+
 void Source::View::place_cursor_at_next_diagnostic() {
   auto insert_offset = get_buffer()->get_insert()->get_iter().get_offset();
   for(auto offset : diagnostic_offsets) {
@@ -2329,17 +2428,11 @@ Gtk::TextIter Source::View::get_start_of_expression(Gtk::TextIter iter) {
 bool Source::View::find_close_symbol_forward(Gtk::TextIter iter, Gtk::TextIter &found_iter, unsigned int positive_char, unsigned int negative_char) {
   long count = 0;
   if(positive_char == '{' && negative_char == '}') {
-    do {
-      if(*iter == positive_char && is_code_iter(iter))
-        count++;
-      else if(*iter == negative_char && is_code_iter(iter)) {
-        if(count == 0) {
-          found_iter = iter;
-          return true;
-        }
-        count--;
-      }
-    } while(iter.forward_char());
+    // The close curly bracket is found where the depth first gets lower than the depth at iter
+    if(auto offset = get_curly_brackets().find_close(iter.get_offset())) {
+      found_iter = get_buffer()->get_iter_at_offset(*offset);
+      return true;
+    }
     return false;
   }
   else {
@@ -2390,17 +2483,11 @@ bool Source::View::find_close_symbol_forward(Gtk::TextIter iter, Gtk::TextIter &
 bool Source::View::find_open_symbol_backward(Gtk::TextIter iter, Gtk::TextIter &found_iter, unsigned int positive_char, unsigned int negative_char) {
   long count = 0;
   if(positive_char == '{' && negative_char == '}') {
-    do {
-      if(*iter == positive_char && is_code_iter(iter)) {
-        if(count == 0) {
-          found_iter = iter;
-          return true;
-        }
-        count++;
-      }
-      else if(*iter == negative_char && is_code_iter(iter))
-        count--;
-    } while(iter.backward_char());
+    // The open curly bracket is found where the depth last was lower than the depth after iter
+    if(auto offset = get_curly_brackets().find_open(iter.get_offset())) {
+      found_iter = get_buffer()->get_iter_at_offset(*offset);
+      return true;
+    }
     return false;
   }
   else {
@@ -2455,16 +2542,8 @@ long Source::View::symbol_count(Gtk::TextIter iter, unsigned int positive_char,
   if(positive_char == '{' && negative_char == '}') {
     // If checking top-level curly brackets, check whole buffer
     auto previous_iter = iter;
-    if(iter.starts_line() || (previous_iter.backward_char() && previous_iter.starts_line() && *previous_iter == '{')) {
-      auto iter = get_buffer()->begin();
-      do {
-        if(*iter == '{' && is_code_iter(iter))
-          ++symbol_count;
-        else if(*iter == '}' && is_code_iter(iter))
-          --symbol_count;
-      } while(iter.forward_char());
-      return symbol_count;
-    }
+    if(iter.starts_line() || (previous_iter.backward_char() && previous_iter.starts_line() && *previous_iter == '{'))
+      return get_curly_brackets().depth();
     // Can stop when text is found at top-level indentation
     else {
       do {
@@ -2536,6 +2615,198 @@ long Source::View::symbol_count(Gtk::TextIter iter, unsigned int positive_char,
   return symbol_count;
 }
 
+void Source::View::CurlyBrackets::Node::update() {
+  auto left_delta_sum = get_delta_sum(left);
+  gap_sum = get_gap_sum(left) + gap + get_gap_sum(right);
+  delta_sum = left_delta_sum + delta + get_delta_sum(right);
+  minimum_before = left_delta_sum;
+  minimum_after = left_delta_sum + delta;
+  if(left) {
+    minimum_before = std::min(minimum_before, left->minimum_before);
+    minimum_after = std::min(minimum_after, left->minimum_after);
+  }
+  if(right) {
+    minimum_before = std::min(minimum_before, left_delta_sum + delta + right->minimum_before);
+    minimum_after = std::min(minimum_after, left_delta_sum + delta + right->minimum_after);
+  }
+}
+
+void Source::View::CurlyBrackets::split(std::unique_ptr<Node> node, int offset, int base, std::unique_ptr<Node> &left, std::unique_ptr<Node> &right) {
+  if(!node) {
+    left = nullptr;
+    right = nullptr;
+    return;
+  }
+  auto node_offset = base + get_gap_sum(node->left) + node->gap;
+  if(node_offset < offset) {
+    split(std::move(node->right), offset, node_offset, node->right, right);
+    node->update();
+    left = std::move(node);
+  }
+  else {
+    split(std::move(node->left), offset, base, left, node->left);
+    node->update();
+    right = std::move(node);
+  }
+}
+
+std::unique_ptr<Source::View::CurlyBrackets::Node> Source::View::CurlyBrackets::merge(std::unique_ptr<Node> left, std::unique_ptr<Node> right) {
+  if(!left)
+    return right;
+  if(!right)
+    return left;
+  if(left->priority > right->priority) {
+    left->right = merge(std::move(left->right), std::move(right));
+    left->update();
+    return left;
+  }
+  right->left = merge(std::move(left), std::move(right->left));
+  right->update();
+  return right;
+}
+
+void Source::View::CurlyBrackets::add_to_first_gap(Node *node, int count) {
+  std::vector<Node *> path;
+  for(; node; node = node->left.get())
+    path.emplace_back(node);
+  path.back()->gap += count;
+  for(auto it = path.rbegin(); it != path.rend(); ++it)
+    (*it)->update();
+}
+
+void Source::View::CurlyBrackets::insert(int offset, bool open) {
+  std::unique_ptr<Node> left, right;
+  split(std::move(root), offset, 0, left, right);
+  auto node = std::make_unique<Node>(offset - get_gap_sum(left), open ? 1 : -1, random_engine());
+  node->update();
+  if(right)
+    add_to_first_gap(right.get(), -node->gap);
+  root = merge(merge(std::move(left), std::move(node)), std::move(right));
+}
+
+void Source::View::CurlyBrackets::erase(int start, int end) {
+  std::unique_ptr<Node> left, middle, right;
+  split(std::move(root), start, 0, left, right);
+  split(std::move(right), end, get_gap_sum(left), middle, right);
+  if(middle && right)
+    add_to_first_gap(right.get(), middle->gap_sum);
+  root = merge(std::move(left), std::move(right));
+}
+
+void Source::View::CurlyBrackets::shift(int offset, int count) {
+  std::unique_ptr<Node> left, right;
+  split(std::move(root), offset, 0, left, right);
+  if(right)
+    add_to_first_gap(right.get(), count);
+  root = merge(std::move(left), std::move(right));
+}
+
+boost::optional<int> Source::View::CurlyBrackets::find_close(int offset) {
+  std::unique_ptr<Node> left, right;
+  split(std::move(root), offset, 0, left, right);
+  boost::optional<int> result;
+  // Find the first curly bracket after which the depth is lower than at offset
+  if(right && right->minimum_after < 0) {
+    auto node = right.get();
+    long depth = 0;
+    int base = get_gap_sum(left);
+    while(true) {
+      if(node->left && depth + node->left->minimum_after < 0) {
+        node = node->left.get();
+        continue;
+      }
+      depth += get_delta_sum(node->left) + node->delta;
+      base += get_gap_sum(node->left) + node->gap;
+      if(depth < 0) {
+        result = base;
+        break;
+      }
+      node = node->right.get();
+    }
+  }
+  root = merge(std::move(left), std::move(right));
+  return result;
+}
+
+boost::optional<int> Source::View::CurlyBrackets::find_open(int offset) {
+  std::unique_ptr<Node> left, right;
+  split(std::move(root), offset + 1, 0, left, right);
+  boost::optional<int> result;
+  // Find the last curly bracket before which the depth is lower than after offset
+  if(left && left->minimum_before < left->delta_sum) {
+    auto node = left.get();
+    auto depth_after_offset = left->delta_sum;
+    long depth = 0;
+    int base = 0;
+    while(true) {
+      auto depth_before_node = depth + get_delta_sum(node->left);
+      auto node_offset = base + get_gap_sum(node->left) + node->gap;
+      if(node->right && depth_before_node + node->delta + node->right->minimum_before < depth_after_offset) {
+        depth = depth_before_node + node->delta;
+        base = node_offset;
+        node = node->right.get();
+        continue;
+      }
+      if(depth_before_node < depth_after_offset) {
+        result = node_offset;
+        break;
+      }
+      node = node->left.get();
+    }
+  }
+  root = merge(std::move(left), std::move(right));
+  return result;
+}
+
+void Source::View::add_curly_brackets_changed_range(int start, int end) {
+  auto it = std::lower_bound(curly_brackets_changed_ranges.begin(), curly_brackets_changed_ranges.end(), std::make_pair(start, start));
+  if(it != curly_brackets_changed_ranges.begin() && std::prev(it)->second >= start)
+    --it;
+  auto last = it;
+  for(; last != curly_brackets_changed_ranges.end() && last->first <= end; ++last) {
+    start = std::min(start, last->first);
+    end = std::max(end, last->second);
+  }
+  it = curly_brackets_changed_ranges.erase(it, last);
+  curly_brackets_changed_ranges.insert(it, {start, end});
+}
+
+Source::View::CurlyBrackets &Source::View::get_curly_brackets() {
+  if(!curly_brackets) {
+    curly_brackets = std::make_unique<CurlyBrackets>();
+    curly_brackets_changed_ranges.clear();
+    auto text = get_snapshot();
+    auto iter = get_buffer()->begin();
+    int offset = -1;
+    for(auto &chr : *text) {
+      if((static_cast<unsigned char>(chr) & 0xC0) != 0x80) // Skip UTF-8 continuation bytes
+        ++offset;
+      if(chr == '{' || chr == '}') {
+        iter.forward_chars(offset - iter.get_offset());
+        if(is_code_iter(iter))
+          curly_brackets->insert(offset, chr == '{');
+      }
+    }
+  }
+  else if(!curly_brackets_changed_ranges.empty()) {
+    auto buffer_end = get_buffer()->end().get_offset();
+    for(auto &range : curly_brackets_changed_ranges) {
+      auto start = std::max(range.first, 0);
+      auto end = std::min(range.second, buffer_end);
+      if(start >= end)
+        continue;
+      curly_brackets->erase(start, end);
+      auto iter = get_buffer()->get_iter_at_offset(start);
+      for(auto offset = start; offset < end; ++offset, iter.forward_char()) {
+        if((*iter == '{' || *iter == '}') && is_code_iter(iter))
+          curly_brackets->insert(offset, *iter == '{');
+      }
+    }
+    curly_brackets_changed_ranges.clear();
+  }
+  return *curly_brackets;
+}
+
 bool Source::View::is_templated_function(Gtk::TextIter iter, Gtk::TextIter &parenthesis_end_iter) {
   auto iter_stored = iter;
   long bracket_count = 0;
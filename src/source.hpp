@@ -6,6 +6,9 @@
 #include <boost/filesystem.hpp>
 #include <boost/property_tree/xml_parser.hpp>
 #include <limits>
+#include <list>
+#include <map>
+#include <random>
 #include <set>
 #include <string>
 #include <tuple>
@@ -136,8 +139,13 @@ namespace Source {
     Glib::RefPtr<Gtk::TextTag> hide_tag;
 
     virtual void show_diagnostic_tooltips(const Gdk::Rectangle &rectangle) { diagnostic_tooltips.show(rectangle); }
-    void add_diagnostic_tooltip(const Gtk::TextIter &start, const Gtk::TextIter &end, bool error, std::function<void(Tooltip &)> &&set_buffer);
+    /// The message identifies the diagnostic when the diagnostics are updated, while set_buffer is only called when the tooltip is shown
+    void add_diagnostic_tooltip(const Gtk::TextIter &start, const Gtk::TextIter &end, bool error, std::string message, std::function<void(Tooltip &)> &&set_buffer);
     void clear_diagnostic_tooltips();
+    /// Diagnostics added between begin_diagnostics_update() and end_diagnostics_update() that have the same range, severity and message
+    /// as a current diagnostic, keep their tooltip and underline. The current diagnostics that are not added again are removed.
+    void begin_diagnostics_update();
+    void end_diagnostics_update();
     std::set<int> diagnostic_offsets;
     void place_cursor_at_next_diagnostic();
     virtual void show_type_tooltips(const Gdk::Rectangle &rectangle) {}
@@ -165,6 +173,58 @@ namespace Source {
     /// Iter will not be moved if iter is already at open symbol.
     bool find_open_symbol_backward(Gtk::TextIter iter, Gtk::TextIter &found_iter, unsigned int positive_char, unsigned int negative_char);
     long symbol_count(Gtk::TextIter iter, unsigned int positive_char, unsigned int negative_char = std::numeric_limits<unsigned int>::max());
+
+    /// Code curly brackets of the buffer, used to find matching curly brackets without scanning the buffer.
+    /// Stored in a treap ordered by offset, where each node holds the offset distance to the previous curly bracket,
+    /// so that text edits only change one node.
+    class CurlyBrackets {
+      class Node {
+      public:
+        Node(int gap, long delta, unsigned priority) : gap(gap), delta(delta), priority(priority) {}
+        /// Offset minus the offset of the previous curly bracket, or the offset itself for the first curly bracket
+        int gap;
+        /// 1 for {, and -1 for }
+        long delta;
+        unsigned priority;
+        std::unique_ptr<Node> left, right;
+
+        int gap_sum;
+        long delta_sum;
+        /// Lowest depth, relative to the start of the subtree, after one of its curly brackets
+        long minimum_after;
+        /// Lowest depth, relative to the start of the subtree, before one of its curly brackets
+        long minimum_before;
+
+        void update();
+      };
+
+      std::unique_ptr<Node> root;
+      std::minstd_rand random_engine;
+
+      static int get_gap_sum(const std::unique_ptr<Node> &node) { return node ? node->gap_sum : 0; }
+      static long get_delta_sum(const std::unique_ptr<Node> &node) { return node ? node->delta_sum : 0; }
+      /// Splits node into the curly brackets before offset, and those at or after offset
+      static void split(std::unique_ptr<Node> node, int offset, int base, std::unique_ptr<Node> &left, std::unique_ptr<Node> &right);
+      static std::unique_ptr<Node> merge(std::unique_ptr<Node> left, std::unique_ptr<Node> right);
+      static void add_to_first_gap(Node *node, int count);
+
+    public:
+      void insert(int offset, bool open);
+      /// Removes the curly brackets from start to end, not including end
+      void erase(int start, int end);
+      /// Moves the curly brackets at or after offset by count characters
+      void shift(int offset, int count);
+
+      /// Returns the offset of the first curly bracket at or after offset that closes the depth at offset
+      boost::optional<int> find_close(int offset);
+      /// Returns the offset of the last curly bracket at or before offset that is still open after offset
+      boost::optional<int> find_open(int offset);
+      /// Returns the number of open minus close curly brackets
+      long depth() const { return get_delta_sum(root); }
+    };
+    /// Built on first use, and afterwards updated in the ranges where the buffer text, or its comment or string highlighting, has changed
+    CurlyBrackets &get_curly_brackets();
+
     bool is_templated_function(Gtk::TextIter iter, Gtk::TextIter &parenthesis_end_iter);
     /// If insert is at an possible argument. Also based on last key press.
     bool is_possible_argument();
@@ -189,6 +249,23 @@ namespace Source {
     bool use_fixed_continuation_indenting = true;
     guint previous_non_modifier_keyval = 0;
 
+    std::unique_ptr<CurlyBrackets> curly_brackets;
+    /// Sorted and non-overlapping offset ranges where the curly brackets must be checked again
+    std::vector<std::pair<int, int>> curly_brackets_changed_ranges;
+    void add_curly_brackets_changed_range(int start, int end);
+
+    class DiagnosticTooltip {
+    public:
+      Tooltips::iterator tooltip;
+      bool error;
+      std::string message;
+    };
+    std::list<DiagnosticTooltip> diagnostics;
+    /// Underlines the diagnostic range, except at the cursor if the cursor is at the end of a line
+    void apply_diagnostic_underline(bool error, const Gtk::TextIter &start, const Gtk::TextIter &end);
+    /// Diagnostics from before the ongoing diagnostics update that have not been added again. Key: start offset, end offset and error.
+    std::multimap<std::tuple<int, int, bool>, std::list<DiagnosticTooltip>::iterator> previous_diagnostics;
+
     bool keep_previous_extended_selections = false;
     std::vector<std::pair<Gtk::TextIter, Gtk::TextIter>> previous_extended_selections;
   };
@@ -3,8 +3,10 @@
 #include "filesystem.hpp"
 #include "git.hpp"
 #include "info.hpp"
+#include "json.hpp"
 #include "selection_dialog.hpp"
 #include "terminal.hpp"
+#include "trace.hpp"
 #include "utility.hpp"
 #include <fstream>
 #include <gtksourceview/gtksource.h>
@@ -301,6 +303,13 @@ void Source::CommonView::copy_lines() {
 Source::BaseView::BaseView(const boost::filesystem::path &file_path, const Glib::RefPtr<Gsv::Language> &language) : CommonView(language), file_path(file_path), status_diagnostics(0, 0, 0) {
   get_style_context()->add_class("juci_source_view");
 
+  get_buffer()->signal_changed().connect([this] {
+    snapshot = nullptr;
+    // The remaining handlers are run once, when the edit has been applied at all the extra cursors
+    if(extra_cursors_edit)
+      g_signal_stop_emission_by_name(get_buffer()->gobj(), "changed");
+  });
+
   load(true);
   get_buffer()->place_cursor(get_buffer()->get_iter_at_offset(0));
 
@@ -373,11 +382,14 @@ Source::BaseView::BaseView(const boost::filesystem::path &file_path, const Glib:
 }
 
 Source::BaseView::~BaseView() {
-  monitor_changed_connection.disconnect();
   delayed_monitor_changed_connection.disconnect();
 }
 
 bool Source::BaseView::load(bool not_undoable_action) {
+  Trace::Span span("BaseView::load");
+  if(Trace::is_recording())
+    span.set_args("\"file\":\"" + JSON::escape_string(file_path.string()) + '"');
+
   boost::system::error_code ec;
   last_write_time = boost::filesystem::last_write_time(file_path, ec);
   if(ec)
@@ -485,6 +497,12 @@ void Source::BaseView::replace_text(const std::string &new_text) {
   get_buffer()->end_user_action();
 }
 
+std::shared_ptr<const std::string> Source::BaseView::get_snapshot() {
+  if(!snapshot)
+    snapshot = std::make_shared<const std::string>(get_buffer()->get_text().raw());
+  return snapshot;
+}
+
 void Source::BaseView::rename(const boost::filesystem::path &path) {
   file_path = path;
 
@@ -531,22 +549,14 @@ void Source::BaseView::monitor_file() {
     Recursive::f(this);
 #else
   if(last_write_time) {
-    monitor = Gio::File::create_for_path(file_path.string())->monitor_file(Gio::FileMonitorFlags::FILE_MONITOR_NONE);
-    monitor_changed_connection.disconnect();
-    monitor_changed_connection = monitor->signal_changed().connect([this](const Glib::RefPtr<Gio::File> &file,
-                                                                          const Glib::RefPtr<Gio::File> &,
-                                                                          Gio::FileMonitorEvent monitor_event) {
-      if(monitor_event != Gio::FileMonitorEvent::FILE_MONITOR_EVENT_CHANGES_DONE_HINT) {
-        delayed_monitor_changed_connection.disconnect();
-        delayed_monitor_changed_connection = Glib::signal_timeout().connect(
-            [this]() {
-              check_last_write_time();
-              return false;
-            },
-            1000); // Has to wait 1 second (std::time_t is in seconds)
-      }
-    });
+    monitor = FileWatcher::get().subscribe(
+        file_path, false, [this](std::vector<boost::filesystem::path> &&) {
+          check_last_write_time();
+        },
+        1000); // Has to wait 1 second (std::time_t is in seconds)
   }
+  else
+    monitor = nullptr;
 #endif
 }
 
@@ -1451,6 +1461,12 @@ void Source::BaseView::setup_extra_cursor_signals() {
     }
   });
 
+  get_buffer()->signal_insert().connect(
+      [this](const Gtk::TextIter & /*iter*/, const Glib::ustring & /*text*/, int /*bytes*/) {
+        if(enable_multiple_cursors && !extra_cursors.empty())
+          begin_extra_cursors_edit();
+      },
+      false);
   get_buffer()->signal_insert().connect([this](const Gtk::TextIter &iter, const Glib::ustring &text, int bytes) {
     if(enable_multiple_cursors && !extra_cursors.empty()) {
       enable_multiple_cursors = false;
@@ -1471,6 +1487,8 @@ void Source::BaseView::setup_extra_cursor_signals() {
       }
       enable_multiple_cursors = true;
     }
+    if(enable_multiple_cursors)
+      end_extra_cursors_edit();
   });
 
   auto erase_backward_length = std::make_shared<int>(0);
@@ -1479,6 +1497,7 @@ void Source::BaseView::setup_extra_cursor_signals() {
   get_buffer()->signal_erase().connect(
       [this, erase_backward_length, erase_forward_length, erase_selection](const Gtk::TextIter &iter_start, const Gtk::TextIter &iter_end) {
         if(enable_multiple_cursors && (!extra_cursors.empty())) {
+          begin_extra_cursors_edit();
           auto insert_offset = get_buffer()->get_insert()->get_iter().get_offset();
           *erase_backward_length = insert_offset - iter_start.get_offset();
           *erase_forward_length = iter_end.get_offset() - insert_offset;
@@ -1524,9 +1543,26 @@ void Source::BaseView::setup_extra_cursor_signals() {
       *erase_forward_length = 0;
       *erase_selection = false;
     }
+    if(enable_multiple_cursors)
+      end_extra_cursors_edit();
   });
 }
 
+void Source::BaseView::begin_extra_cursors_edit() {
+  if(extra_cursors_edit)
+    return;
+  extra_cursors_edit = true;
+  get_buffer()->begin_user_action();
+}
+
+void Source::BaseView::end_extra_cursors_edit() {
+  if(!extra_cursors_edit)
+    return;
+  extra_cursors_edit = false;
+  get_buffer()->end_user_action();
+  g_signal_emit_by_name(get_buffer()->gobj(), "changed");
+}
+
 void Source::BaseView::set_snippets() {
   LockGuard lock(snippets_mutex);
 
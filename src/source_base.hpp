@@ -1,5 +1,6 @@
 #pragma once
 
+#include "file_watcher.hpp"
 #include "mutex.hpp"
 #include "snippets.hpp"
 #include <boost/filesystem.hpp>
@@ -84,11 +85,14 @@ namespace Source {
     bool load(bool not_undoable_action = false);
     /// Set new text more optimally and without unnecessary scrolling
     void replace_text(const std::string &new_text);
+    /// Returns the buffer text, which is only copied from the buffer once per buffer change.
+    /// Use instead of get_buffer()->get_text() when the whole text is passed to for instance a parse thread or a language server,
+    /// so that consumers of the same buffer version share one copy. Must be called from the main GUI thread.
+    std::shared_ptr<const std::string> get_snapshot();
     virtual void rename(const boost::filesystem::path &path);
     virtual bool save() = 0;
 
-    Glib::RefPtr<Gio::FileMonitor> monitor;
-    sigc::connection monitor_changed_connection;
+    std::unique_ptr<FileWatcher::Subscription> monitor;
     sigc::connection delayed_monitor_changed_connection;
 
     virtual void configure() = 0;
@@ -134,6 +138,7 @@ namespace Source {
 
   protected:
     boost::optional<std::time_t> last_write_time;
+    std::shared_ptr<const std::string> snapshot;
     void monitor_file();
     void check_last_write_time(boost::optional<std::time_t> last_write_time_ = {});
 
@@ -214,6 +219,12 @@ namespace Source {
     void setup_extra_cursor_signals();
     bool extra_cursors_signals_set = false;
 
+    /// Set while an edit at the main cursor is repeated at the extra cursors. The edits are made in one user action,
+    /// and the buffer changed signal is emitted once when the edit has been applied at all the cursors.
+    bool extra_cursors_edit = false;
+    void begin_extra_cursors_edit();
+    void end_extra_cursors_edit();
+
     /// After inserting a snippet, one can use tab to select the next parameter
     bool keep_snippet_marks = false;
     Mutex snippets_mutex;
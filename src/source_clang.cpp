@@ -11,9 +11,13 @@
 #include "documentation.hpp"
 #include "filesystem.hpp"
 #include "info.hpp"
+#include "json.hpp"
 #include "selection_dialog.hpp"
+#include "trace.hpp"
+#include "translation_unit_cache.hpp"
 #include "usages_clang.hpp"
 #include "utility.hpp"
+#include <algorithm>
 
 const std::regex include_regex(R"(^[ \t]*#[ \t]*include[ \t]*[<"]([^<>"]+)[>"].*$)", std::regex::optimize);
 
@@ -42,6 +46,11 @@ Source::ClangViewParse::ClangViewParse(const boost::filesystem::path &file_path,
   get_buffer()->signal_changed().connect([this]() {
     soft_reparse(true);
   });
+
+  signal_motion_notify_event().connect([this](GdkEventMotion *) {
+    ++type_tooltips_request_count;
+    return false;
+  });
 }
 
 void Source::ClangViewParse::rename(const boost::filesystem::path &path) {
@@ -56,8 +65,10 @@ bool Source::ClangViewParse::save() {
   if(is_language({"chdr", "cpphdr"})) {
     for(auto &view : views) {
       if(auto clang_view = dynamic_cast<Source::ClangView *>(view)) {
-        if(this != clang_view)
+        if(this != clang_view) {
           clang_view->soft_reparse_needed = true;
+          ++clang_view->dependencies_version;
+        }
       }
     }
   }
@@ -90,16 +101,37 @@ void Source::ClangViewParse::configure() {
 }
 
 void Source::ClangViewParse::parse_initialize() {
+  Trace::Span span("ClangViewParse::parse_initialize");
+  if(Trace::is_recording())
+    span.set_args("\"file\":\"" + JSON::escape_string(file_path.string()) + '"');
   hide_tooltips();
   parsed = false;
   if(parse_thread.joinable())
     parse_thread.join();
+  join_type_tooltips_thread();
   parse_state = ParseState::processing;
   parse_process_state = ParseProcessState::starting;
+  ++dependencies_version;
+
+  auto build = Project::Build::create(file_path);
+  if(build->project_path.empty())
+    Info::get().print(file_path.filename().string() + ": could not find a supported build system");
+  build->update_default();
+  auto arguments = CompileCommands::get_arguments(build->get_default_path(), file_path);
+  int flags = clangmm::TranslationUnit::DefaultFlags() & ~(CXTranslationUnit_DetailedPreprocessingRecord | CXTranslationUnit_Incomplete);
+  flags |= Config::get().source.clang_detailed_preprocessing_record ? CXTranslationUnit_DetailedPreprocessingRecord : CXTranslationUnit_Incomplete;
 
   auto buffer_ = get_buffer()->get_text();
   auto &buffer_raw = const_cast<std::string &>(buffer_.raw());
 
+  if(is_language({"chdr", "cpphdr"}))
+    clangmm::remove_include_guard(buffer_raw);
+
+  if(!get_buffer()->get_modified())
+    translation_unit_cache = std::make_unique<TranslationUnitCache>(build->project_path, build->get_default_path(), file_path, arguments, flags, buffer_raw);
+  else
+    translation_unit_cache = nullptr;
+
   if(!Config::get().log.libclang) {
     // Remove includes for first parse for initial syntax highlighting
     std::size_t pos = 0;
@@ -115,32 +147,26 @@ void Source::ClangViewParse::parse_initialize() {
     }
   }
 
-  if(is_language({"chdr", "cpphdr"}))
-    clangmm::remove_include_guard(buffer_raw);
-
-  auto build = Project::Build::create(file_path);
-  if(build->project_path.empty())
-    Info::get().print(file_path.filename().string() + ": could not find a supported build system");
-  build->update_default();
-  auto arguments = CompileCommands::get_arguments(build->get_default_path(), file_path);
   clang_tokens.reset();
-  int flags = clangmm::TranslationUnit::DefaultFlags() & ~(CXTranslationUnit_DetailedPreprocessingRecord | CXTranslationUnit_Incomplete);
-  flags |= Config::get().source.clang_detailed_preprocessing_record ? CXTranslationUnit_DetailedPreprocessingRecord : CXTranslationUnit_Incomplete;
+  similar_tokens = SimilarTokens();
   clang_tu = std::make_unique<clangmm::TranslationUnit>(std::make_shared<clangmm::Index>(0, Config::get().log.libclang), file_path.string(), arguments, &buffer_raw, flags);
   clang_tokens = clang_tu->get_tokens();
   clang_tokens_offsets.clear();
   clang_tokens_offsets.reserve(clang_tokens->size());
   for(auto &token : *clang_tokens)
     clang_tokens_offsets.emplace_back(token.get_source_range().get_offsets());
+  update_memory_usage();
   {
     LockGuard lock(parse_mutex);
-    update_syntax();
+    if(!update_syntax_from_cache(buffer_raw.size()))
+      update_syntax();
   }
 
   status_state = "parsing...";
   if(update_status_state)
     update_status_state(this);
   parse_thread = std::thread([this]() {
+    Trace::set_thread_name("clang parse: " + file_path.filename().string());
     while(true) {
       while(parse_state == ParseState::processing && parse_process_state != ParseProcessState::starting && parse_process_state != ParseProcessState::processing)
         std::this_thread::sleep_for(std::chrono::milliseconds(10));
@@ -152,7 +178,7 @@ void Source::ClangViewParse::parse_initialize() {
           auto expected = ParseProcessState::preprocessing;
           if(parse_mutex.try_lock()) {
             if(parse_process_state.compare_exchange_strong(expected, ParseProcessState::processing))
-              parse_thread_buffer = get_buffer()->get_text();
+              parse_thread_buffer = get_snapshot();
             parse_mutex.unlock();
           }
           else
@@ -160,10 +186,16 @@ void Source::ClangViewParse::parse_initialize() {
         });
       }
       else if(parse_process_state == ParseProcessState::processing && parse_mutex.try_lock()) {
-        auto &parse_thread_buffer_raw = const_cast<std::string &>(parse_thread_buffer.raw());
-        if(is_language({"chdr", "cpphdr"}))
-          clangmm::remove_include_guard(parse_thread_buffer_raw);
-        auto status = clang_tu->reparse(parse_thread_buffer_raw);
+        Trace::Span span("ClangViewParse::reparse");
+        if(Trace::is_recording())
+          span.set_args("\"file\":\"" + JSON::escape_string(file_path.string()) + '"');
+        auto buffer = parse_thread_buffer;
+        if(is_language({"chdr", "cpphdr"})) { // The snapshot is shared with other consumers, and is therefore not modified
+          auto buffer_without_include_guard = std::make_shared<std::string>(*buffer);
+          clangmm::remove_include_guard(*buffer_without_include_guard);
+          buffer = std::move(buffer_without_include_guard);
+        }
+        auto status = clang_tu->reparse(*buffer);
         if(status == 0) {
           auto expected = ParseProcessState::processing;
           if(parse_process_state.compare_exchange_strong(expected, ParseProcessState::postprocessing)) {
@@ -172,22 +204,33 @@ void Source::ClangViewParse::parse_initialize() {
             clang_tokens_offsets.reserve(clang_tokens->size());
             for(auto &token : *clang_tokens)
               clang_tokens_offsets.emplace_back(token.get_source_range().get_offsets());
+            similar_tokens = SimilarTokens(*clang_tokens);
             clang_diagnostics = clang_tu->get_diagnostics();
+            update_memory_usage();
+            std::unique_ptr<TranslationUnitCache> translation_unit_cache;
+            if(this->translation_unit_cache && this->translation_unit_cache->can_save(*buffer))
+              translation_unit_cache = std::move(this->translation_unit_cache);
             parse_mutex.unlock();
             dispatcher.post([this] {
               if(parse_mutex.try_lock()) {
                 auto expected = ParseProcessState::postprocessing;
                 if(parse_process_state.compare_exchange_strong(expected, ParseProcessState::idle)) {
+                  Trace::Span span("ClangViewParse::postprocess");
                   update_syntax();
                   update_diagnostics();
+                  ++parse_count;
                   parsed = true;
-                  status_state = "";
+                  status_state = get_memory_usage_status();
                   if(update_status_state)
                     update_status_state(this);
                 }
                 parse_mutex.unlock();
+                ClangView::apply_memory_budget();
               }
             });
+            // Saving parses the buffer again, and is therefore done without holding parse_mutex
+            if(translation_unit_cache)
+              translation_unit_cache->save(*buffer);
           }
           else
             parse_mutex.unlock();
@@ -210,11 +253,31 @@ void Source::ClangViewParse::parse_initialize() {
   });
 }
 
+void Source::ClangViewParse::update_memory_usage() {
+  auto resource_usage = clang_getCXTUResourceUsage(clang_tu->cx_tu);
+  size_t bytes = 0;
+  for(unsigned c = 0; c < resource_usage.numEntries; ++c)
+    bytes += resource_usage.entries[c].amount;
+  clang_disposeCXTUResourceUsage(resource_usage);
+  memory_usage = bytes;
+}
+
+std::string Source::ClangViewParse::get_memory_usage_status() const {
+  if(memory_usage == 0)
+    return std::string();
+  return std::to_string((memory_usage + 512 * 1024) / (1024 * 1024)) + " MB";
+}
+
 void Source::ClangViewParse::soft_reparse(bool delayed) {
   soft_reparse_needed = false;
   parsed = false;
   delayed_reparse_connection.disconnect();
 
+  if(parse_state == ParseState::unloaded) {
+    full_reparse();
+    return;
+  }
+
   if(parse_state != ParseState::processing)
     return;
 
@@ -255,15 +318,6 @@ const std::map<int, std::string> &Source::ClangViewParse::clang_types() {
 
 void Source::ClangViewParse::update_syntax() {
   auto buffer = get_buffer();
-  const auto apply_tag = [this, buffer](const std::pair<clangmm::Offset, clangmm::Offset> &offsets, int type) {
-    auto syntax_tag_it = syntax_tags.find(type);
-    if(syntax_tag_it != syntax_tags.end()) {
-      Gtk::TextIter begin_iter = buffer->get_iter_at_line_index(offsets.first.line - 1, offsets.first.index - 1);
-      Gtk::TextIter end_iter = buffer->get_iter_at_line_index(offsets.second.line - 1, offsets.second.index - 1);
-      buffer->apply_tag(syntax_tag_it->second, begin_iter, end_iter);
-    }
-  };
-
   for(auto &pair : syntax_tags)
     buffer->remove_tag(pair.second, buffer->begin(), buffer->end());
 
@@ -273,29 +327,185 @@ void Source::ClangViewParse::update_syntax() {
     //if(token.get_kind()==clangmm::Token::Kind::Token_Punctuation)
     //ranges.emplace_back(token_offset, static_cast<int>(token.get_cursor().get_kind()));
     auto token_kind = token.get_kind();
+    int type = -1;
     if(token_kind == clangmm::Token::Kind::Keyword)
-      apply_tag(token_offsets, 702);
-    else if(token_kind == clangmm::Token::Kind::Identifier) {
-      auto cursor_kind = token.get_cursor().get_kind();
-      if(cursor_kind == clangmm::Cursor::Kind::DeclRefExpr || cursor_kind == clangmm::Cursor::Kind::MemberRefExpr)
-        cursor_kind = token.get_cursor().get_referenced().get_kind();
-      if(cursor_kind != clangmm::Cursor::Kind::PreprocessingDirective)
-        apply_tag(token_offsets, static_cast<int>(cursor_kind));
-    }
+      type = 702;
+    else if(token_kind == clangmm::Token::Kind::Identifier)
+      type = get_identifier_syntax_type(token.get_cursor());
     else if(token_kind == clangmm::Token::Kind::Literal)
-      apply_tag(token_offsets, static_cast<int>(clangmm::Cursor::Kind::StringLiteral));
+      type = static_cast<int>(clangmm::Cursor::Kind::StringLiteral);
     else if(token_kind == clangmm::Token::Kind::Comment)
-      apply_tag(token_offsets, 705);
+      type = 705;
+    if(type != -1)
+      apply_syntax_tag(type, token_offsets.first.line, token_offsets.first.index, token_offsets.second.line, token_offsets.second.index);
+  }
+}
+
+bool Source::ClangViewParse::update_syntax_from_cache(size_t buffer_size) {
+  if(!translation_unit_cache)
+    return false;
+
+  auto cx_index = clang_createIndex(0, 0);
+  auto cx_tu = translation_unit_cache->load(cx_index);
+  if(!cx_tu) {
+    clang_disposeIndex(cx_index);
+    return false;
+  }
+  // The translation unit is already saved
+  translation_unit_cache = nullptr;
+
+  auto buffer = get_buffer();
+  for(auto &pair : syntax_tags)
+    buffer->remove_tag(pair.second, buffer->begin(), buffer->end());
+
+  auto cx_file = clang_getFile(cx_tu, file_path.string().c_str());
+  auto cx_range = clang_getRange(clang_getLocationForOffset(cx_tu, cx_file, 0), clang_getLocationForOffset(cx_tu, cx_file, buffer_size));
+  CXToken *cx_tokens;
+  unsigned cx_tokens_size;
+  clang_tokenize(cx_tu, cx_range, &cx_tokens, &cx_tokens_size);
+  std::vector<CXCursor> cx_cursors(cx_tokens_size);
+  clang_annotateTokens(cx_tu, cx_tokens, cx_tokens_size, cx_cursors.data());
+  for(unsigned c = 0; c < cx_tokens_size; ++c) {
+    auto token_kind = clang_getTokenKind(cx_tokens[c]);
+    int type = -1;
+    if(token_kind == CXToken_Keyword)
+      type = 702;
+    else if(token_kind == CXToken_Identifier)
+      type = get_identifier_syntax_type(clangmm::Cursor(cx_cursors[c]));
+    else if(token_kind == CXToken_Literal)
+      type = static_cast<int>(clangmm::Cursor::Kind::StringLiteral);
+    else if(token_kind == CXToken_Comment)
+      type = 705;
+    if(type != -1) {
+      auto cx_extent = clang_getTokenExtent(cx_tu, cx_tokens[c]);
+      unsigned start_line, start_index, end_line, end_index;
+      clang_getExpansionLocation(clang_getRangeStart(cx_extent), nullptr, &start_line, &start_index, nullptr);
+      clang_getExpansionLocation(clang_getRangeEnd(cx_extent), nullptr, &end_line, &end_index, nullptr);
+      apply_syntax_tag(type, start_line, start_index, end_line, end_index);
+    }
+  }
+  clang_disposeTokens(cx_tu, cx_tokens, cx_tokens_size);
+  clang_disposeTranslationUnit(cx_tu);
+  clang_disposeIndex(cx_index);
+  return true;
+}
+
+Source::ClangViewParse::SimilarTokens::SimilarTokens(clangmm::Tokens &tokens) {
+  std::unordered_map<std::string, size_t> cursor_ids; // Key: kind, usr and spelling
+  for(size_t c = 0; c < tokens.size(); ++c) {
+    auto &token = tokens[c];
+    if(!token.is_identifier())
+      continue;
+    auto referenced = token.get_cursor().get_referenced();
+    if(!referenced)
+      continue;
+    auto spelling = token.get_spelling();
+    auto key = std::to_string(static_cast<int>(referenced.get_kind())) + ':' + referenced.get_usr_extended() + ':' + spelling;
+    auto it = cursor_ids.find(key);
+    if(it == cursor_ids.end()) {
+      // Resolving all usrs is expensive, and is therefore only done once per referenced cursor
+      it = cursor_ids.emplace(std::move(key), cursors.size()).first;
+      cursors.emplace_back(Cursor{referenced.get_kind(), std::move(spelling), referenced.get_all_usr_extended(), {}});
+      for(auto &usr : cursors.back().usrs)
+        usr_cursors[usr].emplace_back(it->second);
+    }
+    cursors[it->second].token_indices.emplace_back(c);
+  }
+}
+
+std::vector<size_t> Source::ClangViewParse::SimilarTokens::get_token_indices(clangmm::Cursor::Kind kind, const std::string &spelling, const std::unordered_set<std::string> &usrs) const {
+  std::vector<size_t> token_indices;
+  std::set<size_t> added_cursor_ids;
+  for(auto &usr : usrs) {
+    auto it = usr_cursors.find(usr);
+    if(it == usr_cursors.end())
+      continue;
+    for(auto cursor_id : it->second) {
+      auto &cursor = cursors[cursor_id];
+      if(clangmm::Cursor::is_similar_kind(cursor.kind, kind) && cursor.spelling == spelling && added_cursor_ids.emplace(cursor_id).second)
+        token_indices.insert(token_indices.end(), cursor.token_indices.begin(), cursor.token_indices.end());
+    }
+  }
+  std::sort(token_indices.begin(), token_indices.end());
+  return token_indices;
+}
+
+int Source::ClangViewParse::get_identifier_syntax_type(const clangmm::Cursor &cursor) {
+  auto cursor_kind = cursor.get_kind();
+  if(cursor_kind == clangmm::Cursor::Kind::DeclRefExpr || cursor_kind == clangmm::Cursor::Kind::MemberRefExpr)
+    cursor_kind = cursor.get_referenced().get_kind();
+  if(cursor_kind == clangmm::Cursor::Kind::PreprocessingDirective)
+    return -1;
+  return static_cast<int>(cursor_kind);
+}
+
+void Source::ClangViewParse::apply_syntax_tag(int type, unsigned start_line, unsigned start_index, unsigned end_line, unsigned end_index) {
+  auto syntax_tag_it = syntax_tags.find(type);
+  if(syntax_tag_it != syntax_tags.end()) {
+    auto buffer = get_buffer();
+    buffer->apply_tag(syntax_tag_it->second, buffer->get_iter_at_line_index(start_line - 1, start_index - 1), buffer->get_iter_at_line_index(end_line - 1, end_index - 1));
   }
 }
 
 void Source::ClangViewParse::update_diagnostics() {
-  clear_diagnostic_tooltips();
+  begin_diagnostics_update();
   fix_its.clear();
   size_t num_warnings = 0;
   size_t num_errors = 0;
   size_t num_fix_its = 0;
 
+  // Add include fixits for std
+  auto get_new_include_offsets = [this, new_include_offsets = boost::optional<std::pair<clangmm::Offset, clangmm::Offset>>()]() mutable {
+    if(new_include_offsets)
+      return *new_include_offsets;
+    auto iter = get_buffer()->begin();
+    auto fallback = iter;
+    while(iter) {
+      if(*iter == '#') {
+        auto next = iter;
+        if(next.forward_char() && is_token_char(*next)) {
+          auto token = get_token(next);
+          if(token == "include")
+            break;
+          else if(token == "pragma" && next.forward_to_line_end() && get_buffer()->get_text(iter, next) == "#pragma once" && next.forward_char())
+            fallback = next;
+        }
+        // Move to next preprocessor directive:
+        while(iter) {
+          if((!iter.ends_line() && !iter.forward_to_line_end()) || !iter.forward_char() || *iter == '#')
+            break;
+        }
+      }
+      // Move to next line
+      else if((!iter.ends_line() && !iter.forward_to_line_end()) || !iter.forward_char())
+        break;
+    }
+    if(!iter) // Use fallback if end of buffer is reached
+      iter = fallback;
+    new_include_offsets = std::pair<clangmm::Offset, clangmm::Offset>{{static_cast<unsigned int>(iter.get_line() + 1), static_cast<unsigned int>(iter.get_line_index() + 1)},
+                                                                       {static_cast<unsigned int>(iter.get_line() + 1), static_cast<unsigned int>(iter.get_line_index() + 1)}};
+    return *new_include_offsets;
+  };
+  auto has_using_namespace_std = [this, using_namespace_std_index = boost::optional<size_t>()](size_t token_index) mutable -> bool {
+    if(token_index + 2 >= clang_tokens->size())
+      return false;
+    if(!using_namespace_std_index) {
+      using_namespace_std_index = clang_tokens->size();
+      for(size_t i = 0; i + 2 < clang_tokens->size(); i++) {
+        if((*clang_tokens)[i].get_kind() == clangmm::Token::Kind::Keyword &&
+           (*clang_tokens)[i + 1].get_kind() == clangmm::Token::Kind::Keyword &&
+           (*clang_tokens)[i + 2].get_kind() == clangmm::Token::Kind::Identifier &&
+           (*clang_tokens)[i].get_spelling() == "using" &&
+           (*clang_tokens)[i + 1].get_spelling() == "namespace" &&
+           (*clang_tokens)[i + 2].get_spelling() == "std") {
+          using_namespace_std_index = i;
+          break;
+        }
+      }
+    }
+    return *using_namespace_std_index + 2 < token_index;
+  };
+
   for(auto &diagnostic : clang_diagnostics) {
     if(diagnostic.path == file_path.string()) {
       int line = diagnostic.offsets.first.line - 1;
@@ -327,49 +537,6 @@ void Source::ClangViewParse::update_diagnostics() {
         error = true;
       }
 
-      // Add include fixits for std
-      auto get_new_include_offsets = [this]() -> std::pair<clangmm::Offset, clangmm::Offset> {
-        auto iter = get_buffer()->begin();
-        auto fallback = iter;
-        while(iter) {
-          if(*iter == '#') {
-            auto next = iter;
-            if(next.forward_char() && is_token_char(*next)) {
-              auto token = get_token(next);
-              if(token == "include")
-                break;
-              else if(token == "pragma" && next.forward_to_line_end() && get_buffer()->get_text(iter, next) == "#pragma once" && next.forward_char())
-                fallback = next;
-            }
-            // Move to next preprocessor directive:
-            while(iter) {
-              if((!iter.ends_line() && !iter.forward_to_line_end()) || !iter.forward_char() || *iter == '#')
-                break;
-            }
-          }
-          // Move to next line
-          else if((!iter.ends_line() && !iter.forward_to_line_end()) || !iter.forward_char())
-            break;
-        }
-        if(!iter) // Use fallback if end of buffer is reached
-          iter = fallback;
-        return {{static_cast<unsigned int>(iter.get_line() + 1), static_cast<unsigned int>(iter.get_line_index() + 1)},
-                {static_cast<unsigned int>(iter.get_line() + 1), static_cast<unsigned int>(iter.get_line_index() + 1)}};
-      };
-      auto has_using_namespace_std = [this](size_t token_index) -> bool {
-        if(token_index + 2 >= clang_tokens->size())
-          return false;
-        for(size_t i = 0; i + 2 < token_index; i++) {
-          if((*clang_tokens)[i].get_kind() == clangmm::Token::Kind::Keyword &&
-             (*clang_tokens)[i + 1].get_kind() == clangmm::Token::Kind::Keyword &&
-             (*clang_tokens)[i + 2].get_kind() == clangmm::Token::Kind::Identifier &&
-             (*clang_tokens)[i].get_spelling() == "using" &&
-             (*clang_tokens)[i + 1].get_spelling() == "namespace" &&
-             (*clang_tokens)[i + 2].get_spelling() == "std")
-            return true;
-        }
-        return false;
-      };
       auto add_include_fixit = [this, &diagnostic, &get_new_include_offsets](std::string ns, bool has_using_std, const std::string &token) {
         auto headers = Documentation::CppReference::get_headers(!ns.empty() ? ns + "::" + token : (has_using_std ? "std::" + token : token));
         if(headers.empty() && !ns.empty() && ns != "std" && !starts_with(ns, "std::") && has_using_std)
@@ -392,10 +559,14 @@ void Source::ClangViewParse::update_diagnostics() {
         }
       };
       if(diagnostic.fix_its.empty() && diagnostic.severity >= clangmm::Diagnostic::Severity::Warning) {
-        for(size_t c = 0; c < clang_tokens->size(); c++) {
+        // Only search the tokens starting on the diagnostic's line
+        auto line_tokens_it = std::lower_bound(clang_tokens_offsets.begin(), clang_tokens_offsets.end(), static_cast<unsigned int>(line + 1), [](const std::pair<clangmm::Offset, clangmm::Offset> &token_offsets, unsigned int line) {
+          return token_offsets.first.line < line;
+        });
+        for(size_t c = line_tokens_it - clang_tokens_offsets.begin(); c < clang_tokens->size() && clang_tokens_offsets[c].first.line - 1 == static_cast<unsigned int>(line); c++) {
           auto &token = (*clang_tokens)[c];
           auto &token_offsets = clang_tokens_offsets[c];
-          if(static_cast<unsigned int>(line) == token_offsets.first.line - 1 && static_cast<unsigned int>(index) >= token_offsets.first.index - 1 && static_cast<unsigned int>(index) <= token_offsets.second.index - 1) {
+          if(static_cast<unsigned int>(index) >= token_offsets.first.index - 1 && static_cast<unsigned int>(index) <= token_offsets.second.index - 1) {
             if(diagnostic.severity >= clangmm::Diagnostic::Severity::Error &&
                starts_with(diagnostic.spelling, "implicit instantiation of undefined template")) {
               size_t start = 44 + 2;
@@ -514,11 +685,12 @@ void Source::ClangViewParse::update_diagnostics() {
       if(!fix_its_string.empty())
         diagnostic.spelling += "\n\n" + fix_its_string;
 
-      add_diagnostic_tooltip(start, end, error, [spelling = std::move(diagnostic.spelling)](Tooltip &tooltip) {
+      add_diagnostic_tooltip(start, end, error, diagnostic.spelling, [spelling = diagnostic.spelling](Tooltip &tooltip) {
         tooltip.buffer->insert_at_cursor(spelling);
       });
     }
   }
+  end_diagnostics_update();
 
   status_diagnostics = std::make_tuple(num_warnings, num_errors, num_fix_its);
   if(update_status_diagnostics)
@@ -526,6 +698,7 @@ void Source::ClangViewParse::update_diagnostics() {
 }
 
 void Source::ClangViewParse::show_type_tooltips(const Gdk::Rectangle &rectangle) {
+  ++type_tooltips_request_count;
   if(parsed) {
     Gtk::TextIter iter;
     int location_x, location_y;
@@ -540,254 +713,323 @@ void Source::ClangViewParse::show_type_tooltips(const Gdk::Rectangle &rectangle)
     auto line = static_cast<unsigned>(iter.get_line());
     auto index = static_cast<unsigned>(iter.get_line_index());
     type_tooltips.clear();
+    std::vector<size_t> token_indices;
     for(size_t c = clang_tokens->size() - 1; c != static_cast<size_t>(-1); --c) {
-      auto &token = (*clang_tokens)[c];
       auto &token_offsets = clang_tokens_offsets[c];
-      auto token_spelling = token.get_spelling();
-      if(token.is_identifier() || token_spelling == "auto" || token_spelling == "this" || token_spelling == "[" || token_spelling == "]" || token_spelling == "*" || token_spelling == "&") {
-        if(line == token_offsets.first.line - 1 && index >= token_offsets.first.index - 1 && index <= token_offsets.second.index - 1) {
-          auto cursor = token.get_cursor();
-          auto referenced = cursor.get_referenced();
-          if(referenced || token_spelling == "this" || token_spelling == "[" || token_spelling == "]" || token_spelling == "*" || token_spelling == "&") {
-            auto start = get_buffer()->get_iter_at_line_index(token_offsets.first.line - 1, token_offsets.first.index - 1);
-            auto end = get_buffer()->get_iter_at_line_index(token_offsets.second.line - 1, token_offsets.second.index - 1);
+      if(line == token_offsets.first.line - 1 && index >= token_offsets.first.index - 1 && index <= token_offsets.second.index - 1) {
+        auto &token = (*clang_tokens)[c];
+        auto token_spelling = token.get_spelling();
+        if(token.is_identifier() || token_spelling == "auto" || token_spelling == "this" || token_spelling == "[" || token_spelling == "]" || token_spelling == "*" || token_spelling == "&")
+          token_indices.emplace_back(c);
+      }
+    }
 
-            type_tooltips.emplace_back(this, start, end, [this, token](Tooltip &tooltip) {
-              auto cursor = token.get_cursor();
-              auto type_description = cursor.get_type_description();
-              remove_internal_namespaces(type_description);
-              size_t pos = 0;
-              // Simplify std::basic_string types
-              while((pos = type_description.find("std::basic_string<char", pos)) != std::string::npos) {
-                pos += 22; // Move to after std::basic_string<char
-                if(pos < type_description.size()) {
-                  if(type_description[pos] == '>') {
-                    pos -= 17; // Move to after std::
-                    type_description.replace(pos, 17 + 1, "string");
-                    pos += 6; // Move to after std::string
-                    // Remove space before ending angle bracket
-                    if(pos + 1 < type_description.size() && type_description[pos] == ' ' && type_description[pos + 1] == '>')
-                      type_description.erase(pos, 1);
-                  }
-                  else if((starts_with(type_description, pos, ", std::char_traits<char>, std::allocator<char> >"))) {
-                    pos -= 17; // Move to after std::
-                    type_description.replace(pos, 17 + 48, "string");
-                    pos += 6; // Move to after std::string
-                    // Remove space before ending angle bracket
-                    if(pos + 1 < type_description.size() && type_description[pos] == ' ' && type_description[pos + 1] == '>')
-                      type_description.erase(pos, 1);
-                  }
-                }
-              }
-              // Add parameter names
-              if((pos = type_description.find('(')) != std::string::npos) {
-                pos++;
-                if(pos < type_description.size() && type_description[pos] != ')') {
-                  auto arguments = cursor.get_referenced().get_arguments();
-                  size_t current_argument = 0;
-                  int para_count = 0;
-                  int angle_count = 0;
-                  do {
-                    if(para_count == 0 && angle_count == 0 && (type_description[pos] == ',' || type_description[pos] == ')')) {
-                      if(current_argument < arguments.size()) {
-                        auto argument_spelling = arguments[current_argument].get_spelling();
-                        if(!argument_spelling.empty()) {
-                          if(type_description[pos - 1] != '*' && type_description[pos - 1] != '&')
-                            type_description.insert(pos++, " ");
-                          type_description.insert(pos, argument_spelling);
-                          pos += argument_spelling.size();
-                        }
-                      }
-                      if(type_description[pos] == ',') {
-                        ++current_argument;
-                        ++pos; // skip ' ' after ','
-                      }
-                      else
-                        break;
-                    }
-                    else if(type_description[pos] == '(')
-                      ++para_count;
-                    else if(type_description[pos] == ')')
-                      --para_count;
-                    else if(type_description[pos] == '<')
-                      ++angle_count;
-                    else if(type_description[pos] == '>')
-                      --angle_count;
-                    ++pos;
-                  } while(pos < type_description.size());
-                }
-              }
-              tooltip.insert_code(type_description, language);
+    if(type_tooltip_contents_parse_count != parse_count) {
+      type_tooltip_contents.clear();
+      type_tooltip_contents_parse_count = parse_count;
+    }
+    while(!token_indices.empty()) {
+      auto it = type_tooltip_contents.find(token_indices.front());
+      if(it == type_tooltip_contents.end())
+        break;
+      if(it->second) {
+        show_type_tooltip(it->first, *it->second);
+        return;
+      }
+      token_indices.erase(token_indices.begin());
+    }
+    if(token_indices.empty())
+      return;
 
-              {
-                auto doxygen = clangmm::to_string(clang_Cursor_getRawCommentText(cursor.get_referenced().cx_cursor));
-                if(!doxygen.empty()) {
-                  tooltip.buffer->insert_at_cursor("\n\n");
-                  tooltip.insert_doxygen(doxygen, true);
-                }
-              }
+    // Resolving the tooltip contents might have to wait for an ongoing reparse, and is therefore done in a separate thread
+    if(type_tooltips_thread.joinable())
+      type_tooltips_thread.join();
+    type_tooltips_thread = std::thread([this, token_indices = std::move(token_indices), request_count = type_tooltips_request_count.load(), parse_count = parse_count.load()] {
+      while(!parse_mutex.try_lock()) {
+        if(request_count != type_tooltips_request_count)
+          return;
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+      }
+      std::vector<std::pair<size_t, boost::optional<TypeTooltipContent>>> contents;
+      if(parsed && parse_count == this->parse_count) {
+        for(auto token_index : token_indices) {
+          if(request_count != type_tooltips_request_count)
+            break;
+          contents.emplace_back(token_index, get_type_tooltip_content((*clang_tokens)[token_index]));
+          if(contents.back().second)
+            break;
+        }
+      }
+      parse_mutex.unlock();
+      if(contents.empty())
+        return;
+      if(contents.back().second && !contents.back().second->doxygen.empty())
+        Tooltip::prerender_doxygen(contents.back().second->doxygen, true, language_id);
+      dispatcher.post([this, contents = std::move(contents), request_count, parse_count] {
+        if(!parsed || parse_count != this->parse_count)
+          return;
+        if(type_tooltip_contents_parse_count != parse_count) {
+          type_tooltip_contents.clear();
+          type_tooltip_contents_parse_count = parse_count;
+        }
+        for(auto &content : contents)
+          type_tooltip_contents.emplace(content.first, content.second);
+        if(request_count == type_tooltips_request_count && contents.back().second)
+          show_type_tooltip(contents.back().first, *contents.back().second);
+      });
+    });
+  }
+}
 
-#ifdef JUCI_ENABLE_DEBUG
-              if(Debug::LLDB::get().is_stopped()) {
-                auto is_variable = [](clangmm::Cursor::Kind kind) {
-                  return kind == clangmm::Cursor::Kind::FieldDecl || kind == clangmm::Cursor::Kind::EnumConstantDecl || kind == clangmm::Cursor::Kind::VarDecl || kind == clangmm::Cursor::Kind::ParmDecl;
-                };
-                auto is_function = [](clangmm::Cursor::Kind kind) {
-                  return kind == clangmm::Cursor::Kind::CXXMethod || kind == clangmm::Cursor::Kind::FunctionDecl ||
-                         kind == clangmm::Cursor::Kind::Constructor || kind == clangmm::Cursor::Kind::Destructor ||
-                         kind == clangmm::Cursor::Kind::FunctionTemplate || kind == clangmm::Cursor::Kind::ConversionFunction;
-                };
-
-                Glib::ustring value_type = "Value";
-                Glib::ustring debug_value;
-                auto referenced = cursor.get_referenced();
-                auto kind = clangmm::Cursor::Kind::UnexposedDecl;
-                if(referenced) {
-                  kind = referenced.get_kind();
-                  if(is_variable(kind)) {
-                    auto location = referenced.get_source_location();
-                    auto offset = location.get_offset();
-                    debug_value = Debug::LLDB::get().get_value(token.get_spelling(), location.get_path(), offset.line, offset.index);
-                  }
-                }
-                if(debug_value.empty() && (kind == clangmm::Cursor::Kind::UnexposedDecl || is_variable(kind) || is_function(kind))) {
-                  // Attempt to get value from expression (for instance: (*a).b.c, or: (*d)[1 + 1])
-                  auto is_safe = [&is_function](const clangmm::Cursor &cursor) {
-                    auto referenced = cursor.get_referenced();
-                    if(!referenced)
-                      return true;
-                    if(is_function(referenced.get_kind()))
-                      return clang_CXXMethod_isConst(referenced.cx_cursor) || referenced.get_spelling() == "operator[]"; // operator[] is passed even without being const for convenience purposes
-                    return true;
-                  };
-
-                  if(is_safe(cursor)) { // Do not call state altering expressions
-                    auto offsets = cursor.get_source_range().get_offsets();
-                    auto start = get_iter_at_line_index(offsets.first.line - 1, offsets.first.index - 1);
-                    auto end = get_iter_at_line_index(offsets.second.line - 1, offsets.second.index - 1);
-
-                    std::string expression;
-                    // Get full expression from cursor parent:
-                    if(*start == '[' || (kind == clangmm::Cursor::Kind::CXXMethod && (*start == '<' || *start == '>' || *start == '=' || *start == '!' ||
-                                                                                      *start == '+' || *start == '-' || *start == '*' || *start == '/' ||
-                                                                                      *start == '%' || *start == '&' || *start == '|' || *start == '^' ||
-                                                                                      *end == '('))) {
-                      struct VisitorData {
-                        std::pair<clangmm::Offset, clangmm::Offset> offsets;
-                        std::string spelling;
-                        clangmm::Cursor parent; // Output
-                      };
-                      VisitorData visitor_data{cursor.get_source_range().get_offsets(), cursor.get_spelling(), {}};
-                      auto start_cursor = cursor;
-                      for(auto parent = cursor.get_semantic_parent();
-                          parent.get_kind() != clangmm::Cursor::Kind::TranslationUnit &&
-                          parent.get_kind() != clangmm::Cursor::Kind::ClassDecl;
-                          parent = parent.get_semantic_parent())
-                        start_cursor = parent;
-                      clang_visitChildren(
-                          start_cursor.cx_cursor, [](CXCursor cx_cursor, CXCursor cx_parent, CXClientData data_) {
-                            auto data = static_cast<VisitorData *>(data_);
-                            if(clangmm::Cursor(cx_cursor).get_source_range().get_offsets() == data->offsets) {
-                              auto parent = clangmm::Cursor(cx_parent);
-                              if(parent.get_spelling() == data->spelling) {
-                                data->parent = parent;
-                                return CXChildVisit_Break;
-                              }
-                            }
-                            return CXChildVisit_Recurse;
-                          },
-                          &visitor_data);
-                      if(visitor_data.parent)
-                        cursor = visitor_data.parent;
-                    }
+boost::optional<Source::ClangViewParse::TypeTooltipContent> Source::ClangViewParse::get_type_tooltip_content(const clangmm::Token &token) {
+  auto cursor = token.get_cursor();
+  auto token_spelling = token.get_spelling();
+  if(!cursor.get_referenced() && token_spelling != "this" && token_spelling != "[" && token_spelling != "]" && token_spelling != "*" && token_spelling != "&")
+    return {};
 
-                    // Check children
-                    std::vector<clangmm::Cursor> children;
-                    clang_visitChildren(
-                        cursor.cx_cursor, [](CXCursor cx_cursor, CXCursor /*parent*/, CXClientData data) {
-                          static_cast<std::vector<clangmm::Cursor> *>(data)->emplace_back(cx_cursor);
-                          return CXChildVisit_Continue;
-                        },
-                        &children);
-
-                    // Check if expression can be called without altering state
-                    bool call_expression = true;
-                    for(auto &child : children) {
-                      if(!is_safe(child)) {
-                        call_expression = false;
-                        break;
-                      }
-                    }
+  auto type_description = cursor.get_type_description();
+  remove_internal_namespaces(type_description);
+  size_t pos = 0;
+  // Simplify std::basic_string types
+  while((pos = type_description.find("std::basic_string<char", pos)) != std::string::npos) {
+    pos += 22; // Move to after std::basic_string<char
+    if(pos < type_description.size()) {
+      if(type_description[pos] == '>') {
+        pos -= 17; // Move to after std::
+        type_description.replace(pos, 17 + 1, "string");
+        pos += 6; // Move to after std::string
+        // Remove space before ending angle bracket
+        if(pos + 1 < type_description.size() && type_description[pos] == ' ' && type_description[pos + 1] == '>')
+          type_description.erase(pos, 1);
+      }
+      else if((starts_with(type_description, pos, ", std::char_traits<char>, std::allocator<char> >"))) {
+        pos -= 17; // Move to after std::
+        type_description.replace(pos, 17 + 48, "string");
+        pos += 6; // Move to after std::string
+        // Remove space before ending angle bracket
+        if(pos + 1 < type_description.size() && type_description[pos] == ' ' && type_description[pos + 1] == '>')
+          type_description.erase(pos, 1);
+      }
+    }
+  }
+  // Add parameter names
+  if((pos = type_description.find('(')) != std::string::npos) {
+    pos++;
+    if(pos < type_description.size() && type_description[pos] != ')') {
+      auto arguments = cursor.get_referenced().get_arguments();
+      size_t current_argument = 0;
+      int para_count = 0;
+      int angle_count = 0;
+      do {
+        if(para_count == 0 && angle_count == 0 && (type_description[pos] == ',' || type_description[pos] == ')')) {
+          if(current_argument < arguments.size()) {
+            auto argument_spelling = arguments[current_argument].get_spelling();
+            if(!argument_spelling.empty()) {
+              if(type_description[pos - 1] != '*' && type_description[pos - 1] != '&')
+                type_description.insert(pos++, " ");
+              type_description.insert(pos, argument_spelling);
+              pos += argument_spelling.size();
+            }
+          }
+          if(type_description[pos] == ',') {
+            ++current_argument;
+            ++pos; // skip ' ' after ','
+          }
+          else
+            break;
+        }
+        else if(type_description[pos] == '(')
+          ++para_count;
+        else if(type_description[pos] == ')')
+          --para_count;
+        else if(type_description[pos] == '<')
+          ++angle_count;
+        else if(type_description[pos] == '>')
+          --angle_count;
+        ++pos;
+      } while(pos < type_description.size());
+    }
+  }
+  return TypeTooltipContent{std::move(type_description), clangmm::to_string(clang_Cursor_getRawCommentText(cursor.get_referenced().cx_cursor))};
+}
 
-                    if(call_expression) {
-                      offsets = cursor.get_source_range().get_offsets();
-                      start = get_iter_at_line_index(offsets.first.line - 1, offsets.first.index - 1);
-                      end = get_iter_at_line_index(offsets.second.line - 1, offsets.second.index - 1);
-
-                      expression = get_buffer()->get_text(start, end).raw();
-
-                      if(!expression.empty()) {
-                        // Check for C-like assignment/increment/decrement (non-const) operators
-                        char last_last_chr = 0;
-                        char last_chr = expression[0];
-                        for(size_t i = 1; i < expression.size(); ++i) {
-                          auto &chr = expression[i];
-                          if((last_chr == '+' && (chr == '+' || chr == '=')) ||
-                             (last_chr == '-' && (chr == '-' || chr == '=')) ||
-                             (last_chr == '*' && chr == '=') ||
-                             (last_chr == '/' && chr == '=') ||
-                             (last_chr == '%' && chr == '=') ||
-                             (last_chr == '&' && chr == '=') ||
-                             (last_chr == '|' && chr == '=') ||
-                             (last_chr == '^' && chr == '=') ||
-                             // <<= >>=
-                             (chr == '=' && ((last_last_chr == '<' && last_chr == '<') || (last_last_chr == '>' && last_chr == '>'))) ||
-                             // Checks for = (not ==. .== !=. <=. >=. <=>)
-                             (last_chr == '=' && last_last_chr != '=' && chr != '=' && last_last_chr != '!' && last_last_chr != '<' && last_last_chr != '>' &&
-                              !(last_last_chr == '<' && chr == '>'))) {
-                            call_expression = false;
-                            break;
-                          }
-                          last_last_chr = last_chr;
-                          last_chr = chr;
-                        }
+void Source::ClangViewParse::show_type_tooltip(size_t token_index, const TypeTooltipContent &content) {
+  auto &token = (*clang_tokens)[token_index];
+  auto &token_offsets = clang_tokens_offsets[token_index];
+  auto start = get_buffer()->get_iter_at_line_index(token_offsets.first.line - 1, token_offsets.first.index - 1);
+  auto end = get_buffer()->get_iter_at_line_index(token_offsets.second.line - 1, token_offsets.second.index - 1);
 
-                        if(call_expression)
-                          debug_value = Debug::LLDB::get().get_value(expression);
-                      }
-                    }
-                  }
-                }
-                if(debug_value.empty()) {
-                  value_type = "Return value";
-                  auto offsets = token.get_source_range().get_offsets();
-                  debug_value = Debug::LLDB::get().get_return_value(token.get_source_location().get_path(), offsets.first.line, offsets.first.index);
-                }
-                if(!debug_value.empty()) {
-                  size_t pos = debug_value.find(" = ");
-                  if(pos != Glib::ustring::npos) {
-                    Glib::ustring::iterator iter;
-                    while(!debug_value.validate(iter)) {
-                      auto next_char_iter = iter;
-                      next_char_iter++;
-                      debug_value.replace(iter, next_char_iter, "?");
+  type_tooltips.clear();
+  type_tooltips.emplace_back(this, start, end, [this, token, content](Tooltip &tooltip) {
+    tooltip.insert_code(content.type_description, language);
+
+    if(!content.doxygen.empty()) {
+      tooltip.buffer->insert_at_cursor("\n\n");
+      tooltip.insert_doxygen(content.doxygen, true);
+    }
+
+#ifdef JUCI_ENABLE_DEBUG
+    if(Debug::LLDB::get().is_stopped()) {
+      auto cursor = token.get_cursor();
+      auto is_variable = [](clangmm::Cursor::Kind kind) {
+        return kind == clangmm::Cursor::Kind::FieldDecl || kind == clangmm::Cursor::Kind::EnumConstantDecl || kind == clangmm::Cursor::Kind::VarDecl || kind == clangmm::Cursor::Kind::ParmDecl;
+      };
+      auto is_function = [](clangmm::Cursor::Kind kind) {
+        return kind == clangmm::Cursor::Kind::CXXMethod || kind == clangmm::Cursor::Kind::FunctionDecl ||
+               kind == clangmm::Cursor::Kind::Constructor || kind == clangmm::Cursor::Kind::Destructor ||
+               kind == clangmm::Cursor::Kind::FunctionTemplate || kind == clangmm::Cursor::Kind::ConversionFunction;
+      };
+
+      Glib::ustring value_type = "Value";
+      Glib::ustring debug_value;
+      auto referenced = cursor.get_referenced();
+      auto kind = clangmm::Cursor::Kind::UnexposedDecl;
+      if(referenced) {
+        kind = referenced.get_kind();
+        if(is_variable(kind)) {
+          auto location = referenced.get_source_location();
+          auto offset = location.get_offset();
+          debug_value = Debug::LLDB::get().get_value(token.get_spelling(), location.get_path(), offset.line, offset.index);
+        }
+      }
+      if(debug_value.empty() && (kind == clangmm::Cursor::Kind::UnexposedDecl || is_variable(kind) || is_function(kind))) {
+        // Attempt to get value from expression (for instance: (*a).b.c, or: (*d)[1 + 1])
+        auto is_safe = [&is_function](const clangmm::Cursor &cursor) {
+          auto referenced = cursor.get_referenced();
+          if(!referenced)
+            return true;
+          if(is_function(referenced.get_kind()))
+            return clang_CXXMethod_isConst(referenced.cx_cursor) || referenced.get_spelling() == "operator[]"; // operator[] is passed even without being const for convenience purposes
+          return true;
+        };
+
+        if(is_safe(cursor)) { // Do not call state altering expressions
+          auto offsets = cursor.get_source_range().get_offsets();
+          auto start = get_iter_at_line_index(offsets.first.line - 1, offsets.first.index - 1);
+          auto end = get_iter_at_line_index(offsets.second.line - 1, offsets.second.index - 1);
+
+          std::string expression;
+          // Get full expression from cursor parent:
+          if(*start == '[' || (kind == clangmm::Cursor::Kind::CXXMethod && (*start == '<' || *start == '>' || *start == '=' || *start == '!' ||
+                                                                            *start == '+' || *start == '-' || *start == '*' || *start == '/' ||
+                                                                            *start == '%' || *start == '&' || *start == '|' || *start == '^' ||
+                                                                            *end == '('))) {
+            struct VisitorData {
+              std::pair<clangmm::Offset, clangmm::Offset> offsets;
+              std::string spelling;
+              clangmm::Cursor parent; // Output
+            };
+            VisitorData visitor_data{cursor.get_source_range().get_offsets(), cursor.get_spelling(), {}};
+            auto start_cursor = cursor;
+            for(auto parent = cursor.get_semantic_parent();
+                parent.get_kind() != clangmm::Cursor::Kind::TranslationUnit &&
+                parent.get_kind() != clangmm::Cursor::Kind::ClassDecl;
+                parent = parent.get_semantic_parent())
+              start_cursor = parent;
+            clang_visitChildren(
+                start_cursor.cx_cursor, [](CXCursor cx_cursor, CXCursor cx_parent, CXClientData data_) {
+                  auto data = static_cast<VisitorData *>(data_);
+                  if(clangmm::Cursor(cx_cursor).get_source_range().get_offsets() == data->offsets) {
+                    auto parent = clangmm::Cursor(cx_parent);
+                    if(parent.get_spelling() == data->spelling) {
+                      data->parent = parent;
+                      return CXChildVisit_Break;
                     }
-                    tooltip.buffer->insert(tooltip.buffer->get_insert()->get_iter(), (tooltip.buffer->size() > 0 ? "\n\n" : "") + value_type + ":\n");
-                    auto value = debug_value.substr(pos + 3, debug_value.size() - (pos + 3) - 1).raw();
-                    remove_internal_namespaces(value);
-                    tooltip.insert_code(value);
                   }
+                  return CXChildVisit_Recurse;
+                },
+                &visitor_data);
+            if(visitor_data.parent)
+              cursor = visitor_data.parent;
+          }
+
+          // Check children
+          std::vector<clangmm::Cursor> children;
+          clang_visitChildren(
+              cursor.cx_cursor, [](CXCursor cx_cursor, CXCursor /*parent*/, CXClientData data) {
+                static_cast<std::vector<clangmm::Cursor> *>(data)->emplace_back(cx_cursor);
+                return CXChildVisit_Continue;
+              },
+              &children);
+
+          // Check if expression can be called without altering state
+          bool call_expression = true;
+          for(auto &child : children) {
+            if(!is_safe(child)) {
+              call_expression = false;
+              break;
+            }
+          }
+
+          if(call_expression) {
+            offsets = cursor.get_source_range().get_offsets();
+            start = get_iter_at_line_index(offsets.first.line - 1, offsets.first.index - 1);
+            end = get_iter_at_line_index(offsets.second.line - 1, offsets.second.index - 1);
+
+            expression = get_buffer()->get_text(start, end).raw();
+
+            if(!expression.empty()) {
+              // Check for C-like assignment/increment/decrement (non-const) operators
+              char last_last_chr = 0;
+              char last_chr = expression[0];
+              for(size_t i = 1; i < expression.size(); ++i) {
+                auto &chr = expression[i];
+                if((last_chr == '+' && (chr == '+' || chr == '=')) ||
+                   (last_chr == '-' && (chr == '-' || chr == '=')) ||
+                   (last_chr == '*' && chr == '=') ||
+                   (last_chr == '/' && chr == '=') ||
+                   (last_chr == '%' && chr == '=') ||
+                   (last_chr == '&' && chr == '=') ||
+                   (last_chr == '|' && chr == '=') ||
+                   (last_chr == '^' && chr == '=') ||
+                   // <<= >>=
+                   (chr == '=' && ((last_last_chr == '<' && last_chr == '<') || (last_last_chr == '>' && last_chr == '>'))) ||
+                   // Checks for = (not ==. .== !=. <=. >=. <=>)
+                   (last_chr == '=' && last_last_chr != '=' && chr != '=' && last_last_chr != '!' && last_last_chr != '<' && last_last_chr != '>' &&
+                    !(last_last_chr == '<' && chr == '>'))) {
+                  call_expression = false;
+                  break;
                 }
+                last_last_chr = last_chr;
+                last_chr = chr;
               }
-#endif
-            });
-            type_tooltips.show();
-            return;
+
+              if(call_expression)
+                debug_value = Debug::LLDB::get().get_value(expression);
+            }
+          }
+        }
+      }
+      if(debug_value.empty()) {
+        value_type = "Return value";
+        auto offsets = token.get_source_range().get_offsets();
+        debug_value = Debug::LLDB::get().get_return_value(token.get_source_location().get_path(), offsets.first.line, offsets.first.index);
+      }
+      if(!debug_value.empty()) {
+        size_t pos = debug_value.find(" = ");
+        if(pos != Glib::ustring::npos) {
+          Glib::ustring::iterator iter;
+          while(!debug_value.validate(iter)) {
+            auto next_char_iter = iter;
+            next_char_iter++;
+            debug_value.replace(iter, next_char_iter, "?");
           }
+          tooltip.buffer->insert(tooltip.buffer->get_insert()->get_iter(), (tooltip.buffer->size() > 0 ? "\n\n" : "") + value_type + ":\n");
+          auto value = debug_value.substr(pos + 3, debug_value.size() - (pos + 3) - 1).raw();
+          remove_internal_namespaces(value);
+          tooltip.insert_code(value);
         }
       }
     }
-  }
+#endif
+  });
+  type_tooltips.show();
+}
+
+void Source::ClangViewParse::join_type_tooltips_thread() {
+  ++type_tooltips_request_count;
+  if(type_tooltips_thread.joinable())
+    type_tooltips_thread.join();
 }
 
 void Source::ClangViewParse::remove_internal_namespaces(std::string &type) {
@@ -821,7 +1063,6 @@ Source::ClangViewAutocomplete::ClangViewAutocomplete(const boost::filesystem::pa
 
   autocomplete.reparse = [this] {
     selected_completion_string = nullptr;
-    code_complete_results = nullptr;
     soft_reparse(true);
   };
 
@@ -972,7 +1213,7 @@ Source::ClangViewAutocomplete::ClangViewAutocomplete(const boost::filesystem::pa
   };
 
   autocomplete.after_add_rows = [this] {
-    status_state = "";
+    status_state = get_memory_usage_status();
     if(update_status_state)
       update_status_state(this);
   };
@@ -987,9 +1228,16 @@ Source::ClangViewAutocomplete::ClangViewAutocomplete(const boost::filesystem::pa
   autocomplete.add_rows = [this](std::string &buffer, int line, int line_index) {
     if(is_language({"chdr", "cpphdr"}))
       clangmm::remove_include_guard(buffer);
-    code_complete_results = std::make_unique<clangmm::CodeCompleteResults>(clang_tu->get_code_completions(buffer, line + 1, line_index + 1));
-    if(!code_complete_results->cx_results)
-      return false;
+    auto key = get_completion_key(buffer, line, line_index);
+    if(!code_complete_results || key != completion_results_key) {
+      code_complete_results = std::make_unique<clangmm::CodeCompleteResults>(clang_tu->get_code_completions(buffer, line + 1, line_index + 1));
+      if(!code_complete_results->cx_results) {
+        code_complete_results = nullptr;
+        return false;
+      }
+      completion_results_key = key;
+      update_completion_results();
+    }
 
     if(autocomplete.state == Autocomplete::State::starting) {
       std::string prefix;
@@ -998,70 +1246,27 @@ Source::ClangViewAutocomplete::ClangViewAutocomplete(const boost::filesystem::pa
         prefix = autocomplete.prefix;
       }
 
+      // Only results matching the previous prefix can match a longer prefix
+      if(!completion_matches_prefix || !starts_with(prefix, *completion_matches_prefix)) {
+        completion_matches.clear();
+        for(size_t i = 0; i < completion_results.size(); ++i)
+          completion_matches.emplace_back(i);
+      }
+      if(!show_parameters) {
+        completion_matches.erase(std::remove_if(completion_matches.begin(), completion_matches.end(), [this, &prefix](size_t i) {
+                                   return !starts_with(completion_results[i].typed_text, prefix);
+                                 }),
+                                 completion_matches.end());
+      }
+      completion_matches_prefix = prefix;
+
       completion_strings.clear();
       snippet_inserts.clear();
       snippet_comments.clear();
-      for(unsigned i = 0; i < code_complete_results->size(); ++i) {
-        auto result = code_complete_results->get(i);
-        if(result.available()) {
-          std::string text;
-          if(show_parameters) {
-            class Recursive {
-            public:
-              static void f(const clangmm::CompletionString &completion_string, std::string &text) {
-                for(unsigned i = 0; i < completion_string.get_num_chunks(); ++i) {
-                  auto kind = static_cast<clangmm::CompletionChunkKind>(clang_getCompletionChunkKind(completion_string.cx_completion_string, i));
-                  if(kind == clangmm::CompletionChunk_Optional)
-                    f(clangmm::CompletionString(clang_getCompletionChunkCompletionString(completion_string.cx_completion_string, i)), text);
-                  else if(kind == clangmm::CompletionChunk_CurrentParameter) {
-                    auto chunk_cstr = clangmm::String(clang_getCompletionChunkText(completion_string.cx_completion_string, i));
-                    text += chunk_cstr.c_str;
-                  }
-                }
-              }
-            };
-            Recursive::f(result, text);
-            if(!text.empty()) {
-              bool already_added = false;
-              for(auto &row : autocomplete.rows) {
-                if(row == text) {
-                  already_added = true;
-                  break;
-                }
-              }
-              if(!already_added) {
-                autocomplete.rows.emplace_back(std::move(text));
-                completion_strings.emplace_back(result.cx_completion_string);
-              }
-            }
-          }
-          else {
-            std::string return_text;
-            bool match = false;
-            for(unsigned i = 0; i < result.get_num_chunks(); ++i) {
-              auto kind = static_cast<clangmm::CompletionChunkKind>(clang_getCompletionChunkKind(result.cx_completion_string, i));
-              if(kind != clangmm::CompletionChunk_Informative) {
-                auto chunk_cstr = clangmm::String(clang_getCompletionChunkText(result.cx_completion_string, i));
-                if(kind == clangmm::CompletionChunk_TypedText) {
-                  if(starts_with(chunk_cstr.c_str, prefix))
-                    match = true;
-                  else
-                    break;
-                }
-                if(kind == clangmm::CompletionChunk_ResultType)
-                  return_text = std::string(" → ") + chunk_cstr.c_str;
-                else
-                  text += chunk_cstr.c_str;
-              }
-            }
-            if(match && !text.empty()) {
-              if(!return_text.empty())
-                text += return_text;
-              autocomplete.rows.emplace_back(std::move(text));
-              completion_strings.emplace_back(result.cx_completion_string);
-            }
-          }
-        }
+      for(auto i : completion_matches) {
+        auto &result = completion_results[i];
+        autocomplete.rows.emplace_back(result.return_text.empty() ? result.text : result.text + result.return_text);
+        completion_strings.emplace_back(result.cx_completion_string);
       }
       if(!show_parameters && enable_snippets) {
         LockGuard lock(snippets_mutex);
@@ -1086,7 +1291,6 @@ Source::ClangViewAutocomplete::ClangViewAutocomplete(const boost::filesystem::pa
 
   autocomplete.on_hide = [this] {
     selected_completion_string = nullptr;
-    code_complete_results = nullptr;
   };
 
   autocomplete.on_change = [this](boost::optional<unsigned int> index, const std::string &text) {
@@ -1205,6 +1409,95 @@ Source::ClangViewAutocomplete::ClangViewAutocomplete(const boost::filesystem::pa
   };
 }
 
+size_t Source::ClangViewAutocomplete::get_completion_key(const std::string &buffer, int line, int line_index) {
+  // The word at the completion position is replaced with spaces, and the spaces are ignored
+  // so that the key is the same while the word is being typed
+  size_t offset = 0;
+  for(int c = 0; c < line && offset != std::string::npos; ++c) {
+    offset = buffer.find('\n', offset);
+    if(offset != std::string::npos)
+      ++offset;
+  }
+  if(offset == std::string::npos)
+    offset = buffer.size();
+  offset = std::min(offset + static_cast<size_t>(line_index), buffer.size());
+  auto end = buffer.find_first_not_of(' ', offset);
+  if(end == std::string::npos)
+    end = buffer.size();
+
+  std::hash<std::string> hash;
+  auto key = hash(buffer.substr(0, offset));
+  auto combine = [&key](size_t value) {
+    key ^= value + 0x9e3779b9 + (key << 6) + (key >> 2);
+  };
+  combine(hash(buffer.substr(end)));
+  combine(dependencies_version);
+  combine(show_parameters ? 1 : 0);
+  return key;
+}
+
+void Source::ClangViewAutocomplete::update_completion_results() {
+  completion_results.clear();
+  completion_matches.clear();
+  completion_matches_prefix = boost::none;
+
+  for(unsigned i = 0; i < code_complete_results->size(); ++i) {
+    auto result = code_complete_results->get(i);
+    if(!result.available())
+      continue;
+    CompletionResult completion_result;
+    completion_result.cx_completion_string = result.cx_completion_string;
+    if(show_parameters) {
+      class Recursive {
+      public:
+        static void f(const clangmm::CompletionString &completion_string, std::string &text) {
+          for(unsigned i = 0; i < completion_string.get_num_chunks(); ++i) {
+            auto kind = static_cast<clangmm::CompletionChunkKind>(clang_getCompletionChunkKind(completion_string.cx_completion_string, i));
+            if(kind == clangmm::CompletionChunk_Optional)
+              f(clangmm::CompletionString(clang_getCompletionChunkCompletionString(completion_string.cx_completion_string, i)), text);
+            else if(kind == clangmm::CompletionChunk_CurrentParameter) {
+              auto chunk_cstr = clangmm::String(clang_getCompletionChunkText(completion_string.cx_completion_string, i));
+              text += chunk_cstr.c_str;
+            }
+          }
+        }
+      };
+      Recursive::f(result, completion_result.text);
+      if(completion_result.text.empty())
+        continue;
+      bool already_added = false;
+      for(auto &added_result : completion_results) {
+        if(added_result.text == completion_result.text) {
+          already_added = true;
+          break;
+        }
+      }
+      if(!already_added)
+        completion_results.emplace_back(std::move(completion_result));
+    }
+    else {
+      bool has_typed_text = false;
+      for(unsigned i = 0; i < result.get_num_chunks(); ++i) {
+        auto kind = static_cast<clangmm::CompletionChunkKind>(clang_getCompletionChunkKind(result.cx_completion_string, i));
+        if(kind != clangmm::CompletionChunk_Informative) {
+          auto chunk_cstr = clangmm::String(clang_getCompletionChunkText(result.cx_completion_string, i));
+          if(kind == clangmm::CompletionChunk_TypedText) {
+            if(!has_typed_text)
+              completion_result.typed_text = chunk_cstr.c_str;
+            has_typed_text = true;
+          }
+          if(kind == clangmm::CompletionChunk_ResultType)
+            completion_result.return_text = std::string(" → ") + chunk_cstr.c_str;
+          else
+            completion_result.text += chunk_cstr.c_str;
+        }
+      }
+      if(has_typed_text && !completion_result.text.empty())
+        completion_results.emplace_back(std::move(completion_result));
+    }
+  }
+}
+
 const std::unordered_map<std::string, std::string> &Source::ClangViewAutocomplete::autocomplete_manipulators_map() {
   //TODO: feel free to add more
   static std::unordered_map<std::string, std::string> map = {
@@ -1250,8 +1543,10 @@ Source::ClangViewRefactor::ClangViewRefactor(const boost::filesystem::path &file
       translation_units.emplace_back(clang_tu.get());
       for(auto &view : views) {
         if(view != this) {
-          if(auto clang_view = dynamic_cast<Source::ClangView *>(view))
-            translation_units.emplace_back(clang_view->clang_tu.get());
+          if(auto clang_view = dynamic_cast<Source::ClangView *>(view)) {
+            if(clang_view->clang_tu) // Usages of unloaded translation units are cached
+              translation_units.emplace_back(clang_view->clang_tu.get());
+          }
         }
       }
 
@@ -1505,6 +1800,8 @@ Source::ClangViewRefactor::ClangViewRefactor(const boost::filesystem::path &file
         auto identifier_usr = identifier.cursor.get_usr();
         for(auto &view : views) {
           if(auto clang_view = dynamic_cast<Source::ClangView *>(view)) {
+            if(!clang_view->clang_tokens)
+              continue;
             for(auto &token : *clang_view->clang_tokens) {
               auto cursor = token.get_cursor();
               auto cursor_kind = cursor.get_kind();
@@ -1723,8 +2020,10 @@ Source::ClangViewRefactor::ClangViewRefactor(const boost::filesystem::path &file
       translation_units.emplace_back(clang_tu.get());
       for(auto &view : views) {
         if(view != this) {
-          if(auto clang_view = dynamic_cast<Source::ClangView *>(view))
-            translation_units.emplace_back(clang_view->clang_tu.get());
+          if(auto clang_view = dynamic_cast<Source::ClangView *>(view)) {
+            if(clang_view->clang_tu) // Usages of unloaded translation units are cached
+              translation_units.emplace_back(clang_view->clang_tu.get());
+          }
         }
       }
 
@@ -2012,7 +2311,7 @@ bool Source::ClangViewRefactor::wait_parsing() {
   std::vector<Source::ClangView *> not_parsed_clang_views;
   for(auto &view : views) {
     if(auto clang_view = dynamic_cast<Source::ClangView *>(view)) {
-      if(!clang_view->parsed && !clang_view->selected_completion_string)
+      if(!clang_view->parsed && !clang_view->selected_completion_string && clang_view->parse_state != ParseState::unloaded)
         not_parsed_clang_views.emplace_back(clang_view);
     }
   }
@@ -2033,7 +2332,7 @@ bool Source::ClangViewRefactor::wait_parsing() {
           Info::get().print("Canceled due to parsing error in " + clang_view->file_path.string());
           return false;
         }
-        if(!clang_view->parsed)
+        if(!clang_view->parsed && clang_view->parse_state != ParseState::unloaded)
           ++not_parsed;
       }
       if(not_parsed == 0)
@@ -2053,8 +2352,8 @@ void Source::ClangViewRefactor::apply_similar_symbol_tag() {
   get_buffer()->remove_tag(similar_symbol_tag, get_buffer()->begin(), get_buffer()->end());
   auto identifier = get_identifier();
   if(identifier) {
-    auto offsets = clang_tokens->get_similar_token_offsets(identifier.kind, identifier.spelling, identifier.cursor.get_all_usr_extended());
-    for(auto &offset : offsets) {
+    for(auto token_index : similar_tokens.get_token_indices(identifier.kind, identifier.spelling, identifier.cursor.get_all_usr_extended())) {
+      auto &offset = clang_tokens_offsets[token_index];
       auto start_iter = get_buffer()->get_iter_at_line_index(offset.first.line - 1, offset.first.index - 1);
       auto end_iter = get_buffer()->get_iter_at_line_index(offset.second.line - 1, offset.second.index - 1);
       get_buffer()->apply_tag(similar_symbol_tag, start_iter, end_iter);
@@ -2101,6 +2400,14 @@ Source::ClangView::ClangView(const boost::filesystem::path &file_path, const Gli
       delete_thread.join();
     delete this;
   });
+
+  last_focus_time = std::chrono::steady_clock::now();
+  signal_focus_in_event().connect([this](GdkEventFocus *) {
+    last_focus_time = std::chrono::steady_clock::now();
+    if(parse_state == ParseState::unloaded)
+      full_reparse();
+    return false;
+  });
 }
 
 void Source::ClangView::full_reparse() {
@@ -2109,6 +2416,13 @@ void Source::ClangView::full_reparse() {
   delayed_reparse_connection.disconnect();
   delayed_full_reparse_connection.disconnect();
 
+  if(parse_state == ParseState::unloaded) {
+    full_reparse_needed = false;
+    Usages::Clang::erase_cache(file_path);
+    parse_initialize();
+    return;
+  }
+
   if(parse_state != ParseState::processing)
     return;
 
@@ -2161,18 +2475,21 @@ void Source::ClangView::async_delete() {
   Usages::Clang::cache_in_progress();
 
   delayed_reparse_connection.disconnect();
-  if(full_reparse_needed)
+  if(parse_state == ParseState::unloaded) {
+    // Usages were cached when the translation unit was unloaded
+  }
+  else if(full_reparse_needed)
     full_reparse();
   else if(soft_reparse_needed || !parsed)
     soft_reparse();
 
   auto before_parse_time = std::time(nullptr);
   delete_thread = std::thread([this, before_parse_time, project_paths_in_use = std::move(project_paths_in_use), buffer_modified = get_buffer()->get_modified()] {
-    while(!parsed && parse_state != ParseState::stop)
+    while(!parsed && parse_state != ParseState::stop && parse_state != ParseState::unloaded)
       std::this_thread::sleep_for(std::chrono::milliseconds(10));
     parse_state = ParseState::stop;
 
-    if(buffer_modified) {
+    if(buffer_modified && clang_tu) {
       std::ifstream stream(file_path.string(), std::ios::binary);
       if(stream) {
         std::string buffer;
@@ -2199,6 +2516,89 @@ void Source::ClangView::async_delete() {
       parse_thread.join();
     if(autocomplete.thread.joinable())
       autocomplete.thread.join();
+    join_type_tooltips_thread();
     do_delete_object();
   });
 }
+
+void Source::ClangView::unload() {
+  auto expected = ParseState::processing;
+  if(!parse_state.compare_exchange_strong(expected, ParseState::restarting))
+    return;
+  parsed = false;
+  delayed_reparse_connection.disconnect();
+  delayed_full_reparse_connection.disconnect();
+  parse_process_state = ParseProcessState::idle;
+  autocomplete.state = Autocomplete::State::idle;
+
+  auto build = Project::Build::create(file_path);
+  std::set<boost::filesystem::path> project_paths_in_use;
+  if(!build->project_path.empty())
+    project_paths_in_use.emplace(build->project_path);
+  Usages::Clang::cache_in_progress();
+
+  full_reparse_running = true;
+  if(full_reparse_thread.joinable())
+    full_reparse_thread.join();
+  full_reparse_thread = std::thread([this, project_path = build->project_path, build_path = build->get_default_path(), before_parse_time = std::time(nullptr), project_paths_in_use = std::move(project_paths_in_use)] {
+    if(parse_thread.joinable())
+      parse_thread.join();
+    if(autocomplete.thread.joinable())
+      autocomplete.thread.join();
+    join_type_tooltips_thread();
+
+    if(clang_tokens)
+      Usages::Clang::cache(project_path, build_path, file_path, before_parse_time, project_paths_in_use, clang_tu.get(), clang_tokens.get());
+    else
+      Usages::Clang::cancel_cache_in_progress();
+
+    dispatcher.post([this] {
+      selected_completion_string = nullptr;
+      code_complete_results = nullptr;
+      completion_strings.clear();
+      clang_tokens.reset();
+      clang_tokens_offsets.clear();
+      clang_tokens_offsets.shrink_to_fit();
+      similar_tokens = SimilarTokens();
+      clang_tu.reset();
+      memory_usage = 0;
+      parse_state = ParseState::unloaded;
+      full_reparse_running = false;
+      status_state = "";
+      if(update_status_state)
+        update_status_state(this);
+
+      // The buffer was focused while unloading
+      if(is_focus())
+        full_reparse();
+    });
+  });
+}
+
+void Source::ClangView::apply_memory_budget() {
+  auto budget = static_cast<size_t>(Config::get().source.clang_memory_budget) * 1024 * 1024;
+  if(budget == 0)
+    return;
+
+  size_t memory_usage = 0;
+  std::vector<ClangView *> unloadable_views;
+  for(auto &view : views) {
+    if(auto clang_view = dynamic_cast<ClangView *>(view)) {
+      memory_usage += clang_view->memory_usage;
+      if(clang_view->parsed && !clang_view->full_reparse_running && !clang_view->is_focus() && !clang_view->get_buffer()->get_modified())
+        unloadable_views.emplace_back(clang_view);
+    }
+  }
+  if(memory_usage <= budget)
+    return;
+
+  std::sort(unloadable_views.begin(), unloadable_views.end(), [](ClangView *a, ClangView *b) {
+    return a->last_focus_time < b->last_focus_time;
+  });
+  for(auto &clang_view : unloadable_views) {
+    if(memory_usage <= budget)
+      break;
+    memory_usage -= clang_view->memory_usage;
+    clang_view->unload();
+  }
+}
@@ -5,10 +5,14 @@
 #include "mutex.hpp"
 #include "source.hpp"
 #include "terminal.hpp"
+#include "translation_unit_cache.hpp"
 #include <atomic>
+#include <chrono>
 #include <map>
 #include <set>
 #include <thread>
+#include <unordered_map>
+#include <unordered_set>
 
 namespace Source {
   class ClangViewParse : public View {
@@ -16,6 +20,8 @@ namespace Source {
     enum class ParseState {
       processing,
       restarting,
+      /// Translation unit was unloaded to stay within the memory budget, and is parsed again when needed
+      unloaded,
       stop
     };
     enum class ParseProcessState {
@@ -41,6 +47,28 @@ namespace Source {
     std::unique_ptr<clangmm::TranslationUnit> clang_tu;
     std::unique_ptr<clangmm::Tokens> clang_tokens;
     std::vector<std::pair<clangmm::Offset, clangmm::Offset>> clang_tokens_offsets;
+    /// Identifier tokens of clang_tokens grouped by referenced cursor, so that similar symbols can be found
+    /// without resolving the cursors of all the tokens. Built after each parse.
+    class SimilarTokens {
+      class Cursor {
+      public:
+        clangmm::Cursor::Kind kind;
+        std::string spelling;
+        std::unordered_set<std::string> usrs;
+        std::vector<size_t> token_indices;
+      };
+      std::vector<Cursor> cursors;
+      /// Key: usr, value: indices of the cursors with this usr
+      std::unordered_map<std::string, std::vector<size_t>> usr_cursors;
+
+    public:
+      SimilarTokens() = default;
+      SimilarTokens(clangmm::Tokens &tokens);
+
+      /// Returns the indices, in increasing order, of the tokens similar to the given cursor
+      std::vector<size_t> get_token_indices(clangmm::Cursor::Kind kind, const std::string &spelling, const std::unordered_set<std::string> &usrs) const;
+    };
+    SimilarTokens similar_tokens;
     sigc::connection delayed_reparse_connection;
     sigc::connection delayed_full_reparse_connection;
 
@@ -50,21 +78,55 @@ namespace Source {
     std::thread parse_thread;
     std::atomic<ParseState> parse_state;
     std::atomic<ParseProcessState> parse_process_state;
+    /// Memory used by clang_tu in bytes, updated after each parse
+    std::atomic<size_t> memory_usage = {0};
+    void update_memory_usage();
+    std::string get_memory_usage_status() const;
 
     CXCompletionString selected_completion_string = nullptr;
+    /// Incremented when included files or compile arguments might have changed
+    std::atomic<size_t> dependencies_version = {0};
+    /// Incremented each time the translation unit has been parsed
+    std::atomic<size_t> parse_count = {0};
+
+    /// Incremented when the mouse moves or type tooltips are requested, which cancels the type tooltip being resolved
+    std::atomic<size_t> type_tooltips_request_count = {0};
+    std::thread type_tooltips_thread;
+    /// Must be called before clang_tu is replaced or reset
+    void join_type_tooltips_thread();
 
   private:
-    Glib::ustring parse_thread_buffer GUARDED_BY(parse_mutex);
+    std::shared_ptr<const std::string> parse_thread_buffer GUARDED_BY(parse_mutex);
 
     static const std::map<int, std::string> &clang_types();
     void update_syntax() REQUIRES(parse_mutex);
+    /// Highlights the buffer from a saved translation unit, if any. Returns false if none was found.
+    /// buffer_size is the size in bytes of the buffer text.
+    bool update_syntax_from_cache(size_t buffer_size) REQUIRES(parse_mutex);
+    /// Returns -1 if the identifier should not be highlighted
+    static int get_identifier_syntax_type(const clangmm::Cursor &cursor);
+    /// Lines and indices start at 1, as in clangmm::Offset
+    void apply_syntax_tag(int type, unsigned start_line, unsigned start_index, unsigned end_line, unsigned end_index);
     std::map<int, Glib::RefPtr<Gtk::TextTag>> syntax_tags;
+    std::unique_ptr<TranslationUnitCache> translation_unit_cache;
 
     void update_diagnostics() REQUIRES(parse_mutex);
     std::vector<clangmm::Diagnostic> clang_diagnostics GUARDED_BY(parse_mutex);
 
     /// Removes for instance ::__1:: and ::__cxx11:: from type
     void remove_internal_namespaces(std::string &type);
+
+    class TypeTooltipContent {
+    public:
+      std::string type_description;
+      std::string doxygen;
+    };
+    /// Type tooltip contents of the tokens of the last parse. Key: token index, value: boost::none if the token has no type tooltip.
+    std::map<size_t, boost::optional<TypeTooltipContent>> type_tooltip_contents;
+    size_t type_tooltip_contents_parse_count = 0;
+    /// Returns boost::none if the token has no type tooltip
+    boost::optional<TypeTooltipContent> get_type_tooltip_content(const clangmm::Token &token) REQUIRES(parse_mutex);
+    void show_type_tooltip(size_t token_index, const TypeTooltipContent &content);
   };
 
   class ClangViewAutocomplete : public virtual ClangViewParse {
@@ -84,6 +146,24 @@ namespace Source {
   private:
     std::atomic<bool> show_parameters = {false};
 
+    class CompletionResult {
+    public:
+      CXCompletionString cx_completion_string;
+      std::string typed_text;
+      /// Row text without return type, or the current parameter when showing parameters
+      std::string text;
+      std::string return_text;
+    };
+    /// Available results of code_complete_results. The results are reused while completing at the
+    /// same position in an otherwise unchanged buffer, instead of running code completion again.
+    std::vector<CompletionResult> completion_results;
+    size_t completion_results_key = 0;
+    /// Indices of completion_results matching completion_matches_prefix
+    std::vector<size_t> completion_matches;
+    boost::optional<std::string> completion_matches_prefix;
+    size_t get_completion_key(const std::string &buffer, int line, int line_index);
+    void update_completion_results();
+
     const std::unordered_map<std::string, std::string> &autocomplete_manipulators_map();
   };
 
@@ -123,10 +203,18 @@ namespace Source {
     void full_reparse() override;
     void async_delete();
 
+    /// Unloads translation units of the least recently focused buffers while
+    /// the total memory use exceeds Config::get().source.clang_memory_budget.
+    static void apply_memory_budget();
+
   private:
     Glib::Dispatcher do_delete_object;
     std::thread delete_thread;
     std::thread full_reparse_thread;
     bool full_reparse_running = false;
+
+    std::chrono::steady_clock::time_point last_focus_time;
+    /// Caches the usages of the translation unit before it is released. Syntax highlighting is kept.
+    void unload();
   };
 } // namespace Source
@@ -49,9 +49,8 @@ Source::DiffView::~DiffView() {
     get_gutter(Gtk::TextWindowType::TEXT_WINDOW_LEFT)->remove(renderer.get());
     buffer_insert_connection.disconnect();
     buffer_erase_connection.disconnect();
-    monitor_changed_connection.disconnect();
+    repository_monitor = nullptr;
     delayed_buffer_changed_connection.disconnect();
-    delayed_monitor_changed_connection.disconnect();
 
     parse_stop = true;
     if(parse_thread.joinable())
@@ -90,9 +89,8 @@ void Source::DiffView::configure() {
     get_gutter(Gtk::TextWindowType::TEXT_WINDOW_LEFT)->remove(renderer.get());
     buffer_insert_connection.disconnect();
     buffer_erase_connection.disconnect();
-    monitor_changed_connection.disconnect();
+    repository_monitor = nullptr;
     delayed_buffer_changed_connection.disconnect();
-    delayed_monitor_changed_connection.disconnect();
 
     parse_stop = true;
     if(parse_thread.joinable())
@@ -168,21 +166,11 @@ void Source::DiffView::configure() {
       },
       false);
 
-  monitor_changed_connection = repository->monitor->signal_changed().connect([this](const Glib::RefPtr<Gio::File> &file,
-                                                                                    const Glib::RefPtr<Gio::File> &,
-                                                                                    Gio::FileMonitorEvent monitor_event) {
-    if(monitor_event != Gio::FileMonitorEvent::FILE_MONITOR_EVENT_CHANGES_DONE_HINT) {
-      delayed_monitor_changed_connection.disconnect();
-      delayed_monitor_changed_connection = Glib::signal_timeout().connect(
-          [this]() {
-            monitor_changed = true;
-            parse_state = ParseState::starting;
-            LockGuard lock(parse_mutex);
-            diff = nullptr;
-            return false;
-          },
-          500);
-    }
+  repository_monitor = FileWatcher::get().subscribe(repository->get_path(), true, [this](std::vector<boost::filesystem::path> &&) {
+    monitor_changed = true;
+    parse_state = ParseState::starting;
+    LockGuard lock(parse_mutex);
+    diff = nullptr;
   });
 
   parse_thread = std::thread([this]() {
@@ -215,7 +203,7 @@ void Source::DiffView::configure() {
             auto expected = ParseState::preprocessing;
             if(parse_mutex.try_lock()) {
               if(parse_state.compare_exchange_strong(expected, ParseState::processing))
-                parse_buffer = get_buffer()->get_text();
+                parse_buffer = get_snapshot();
               parse_mutex.unlock();
             }
             else
@@ -250,7 +238,7 @@ void Source::DiffView::configure() {
 
           Git::Repository::Diff::Lines diff_lines;
           if(diff)
-            diff_lines = diff->get_lines(parse_buffer.raw());
+            diff_lines = diff->get_lines(*parse_buffer);
           auto expected = ParseState::processing;
           if(parse_state.compare_exchange_strong(expected, ParseState::postprocessing)) {
             parse_mutex.unlock();
@@ -323,8 +311,7 @@ std::string Source::DiffView::get_diff_details() {
       auto iter = get_buffer()->get_iter_at_line(line_nr);
       if(iter.has_tag(renderer->tag_removed_above))
         --line_nr;
-      parse_buffer = get_buffer()->get_text();
-      details = diff->get_details(parse_buffer.raw(), line_nr);
+      details = diff->get_details(*get_snapshot(), line_nr);
     }
   }
   if(details.empty())
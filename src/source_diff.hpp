@@ -65,12 +65,11 @@ namespace Source {
     std::thread parse_thread;
     std::atomic<ParseState> parse_state;
     std::atomic<bool> parse_stop;
-    Glib::ustring parse_buffer GUARDED_BY(parse_mutex);
+    std::shared_ptr<const std::string> parse_buffer GUARDED_BY(parse_mutex);
     sigc::connection buffer_insert_connection;
     sigc::connection buffer_erase_connection;
-    sigc::connection monitor_changed_connection;
+    std::unique_ptr<FileWatcher::Subscription> repository_monitor;
     sigc::connection delayed_buffer_changed_connection;
-    sigc::connection delayed_monitor_changed_connection;
     std::atomic<bool> monitor_changed;
 
     void update_tags(const Git::Repository::Diff::Lines &diff_lines);
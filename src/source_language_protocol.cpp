@@ -398,7 +398,9 @@ void LanguageProtocol::Client::parse_server_message() {
         {
           LockGuard lock(read_write_mutex);
           if(auto result = object.child_optional("result")) {
-            auto it = handlers.find(object.integer("id", JSON::ParseOptions::accept_string));
+            auto id = object.integer("id", JSON::ParseOptions::accept_string);
+            trace_response(id, *server_message_size - server_message_content_pos, false);
+            auto it = handlers.find(id);
             if(it != handlers.end()) {
               auto function = std::move(it->second.second);
               handlers.erase(it);
@@ -412,7 +414,9 @@ void LanguageProtocol::Client::parse_server_message() {
               std::lock_guard<std::mutex> lock(log_mutex);
               std::cerr << std::setw(2) << object << '\n';
             }
-            auto it = handlers.find(object.integer("id", JSON::ParseOptions::accept_string));
+            auto id = object.integer("id", JSON::ParseOptions::accept_string);
+            trace_response(id, *server_message_size - server_message_content_pos, true);
+            auto it = handlers.find(id);
             if(it != handlers.end()) {
               auto function = std::move(it->second.second);
               handlers.erase(it);
@@ -461,7 +465,8 @@ void LanguageProtocol::Client::parse_server_message() {
 
 void LanguageProtocol::Client::write_request(Source::LanguageProtocolView *view, const std::string &method, const std::string &params, std::function<void(JSON &&result, bool error)> &&function) {
   LockGuard lock(read_write_mutex);
-  if(function) {
+  bool has_handler = static_cast<bool>(function);
+  if(has_handler) {
     handlers.emplace(message_id, std::make_pair(view, std::move(function)));
 
     auto message_id = this->message_id;
@@ -476,6 +481,7 @@ void LanguageProtocol::Client::write_request(Source::LanguageProtocolView *view,
       }
       LockGuard lock(read_write_mutex);
       auto id_it = handlers.find(message_id);
+      request_traces.erase(message_id);
       if(id_it != handlers.end()) {
         Terminal::get().async_print("\e[33mWarning\e[m: request to language server timed out. If you suspect the server has crashed, please close and reopen all project source files.\n", true);
         auto function = std::move(id_it->second.second);
@@ -491,8 +497,11 @@ void LanguageProtocol::Client::write_request(Source::LanguageProtocolView *view,
     std::lock_guard<std::mutex> lock(log_mutex);
     std::cout << "Language client: " << std::setw(2) << JSON(content) << std::endl;
   }
+  if(has_handler && Trace::is_recording())
+    request_traces.emplace(message_id - 1, RequestTrace{method, Trace::Clock::now(), content.size()});
   if(!process->write("Content-Length: " + std::to_string(content.size()) + "\r\n\r\n" + content)) {
     Terminal::get().async_print("\e[31mError\e[m: could not write to language server. Please close and reopen all project files.\n", true);
+    request_traces.erase(message_id - 1);
     auto id_it = handlers.find(message_id - 1);
     if(id_it != handlers.end()) {
       auto function = std::move(id_it->second.second);
@@ -504,6 +513,16 @@ void LanguageProtocol::Client::write_request(Source::LanguageProtocolView *view,
   }
 }
 
+void LanguageProtocol::Client::trace_response(size_t id, size_t size, bool error) {
+  auto it = request_traces.find(id);
+  if(it == request_traces.end())
+    return;
+  Trace::async("LanguageProtocol::Client::write_request", it->second.start, Trace::Clock::now(),
+               "\"method\":\"" + JSON::escape_string(it->second.method) + "\",\"request_size\":" + std::to_string(it->second.size) +
+                   ",\"response_size\":" + std::to_string(size) + ",\"error\":" + (error ? "true" : "false"));
+  request_traces.erase(it);
+}
+
 void LanguageProtocol::Client::write_response(const boost::variant<size_t, std::string> &id, const std::string &result) {
   LockGuard lock(read_write_mutex);
   auto integer = boost::get<size_t>(&id);
@@ -787,7 +806,7 @@ void Source::LanguageProtocolView::write_notification(const std::string &method)
 
 void Source::LanguageProtocolView::write_did_open_notification() {
   document_version = 1;
-  client->write_notification("textDocument/didOpen", "\"textDocument\":{\"uri\":\"" + uri_escaped + "\",\"version\":" + std::to_string(document_version++) + ",\"languageId\":\"" + language_id + "\",\"text\":\"" + JSON::escape_string(get_buffer()->get_text().raw()) + "\"}");
+  client->write_notification("textDocument/didOpen", "\"textDocument\":{\"uri\":\"" + uri_escaped + "\",\"version\":" + std::to_string(document_version++) + ",\"languageId\":\"" + language_id + "\",\"text\":\"" + JSON::escape_string(*get_snapshot()) + "\"}");
 }
 
 void Source::LanguageProtocolView::write_did_change_notification(const std::vector<std::pair<std::string, std::string>> &params) {
@@ -1458,22 +1477,36 @@ void Source::LanguageProtocolView::setup_navigation_and_refactoring() {
 
 void Source::LanguageProtocolView::setup_signals() {
   if(capabilities.text_document_sync == LanguageProtocol::Capabilities::TextDocumentSync::incremental) {
+    // The content changes are sent when the buffer changed signal is emitted, so that an edit at multiple cursors is sent in one notification
     get_buffer()->signal_insert().connect(
         [this](const Gtk::TextIter &start, const Glib::ustring &text, int bytes) {
           std::pair<int, int> location = {start.get_line(), get_line_pos(start)};
-          write_did_change_notification({{"contentChanges", "[{" + to_string({make_range(location, location), {"text", '"' + JSON::escape_string(text.raw()) + '"'}}) + "}]"}});
+          content_changes.emplace_back("{" + to_string({make_range(location, location), {"text", '"' + JSON::escape_string(text.raw()) + '"'}}) + "}");
         },
         false);
 
     get_buffer()->signal_erase().connect(
         [this](const Gtk::TextIter &start, const Gtk::TextIter &end) {
-          write_did_change_notification({{"contentChanges", "[{" + to_string({make_range({start.get_line(), get_line_pos(start)}, {end.get_line(), get_line_pos(end)}), {"text", "\"\""}}) + "}]"}});
+          content_changes.emplace_back("{" + to_string({make_range({start.get_line(), get_line_pos(start)}, {end.get_line(), get_line_pos(end)}), {"text", "\"\""}}) + "}");
         },
         false);
+
+    get_buffer()->signal_changed().connect([this]() {
+      if(content_changes.empty())
+        return;
+      std::string content_changes_str = "[";
+      for(auto &content_change : content_changes) {
+        if(content_changes_str.size() > 1)
+          content_changes_str += ',';
+        content_changes_str += content_change;
+      }
+      content_changes.clear();
+      write_did_change_notification({{"contentChanges", content_changes_str + "]"}});
+    });
   }
   else if(capabilities.text_document_sync == LanguageProtocol::Capabilities::TextDocumentSync::full) {
     get_buffer()->signal_changed().connect([this]() {
-      write_did_change_notification({{"contentChanges", "[{" + to_string({"text", '"' + JSON::escape_string(get_buffer()->get_text().raw()) + '"'}) + "}]"}});
+      write_did_change_notification({{"contentChanges", "[{" + to_string({"text", '"' + JSON::escape_string(*get_snapshot()) + '"'}) + "}]"}});
     });
   }
 }
@@ -2059,11 +2092,8 @@ void Source::LanguageProtocolView::update_diagnostics_async(std::vector<Language
 }
 
 void Source::LanguageProtocolView::update_diagnostics(std::vector<LanguageProtocol::Diagnostic> diagnostics) {
-  diagnostic_offsets.clear();
-  diagnostic_tooltips.clear();
+  begin_diagnostics_update();
   fix_its.clear();
-  get_buffer()->remove_tag_by_name("def:warning_underline", get_buffer()->begin(), get_buffer()->end());
-  get_buffer()->remove_tag_by_name("def:error_underline", get_buffer()->begin(), get_buffer()->end());
   num_warnings = 0;
   num_errors = 0;
   num_fix_its = 0;
@@ -2092,7 +2122,16 @@ void Source::LanguageProtocolView::update_diagnostics(std::vector<LanguageProtoc
     for(auto &quickfix : diagnostic.quickfixes)
       fix_its.insert(fix_its.end(), quickfix.second.begin(), quickfix.second.end());
 
-    add_diagnostic_tooltip(start, end, error, [this, diagnostic = std::move(diagnostic)](Tooltip &tooltip) {
+    // Everything shown in the tooltip, used to decide if an unchanged diagnostic can be kept
+    auto message = diagnostic.message;
+    for(auto &related_information : diagnostic.related_informations) {
+      message += '\n' + related_information.message + '\n' + related_information.location.file;
+      message += ':' + std::to_string(related_information.location.range.start.line) + ':' + std::to_string(related_information.location.range.start.character);
+    }
+    for(auto &quickfix : diagnostic.quickfixes)
+      message += '\n' + quickfix.first;
+
+    add_diagnostic_tooltip(start, end, error, std::move(message), [this, diagnostic = std::move(diagnostic)](Tooltip &tooltip) {
       if(language_id == "python" && !client->pyright) { // pylsp might support markdown in the future
         tooltip.insert_with_links_tagged(diagnostic.message);
         return;
@@ -2130,11 +2169,12 @@ void Source::LanguageProtocolView::update_diagnostics(std::vector<LanguageProtoc
   }
 
   for(auto &mark : type_coverage_marks) {
-    add_diagnostic_tooltip(mark.first->get_iter(), mark.second->get_iter(), false, [](Tooltip &tooltip) {
+    add_diagnostic_tooltip(mark.first->get_iter(), mark.second->get_iter(), false, type_coverage_message, [](Tooltip &tooltip) {
       tooltip.buffer->insert_at_cursor(type_coverage_message);
     });
     num_warnings++;
   }
+  end_diagnostics_update();
 
   status_diagnostics = std::make_tuple(num_warnings, num_errors, num_fix_its);
   if(update_status_diagnostics)
@@ -2205,6 +2245,15 @@ void Source::LanguageProtocolView::show_type_tooltips(const Gdk::Rectangle &rect
         }
       }
       if(!contents.empty()) {
+        // Render documentation in this thread, so that the tooltip only has to insert the cached result
+        for(auto &content : contents) {
+          if(language_id == "python" && !client->pyright) {
+            if(content.kind != "python")
+              Tooltip::prerender_docstring(content.value);
+          }
+          else if(content.kind == "markdown")
+            Tooltip::prerender_markdown(content.value);
+        }
         dispatcher.post([this, offset, contents = std::move(contents), current_request]() mutable {
           if(current_request != request_count)
             return;
@@ -2306,11 +2355,30 @@ void Source::LanguageProtocolView::apply_similar_symbol_tag() {
   if(!capabilities.document_highlight)
     return;
 
-  auto iter = get_buffer()->get_insert()->get_iter();
+  // Also incremented when the cached highlights are used, so that responses to earlier requests are not applied afterwards
   static int request_count = 0;
   request_count++;
+
+  auto iter = get_buffer()->get_insert()->get_iter();
+  auto line = iter.get_line();
+  auto line_pos = get_line_pos(iter);
+  if(document_highlights_version == document_version) {
+    for(auto &range : document_highlights) {
+      if((range.start.line < line || (range.start.line == line && range.start.character <= line_pos)) &&
+         (line < range.end.line || (line == range.end.line && line_pos <= range.end.character))) {
+        get_buffer()->remove_tag(similar_symbol_tag, get_buffer()->begin(), get_buffer()->end());
+        for(auto &range : document_highlights) {
+          auto start = get_iter_at_line_pos(range.start.line, range.start.character);
+          auto end = get_iter_at_line_pos(range.end.line, range.end.character);
+          get_buffer()->apply_tag(similar_symbol_tag, start, end);
+        }
+        return;
+      }
+    }
+  }
+
   auto current_request = request_count;
-  write_request("textDocument/documentHighlight", to_string({make_position(iter.get_line(), get_line_pos(iter)), {"context", "{\"includeDeclaration\":true}"}}), [this, current_request](JSON &&result, bool error) {
+  write_request("textDocument/documentHighlight", to_string({make_position(line, line_pos), {"context", "{\"includeDeclaration\":true}"}}), [this, current_request, version = document_version](JSON &&result, bool error) {
     if(!error) {
       std::vector<LanguageProtocol::Range> ranges;
       for(auto &location : result.array_or_empty()) {
@@ -2320,11 +2388,15 @@ void Source::LanguageProtocolView::apply_similar_symbol_tag() {
         catch(...) {
         }
       }
-      dispatcher.post([this, ranges = std::move(ranges), current_request] {
+      dispatcher.post([this, ranges = std::move(ranges), current_request, version] {
+        if(version != document_version)
+          return;
+        document_highlights_version = version;
+        document_highlights = std::move(ranges);
         if(current_request != request_count || !similar_symbol_tag_applied)
           return;
         get_buffer()->remove_tag(similar_symbol_tag, get_buffer()->begin(), get_buffer()->end());
-        for(auto &range : ranges) {
+        for(auto &range : document_highlights) {
           auto start = get_iter_at_line_pos(range.start.line, range.start.character);
           auto end = get_iter_at_line_pos(range.end.line, range.end.character);
           get_buffer()->apply_tag(similar_symbol_tag, start, end);
@@ -4,6 +4,7 @@
 #include "mutex.hpp"
 #include "process.hpp"
 #include "source.hpp"
+#include "trace.hpp"
 #include <atomic>
 #include <boost/optional.hpp>
 #include <list>
@@ -170,6 +171,15 @@ namespace LanguageProtocol {
 
     std::map<size_t, std::pair<Source::LanguageProtocolView *, std::function<void(JSON &&result, bool error)>>> handlers GUARDED_BY(read_write_mutex);
 
+    struct RequestTrace {
+      std::string method;
+      Trace::Clock::time_point start;
+      size_t size;
+    };
+    /// Requests written while tracing is recording
+    std::map<size_t, RequestTrace> request_traces GUARDED_BY(read_write_mutex);
+    void trace_response(size_t id, size_t size, bool error) REQUIRES(read_write_mutex);
+
     Mutex timeout_threads_mutex;
     std::vector<std::thread> timeout_threads GUARDED_BY(timeout_threads_mutex);
 
@@ -256,6 +266,11 @@ namespace Source {
     std::shared_ptr<LanguageProtocol::Client> client;
 
     size_t document_version = 1;
+    /// Incremental content changes not yet sent to the language server
+    std::vector<std::string> content_changes;
+    /// Result of the last documentHighlight request. Reused while the document is unchanged and the cursor is within one of the ranges.
+    std::vector<LanguageProtocol::Range> document_highlights;
+    size_t document_highlights_version = 0;
 
     std::thread initialize_thread;
     Dispatcher dispatcher;
@@ -2,10 +2,76 @@
 #include "config.hpp"
 #include "info.hpp"
 #include "selection_dialog.hpp"
+#include "utility.hpp"
 #include <iostream>
+#include <map>
 
 AspellConfig *Source::SpellCheckView::spellcheck_config = nullptr;
 
+Source::SpellCheckView::Dictionary::~Dictionary() {
+  LockGuard lock(mutex);
+  if(config)
+    delete_aspell_config(config);
+  if(speller)
+    delete_aspell_speller(speller);
+}
+
+std::shared_ptr<Source::SpellCheckView::Dictionary> Source::SpellCheckView::Dictionary::get(const std::string &language) {
+  static std::map<std::string, std::shared_ptr<Dictionary>> dictionaries;
+  auto it = dictionaries.find(language);
+  if(it != dictionaries.end())
+    return it->second;
+
+  auto dictionary = std::make_shared<Dictionary>(aspell_config_clone(spellcheck_config));
+  dictionaries.emplace(language, dictionary);
+  return dictionary;
+}
+
+AspellSpeller *Source::SpellCheckView::Dictionary::get_speller() {
+  if(config) {
+    auto possible_err = new_aspell_speller(config);
+    if(aspell_error_number(possible_err) != 0) {
+      std::cerr << "Spell check error: " << aspell_error_message(possible_err) << std::endl;
+      delete_aspell_can_have_error(possible_err);
+    }
+    else
+      speller = to_aspell_speller(possible_err);
+    delete_aspell_config(config);
+    config = nullptr;
+  }
+  return speller;
+}
+
+bool Source::SpellCheckView::Dictionary::check(const std::string &word) {
+  LockGuard lock(mutex);
+  auto it = verdicts.find(word);
+  if(it != verdicts.end())
+    return it->second;
+  if(!get_speller())
+    return true;
+  if(verdicts.size() >= 100000)
+    verdicts.clear();
+  bool correct = aspell_speller_check(speller, word.data(), word.size()) != 0;
+  verdicts.emplace(word, correct);
+  return correct;
+}
+
+std::vector<std::string> Source::SpellCheckView::Dictionary::get_suggestions(const std::string &word) {
+  LockGuard lock(mutex);
+  if(!get_speller())
+    return {};
+  const AspellWordList *suggestions = aspell_speller_suggest(speller, word.data(), word.size());
+  AspellStringEnumeration *elements = aspell_word_list_elements(suggestions);
+
+  std::vector<std::string> words;
+  const char *element;
+  while((element = aspell_string_enumeration_next(elements)))
+    words.emplace_back(element);
+  delete_aspell_string_enumeration(elements);
+
+  return words;
+}
+
 Source::SpellCheckView::SpellCheckView(const boost::filesystem::path &file_path, const Glib::RefPtr<Gsv::Language> &language) : BaseView(file_path, language) {
   if(!language ||                                     // Spellcheck all words if no spec is found
      is_language({"markdown", "latex", "html", "xml", // Spellcheck all non-symbol words (not only string or comment context classes)
@@ -14,7 +80,6 @@ Source::SpellCheckView::SpellCheckView(const boost::filesystem::path &file_path,
 
   if(!spellcheck_config)
     spellcheck_config = new_aspell_config();
-  spellcheck_checker = nullptr;
   spellcheck_error_tag = get_buffer()->create_tag("spellcheck_error");
   spellcheck_error_tag->property_underline() = Pango::Underline::UNDERLINE_ERROR;
 
@@ -36,7 +101,19 @@ Source::SpellCheckView::SpellCheckView(const boost::filesystem::path &file_path,
   });
 
   get_buffer()->signal_changed().connect([this]() {
-    if(!spellcheck_checker)
+    // Discard the results of an ongoing background spellcheck, and restart it when the buffer has not changed for a while
+    if(spellcheck_in_progress) {
+      ++spellcheck_count;
+      delayed_spellcheck_restart.disconnect();
+      delayed_spellcheck_restart = Glib::signal_timeout().connect(
+          [this]() {
+            spellcheck();
+            return false;
+          },
+          1000);
+    }
+
+    if(!dictionary)
       return;
 
     delayed_spellcheck_suggestions_connection.disconnect();
@@ -139,7 +216,7 @@ Source::SpellCheckView::SpellCheckView(const boost::filesystem::path &file_path,
   // In case of for instance text paste or undo/redo
   get_buffer()->signal_insert().connect(
       [this](const Gtk::TextIter &start_iter, const Glib::ustring &inserted_string, int) {
-        if(!spellcheck_checker)
+        if(!dictionary)
           return;
 
         if(disable_spellcheck) {
@@ -158,7 +235,7 @@ Source::SpellCheckView::SpellCheckView(const boost::filesystem::path &file_path,
     if(mark->get_name() == "insert") {
       if(SelectionDialog::get())
         SelectionDialog::get()->hide();
-      if(!spellcheck_checker)
+      if(!dictionary)
         return;
       delayed_spellcheck_suggestions_connection.disconnect();
       if(get_buffer()->get_has_selection())
@@ -226,9 +303,11 @@ Source::SpellCheckView::SpellCheckView(const boost::filesystem::path &file_path,
 Source::SpellCheckView::~SpellCheckView() {
   delayed_spellcheck_suggestions_connection.disconnect();
   delayed_spellcheck_error_clear.disconnect();
+  delayed_spellcheck_restart.disconnect();
 
-  if(spellcheck_checker)
-    delete_aspell_speller(spellcheck_checker);
+  ++spellcheck_count;
+  spellcheck_thread_pool.shutdown(true);
+  spellcheck_dispatcher.disconnect();
 
   signal_tag_added_connection.disconnect();
   signal_tag_removed_connection.disconnect();
@@ -239,15 +318,8 @@ void Source::SpellCheckView::configure() {
     aspell_config_replace(spellcheck_config, "lang", Config::get().source.spellcheck_language.c_str());
     aspell_config_replace(spellcheck_config, "encoding", "utf-8");
   }
-  spellcheck_possible_err = new_aspell_speller(spellcheck_config);
-  if(spellcheck_checker)
-    delete_aspell_speller(spellcheck_checker);
-  spellcheck_checker = nullptr;
-  if(aspell_error_number(spellcheck_possible_err) != 0)
-    std::cerr << "Spell check error: " << aspell_error_message(spellcheck_possible_err) << std::endl;
-  else
-    spellcheck_checker = to_aspell_speller(spellcheck_possible_err);
-  get_buffer()->remove_tag(spellcheck_error_tag, get_buffer()->begin(), get_buffer()->end());
+  dictionary = Dictionary::get(Config::get().source.spellcheck_language);
+  remove_spellcheck_errors();
 }
 
 void Source::SpellCheckView::hide_dialogs() {
@@ -256,21 +328,14 @@ void Source::SpellCheckView::hide_dialogs() {
     SelectionDialog::get()->hide();
 }
 
-void Source::SpellCheckView::spellcheck(const Gtk::TextIter &start, const Gtk::TextIter &end) {
-  if(!spellcheck_checker)
+void Source::SpellCheckView::spellcheck() {
+  delayed_spellcheck_restart.disconnect();
+  auto count = ++spellcheck_count;
+  spellcheck_in_progress = false;
+  if(!dictionary)
     return;
-  auto iter = start;
-  while(iter && iter < end) {
-    if(is_word_iter(iter)) {
-      auto word = get_word(iter);
-      spellcheck_word(word.first, word.second);
-      iter = word.second;
-    }
-    iter.forward_char();
-  }
-}
 
-void Source::SpellCheckView::spellcheck() {
+  std::vector<std::pair<Gtk::TextIter, Gtk::TextIter>> ranges;
   auto iter = get_buffer()->begin();
   Gtk::TextIter begin_spellcheck_iter;
   if(spellcheck_all) {
@@ -285,7 +350,7 @@ void Source::SpellCheckView::spellcheck() {
       if(spell_check)
         begin_spellcheck_iter = iter;
       else
-        spellcheck(begin_spellcheck_iter, iter);
+        ranges.emplace_back(begin_spellcheck_iter, iter);
     }
   }
   else {
@@ -308,12 +373,109 @@ void Source::SpellCheckView::spellcheck() {
       if(spell_check)
         begin_spellcheck_iter = iter;
       else
-        spellcheck(begin_spellcheck_iter, iter);
+        ranges.emplace_back(begin_spellcheck_iter, iter);
+    }
+  }
+
+  // Snapshot the ranges, split at line starts so that the visible lines are checked first and large ranges are applied in several batches
+  struct Range {
+    int offset;
+    std::string text;
+    std::vector<size_t> word_apostrophes;
+  };
+  std::vector<Range> visible_ranges, other_ranges;
+
+  Gdk::Rectangle visible_rect;
+  get_visible_rect(visible_rect);
+  Gtk::TextIter visible_start, visible_end;
+  int line_top;
+  get_line_at_y(visible_start, visible_rect.get_y(), line_top);
+  get_line_at_y(visible_end, visible_rect.get_y() + visible_rect.get_height(), line_top);
+  visible_end.forward_line();
+
+  const int max_range_lines = 500;
+  auto add_ranges = [this, max_range_lines](std::vector<Range> &ranges, Gtk::TextIter start, const Gtk::TextIter &end) {
+    while(start < end) {
+      auto range_end = start;
+      if(!range_end.forward_lines(max_range_lines) || range_end > end)
+        range_end = end;
+      Range range{start.get_offset(), get_buffer()->get_text(start, range_end).raw(), {}};
+      // Whether ' is part of a word depends on the surrounding code and strings, and is therefore decided here
+      auto iter = start;
+      size_t iter_pos = 0;
+      for(size_t pos = 0; (pos = range.text.find('\'', pos)) != std::string::npos; ++pos) {
+        iter.forward_chars(static_cast<int>(utf8_character_count(range.text, iter_pos, pos - iter_pos)));
+        iter_pos = pos;
+        if(is_word_iter(iter))
+          range.word_apostrophes.emplace_back(pos);
+      }
+      ranges.emplace_back(std::move(range));
+      start = range_end;
     }
+  };
+  for(auto &range : ranges) {
+    add_ranges(other_ranges, range.first, std::min(range.second, visible_start));
+    add_ranges(visible_ranges, std::max(range.first, visible_start), std::min(range.second, visible_end));
+    add_ranges(other_ranges, std::max(range.first, visible_end), range.second);
   }
+  auto visible_ranges_size = visible_ranges.size();
+  visible_ranges.insert(visible_ranges.end(), std::make_move_iterator(other_ranges.begin()), std::make_move_iterator(other_ranges.end()));
+  if(visible_ranges.empty())
+    return;
+
+  spellcheck_in_progress = true;
+  spellcheck_thread_pool.push([this, ranges = std::move(visible_ranges), visible_ranges_size, dictionary = dictionary, count] {
+    const size_t batch_bytes = 65536;
+    std::vector<std::pair<int, int>> checked_ranges, error_ranges;
+    size_t bytes = 0;
+    for(size_t i = 0; i < ranges.size(); ++i) {
+      if(count != spellcheck_count)
+        return;
+      auto &range = ranges[i];
+      auto offset = range.offset;
+      size_t pos = 0;
+      auto forward_to = [&range, &offset, &pos](size_t end) {
+        for(; pos < end; ++pos) {
+          if((static_cast<unsigned char>(range.text[pos]) & 0xC0) != 0x80) // Count UTF-8 lead bytes
+            ++offset;
+        }
+      };
+      for(auto &word : get_words(range.text, range.word_apostrophes)) {
+        forward_to(word.first);
+        auto start = offset;
+        forward_to(word.second);
+        if(!dictionary->check(range.text.substr(word.first, word.second - word.first)))
+          error_ranges.emplace_back(start, offset);
+      }
+      forward_to(range.text.size());
+      checked_ranges.emplace_back(range.offset, offset);
+
+      bytes += range.text.size();
+      bool last = i + 1 == ranges.size();
+      if(last || i + 1 == visible_ranges_size || bytes >= batch_bytes) {
+        spellcheck_dispatcher.post([this, checked_ranges = std::move(checked_ranges), error_ranges = std::move(error_ranges), count, last] {
+          if(count != spellcheck_count)
+            return;
+          auto buffer = get_buffer();
+          for(auto &range : checked_ranges)
+            buffer->remove_tag(spellcheck_error_tag, buffer->get_iter_at_offset(range.first), buffer->get_iter_at_offset(range.second));
+          for(auto &range : error_ranges)
+            buffer->apply_tag(spellcheck_error_tag, buffer->get_iter_at_offset(range.first), buffer->get_iter_at_offset(range.second));
+          if(last)
+            spellcheck_in_progress = false;
+        });
+        checked_ranges.clear();
+        error_ranges.clear();
+        bytes = 0;
+      }
+    }
+  });
 }
 
 void Source::SpellCheckView::remove_spellcheck_errors() {
+  ++spellcheck_count;
+  spellcheck_in_progress = false;
+  delayed_spellcheck_restart.disconnect();
   get_buffer()->remove_tag(spellcheck_error_tag, get_buffer()->begin(), get_buffer()->end());
 }
 
@@ -540,8 +702,7 @@ void Source::SpellCheckView::spellcheck_word(Gtk::TextIter start, Gtk::TextIter
   if(word == "''")
     get_buffer()->remove_tag(spellcheck_error_tag, start, end);
   else if(word.size() > 0) {
-    auto correct = aspell_speller_check(spellcheck_checker, word.data(), word.bytes());
-    if(correct == 0)
+    if(!dictionary->check(word.raw()))
       get_buffer()->apply_tag(spellcheck_error_tag, start, end);
     else
       get_buffer()->remove_tag(spellcheck_error_tag, start, end);
@@ -549,16 +710,50 @@ void Source::SpellCheckView::spellcheck_word(Gtk::TextIter start, Gtk::TextIter
 }
 
 std::vector<std::string> Source::SpellCheckView::get_spellcheck_suggestions(const Gtk::TextIter &start, const Gtk::TextIter &end) {
-  auto word_with_error = get_buffer()->get_text(start, end);
+  return dictionary->get_suggestions(get_buffer()->get_text(start, end).raw());
+}
 
-  const AspellWordList *suggestions = aspell_speller_suggest(spellcheck_checker, word_with_error.data(), word_with_error.bytes());
-  AspellStringEnumeration *elements = aspell_word_list_elements(suggestions);
+std::vector<std::pair<size_t, size_t>> Source::SpellCheckView::get_words(const std::string &text, const std::vector<size_t> &word_apostrophes) {
+  std::vector<std::pair<size_t, size_t>> words;
 
-  std::vector<std::string> words;
-  const char *word;
-  while((word = aspell_string_enumeration_next(elements)))
-    words.emplace_back(word);
-  delete_aspell_string_enumeration(elements);
+  auto add_word = [&text, &words](size_t start, size_t end) {
+    if(text[start] == '\'' && end - start >= 3 && text[end - 1] == '\'') {
+      ++start;
+      --end;
+    }
+    for(auto i = start; i < end; ++i) {
+      if(text[i] != '\'') {
+        words.emplace_back(start, end);
+        return;
+      }
+    }
+  };
+
+  const char *begin = text.c_str();
+  const char *end = begin + text.size();
+  const char *word_start = nullptr;
+  auto word_apostrophe = word_apostrophes.begin();
+  size_t backslash_count = 0;
+  for(auto chr = begin; chr < end; chr = g_utf8_next_char(chr)) {
+    auto unichar = g_utf8_get_char(chr);
+    bool is_word_char;
+    if(unichar == '\'') {
+      while(word_apostrophe != word_apostrophes.end() && *word_apostrophe < static_cast<size_t>(chr - begin))
+        ++word_apostrophe;
+      is_word_char = word_apostrophe != word_apostrophes.end() && *word_apostrophe == static_cast<size_t>(chr - begin);
+    }
+    else
+      is_word_char = backslash_count % 2 == 0 && Glib::Unicode::isalpha(unichar);
+    if(is_word_char && !word_start)
+      word_start = chr;
+    else if(!is_word_char && word_start) {
+      add_word(word_start - begin, chr - begin);
+      word_start = nullptr;
+    }
+    backslash_count = unichar == '\\' ? backslash_count + 1 : 0;
+  }
+  if(word_start)
+    add_word(word_start - begin, text.size());
 
   return words;
 }
@@ -1,6 +1,10 @@
 #pragma once
+#include "dispatcher.hpp"
+#include "mutex.hpp"
 #include "source_base.hpp"
 #include <aspell.h>
+#include <atomic>
+#include <unordered_map>
 
 namespace Source {
   class SpellCheckView : virtual public Source::BaseView {
@@ -30,6 +34,29 @@ namespace Source {
     Glib::RefPtr<Gtk::TextTag> no_spellcheck_tag;
 
   private:
+    /// Speller and word verdict cache shared between all views using the same spellcheck language.
+    /// Aspell spellers are not thread safe, so all speller calls are made while holding mutex.
+    class Dictionary {
+      Mutex mutex;
+      /// Set to nullptr when the speller has been created
+      AspellConfig *config GUARDED_BY(mutex);
+      AspellSpeller *speller GUARDED_BY(mutex) = nullptr;
+      std::unordered_map<std::string, bool> verdicts GUARDED_BY(mutex);
+
+      /// Loading the word lists is slow, so the speller is created on first use, normally in the spellcheck thread.
+      /// Returns nullptr if the speller could not be created.
+      AspellSpeller *get_speller() REQUIRES(mutex);
+
+    public:
+      Dictionary(AspellConfig *config) : config(config) {}
+      ~Dictionary();
+
+      static std::shared_ptr<Dictionary> get(const std::string &language);
+
+      bool check(const std::string &word);
+      std::vector<std::string> get_suggestions(const std::string &word);
+    };
+
     bool spellcheck_all = false;
 
     Glib::RefPtr<Gtk::TextTag> spellcheck_error_tag;
@@ -38,8 +65,7 @@ namespace Source {
     sigc::connection signal_tag_removed_connection;
 
     static AspellConfig *spellcheck_config;
-    AspellCanHaveError *spellcheck_possible_err;
-    AspellSpeller *spellcheck_checker;
+    std::shared_ptr<Dictionary> dictionary;
     bool is_word_iter(const Gtk::TextIter &iter);
     std::pair<Gtk::TextIter, Gtk::TextIter> get_word(Gtk::TextIter iter);
     void spellcheck_word(Gtk::TextIter start, Gtk::TextIter end);
@@ -47,6 +73,15 @@ namespace Source {
     sigc::connection delayed_spellcheck_suggestions_connection;
     sigc::connection delayed_spellcheck_error_clear;
 
-    void spellcheck(const Gtk::TextIter &start, const Gtk::TextIter &end);
+    Dispatcher spellcheck_dispatcher;
+    Glib::ThreadPool spellcheck_thread_pool;
+    /// Incremented on buffer changes and new spellcheck() calls to discard results from outdated background spellchecks
+    std::atomic<size_t> spellcheck_count = {0};
+    bool spellcheck_in_progress = false;
+    sigc::connection delayed_spellcheck_restart;
+
+    /// Returns the byte ranges of the words in text, excluding surrounding ' characters.
+    /// word_apostrophes are the sorted byte positions of the ' characters that is_word_iter() treats as word characters.
+    static std::vector<std::pair<size_t, size_t>> get_words(const std::string &text, const std::vector<size_t> &word_apostrophes);
   };
 } // namespace Source
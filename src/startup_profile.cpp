@@ -0,0 +1,47 @@
+#include "startup_profile.hpp"
+#include <iomanip>
+#include <iostream>
+
+bool StartupProfile::started = false;
+bool StartupProfile::finished = false;
+Trace::Clock::time_point StartupProfile::start_time;
+Trace::Clock::time_point StartupProfile::phase_start_time;
+std::vector<std::pair<const char *, Trace::Clock::duration>> StartupProfile::phases;
+bool StartupProfile::print = false;
+
+void StartupProfile::start() noexcept {
+  started = true;
+  start_time = phase_start_time = Trace::Clock::now();
+}
+
+void StartupProfile::phase(const char *name) noexcept {
+  if(!started || finished)
+    return;
+  auto now = Trace::Clock::now();
+  Trace::complete(name, phase_start_time, now);
+  try {
+    phases.emplace_back(name, now - phase_start_time);
+  }
+  catch(...) {
+  }
+  phase_start_time = now;
+}
+
+void StartupProfile::finish(const char *name) noexcept {
+  if(!started || finished)
+    return;
+  phase(name);
+  finished = true;
+
+  if(print) {
+    auto milliseconds = [](Trace::Clock::duration duration) {
+      return std::chrono::duration<double, std::milli>(duration).count();
+    };
+    std::cerr << "Startup profile:" << std::fixed << std::setprecision(1) << std::endl;
+    for(auto &phase : phases)
+      std::cerr << "  " << std::left << std::setw(24) << phase.first << std::right << std::setw(8) << milliseconds(phase.second) << " ms" << std::endl;
+    std::cerr << "  " << std::left << std::setw(24) << "total" << std::right << std::setw(8) << milliseconds(phase_start_time - start_time) << " ms" << std::endl;
+  }
+  phases.clear();
+  phases.shrink_to_fit();
+}
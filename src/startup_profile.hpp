@@ -0,0 +1,26 @@
+#pragma once
+#include "trace.hpp"
+#include <utility>
+#include <vector>
+
+/// Measures the phases from the start of main() until the first frame of the main window has been drawn.
+/// The phases are printed to standard error when juci is started with --startup-profile,
+/// and are recorded as trace spans when tracing is enabled.
+/// Should only be used from the main thread.
+class StartupProfile {
+  static bool started;
+  static bool finished;
+  static Trace::Clock::time_point start_time;
+  static Trace::Clock::time_point phase_start_time;
+  static std::vector<std::pair<const char *, Trace::Clock::duration>> phases;
+
+public:
+  static bool print;
+
+  /// Call at the start of main(). Phases are ignored before start() and after finish().
+  static void start() noexcept;
+  /// Ends the current phase, which started at the end of the previous phase. Name must be a string literal.
+  static void phase(const char *name) noexcept;
+  /// Ends the last phase, and prints the phases if print is true.
+  static void finish(const char *name) noexcept;
+};
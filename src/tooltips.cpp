@@ -9,6 +9,10 @@
 #include <limits>
 #include <regex>
 
+Mutex Tooltip::runs_cache_mutex;
+std::unordered_map<std::string, std::shared_ptr<const Tooltip::Runs>> Tooltip::runs_cache;
+std::unordered_map<std::string, std::vector<std::pair<Gdk::RGBA, std::vector<std::pair<int, int>>>>> Tooltip::highlight_cache;
+
 std::set<Tooltip *> Tooltips::shown_tooltips;
 Gdk::Rectangle Tooltips::drawn_tooltips_rectangle = Gdk::Rectangle();
 
@@ -437,6 +441,329 @@ void Tooltip::create_tags() {
   }
 }
 
+std::vector<std::pair<Tooltip::Runs::TagType, Glib::RefPtr<Gtk::TextTag> *>> Tooltip::get_run_tags() {
+  return {{Runs::TagType::link, &link_tag},
+          {Runs::TagType::h1, &h1_tag},
+          {Runs::TagType::h2, &h2_tag},
+          {Runs::TagType::h3, &h3_tag},
+          {Runs::TagType::code, &code_tag},
+          {Runs::TagType::code_block, &code_block_tag},
+          {Runs::TagType::bold, &bold_tag},
+          {Runs::TagType::italic, &italic_tag},
+          {Runs::TagType::strikethrough, &strikethrough_tag}};
+}
+
+/// Renders documentation to Runs without using GTK, so that documentation can be rendered outside of the main GUI thread.
+/// Mirrors the Gtk::TextBuffer operations of the tooltip buffer, with character offsets instead of iterators.
+class Tooltip::Renderer {
+  using Tag = int;
+
+public:
+  Renderer(const RenderContext &context) : context(context), references(context.references) {}
+
+  void insert_with_links_tagged(const std::string &text);
+  void insert_markdown(const std::string &input);
+  void insert_doxygen(const std::string &input, bool remove_delimiters);
+  void insert_docstring(const std::string &input);
+
+  Runs get_runs();
+
+private:
+  const RenderContext &context;
+
+  const Tag link_tag = static_cast<Tag>(Runs::TagType::link);
+  const Tag h1_tag = static_cast<Tag>(Runs::TagType::h1);
+  const Tag h2_tag = static_cast<Tag>(Runs::TagType::h2);
+  const Tag h3_tag = static_cast<Tag>(Runs::TagType::h3);
+  const Tag code_tag = static_cast<Tag>(Runs::TagType::code);
+  const Tag code_block_tag = static_cast<Tag>(Runs::TagType::code_block);
+  const Tag bold_tag = static_cast<Tag>(Runs::TagType::bold);
+  const Tag italic_tag = static_cast<Tag>(Runs::TagType::italic);
+  const Tag strikethrough_tag = static_cast<Tag>(Runs::TagType::strikethrough);
+  /// Tags from create_tag() start after the tags above
+  Tag next_tag = static_cast<Tag>(Runs::TagType::url);
+
+  std::map<Tag, std::string> links;
+  std::map<Tag, std::string> reference_links;
+  std::unordered_map<std::string, std::string> references;
+  /// Code and language of the code blocks, tagged to keep track of their offsets
+  std::map<Tag, std::pair<std::string, std::string>> code_blocks;
+  bool remove_trailing_newlines = false;
+
+  std::string rendered_text;
+  /// Number of characters in rendered_text
+  int text_size = 0;
+  /// Sorted, non-overlapping and non-adjacent character ranges of each tag
+  std::map<Tag, std::vector<std::pair<int, int>>> tag_ranges;
+
+  size_t get_index(int offset);
+  std::string get_text(int start, int end);
+  /// Inserts at the end of the text
+  void insert(const std::string &text);
+  /// Inserts at the given offset. Like in Gtk::TextBuffer, the inserted text is only tagged if it is inserted inside a tagged range.
+  void insert(int offset, const std::string &text);
+  void insert_with_tag(const std::string &text, Tag tag);
+  void erase(int start, int end);
+  Tag create_tag() { return next_tag++; }
+  void apply_tag(Tag tag, int start, int end);
+  void remove_tag(Tag tag, int start, int end);
+  /// Returns the first range of the given tag
+  boost::optional<std::pair<int, int>> get_tag_range(Tag tag);
+  /// Same as checking the last character of the tooltip buffer with Gtk::TextIter::starts_line()
+  bool last_character_starts_line();
+  void add_code_block(const std::string &code, const std::string &language_id);
+};
+
+size_t Tooltip::Renderer::get_index(int offset) {
+  size_t index = 0;
+  for(int c = 0; c < offset && index < rendered_text.size(); ++c) {
+    ++index;
+    while(index < rendered_text.size() && (static_cast<unsigned char>(rendered_text[index]) & 0b11000000) == 0b10000000)
+      ++index;
+  }
+  return index;
+}
+
+std::string Tooltip::Renderer::get_text(int start, int end) {
+  auto start_index = get_index(start);
+  return rendered_text.substr(start_index, get_index(end) - start_index);
+}
+
+void Tooltip::Renderer::insert(const std::string &text) {
+  rendered_text += text;
+  text_size += static_cast<int>(utf8_character_count(text));
+}
+
+void Tooltip::Renderer::insert(int offset, const std::string &text) {
+  rendered_text.insert(get_index(offset), text);
+  auto count = static_cast<int>(utf8_character_count(text));
+  text_size += count;
+  for(auto &tag : tag_ranges) {
+    for(auto &range : tag.second) {
+      if(range.first >= offset) {
+        range.first += count;
+        range.second += count;
+      }
+      else if(range.second > offset)
+        range.second += count;
+    }
+  }
+}
+
+void Tooltip::Renderer::insert_with_tag(const std::string &text, Tag tag) {
+  auto start_offset = text_size;
+  insert(text);
+  apply_tag(tag, start_offset, text_size);
+}
+
+void Tooltip::Renderer::erase(int start, int end) {
+  if(start >= end)
+    return;
+  auto start_index = get_index(start);
+  rendered_text.erase(start_index, get_index(end) - start_index);
+  text_size -= end - start;
+  auto get_offset = [start, end](int offset) {
+    if(offset <= start)
+      return offset;
+    if(offset <= end)
+      return start;
+    return offset - (end - start);
+  };
+  for(auto &tag : tag_ranges) {
+    std::vector<std::pair<int, int>> ranges;
+    for(auto &range : tag.second) {
+      auto range_start = get_offset(range.first);
+      auto range_end = get_offset(range.second);
+      if(range_start >= range_end)
+        continue;
+      if(!ranges.empty() && ranges.back().second >= range_start)
+        ranges.back().second = std::max(ranges.back().second, range_end);
+      else
+        ranges.emplace_back(range_start, range_end);
+    }
+    tag.second = std::move(ranges);
+  }
+}
+
+void Tooltip::Renderer::apply_tag(Tag tag, int start, int end) {
+  if(start >= end)
+    return;
+  auto &ranges = tag_ranges[tag];
+  auto it = std::find_if(ranges.begin(), ranges.end(), [start](const std::pair<int, int> &range) {
+    return range.second >= start;
+  });
+  auto last = it;
+  for(; last != ranges.end() && last->first <= end; ++last) {
+    start = std::min(start, last->first);
+    end = std::max(end, last->second);
+  }
+  it = ranges.erase(it, last);
+  ranges.emplace(it, start, end);
+}
+
+void Tooltip::Renderer::remove_tag(Tag tag, int start, int end) {
+  if(start >= end)
+    return;
+  auto it = tag_ranges.find(tag);
+  if(it == tag_ranges.end())
+    return;
+  std::vector<std::pair<int, int>> ranges;
+  for(auto &range : it->second) {
+    if(range.second <= start || range.first >= end)
+      ranges.emplace_back(range);
+    else {
+      if(range.first < start)
+        ranges.emplace_back(range.first, start);
+      if(range.second > end)
+        ranges.emplace_back(end, range.second);
+    }
+  }
+  it->second = std::move(ranges);
+}
+
+boost::optional<std::pair<int, int>> Tooltip::Renderer::get_tag_range(Tag tag) {
+  auto it = tag_ranges.find(tag);
+  if(it == tag_ranges.end() || it->second.empty())
+    return {};
+  return it->second.front();
+}
+
+bool Tooltip::Renderer::last_character_starts_line() {
+  if(text_size >= 2) {
+    auto index = rendered_text.size() - 1;
+    while(index > 0 && (static_cast<unsigned char>(rendered_text[index]) & 0b11000000) == 0b10000000)
+      --index;
+    return index > 0 && rendered_text[index - 1] == '\n';
+  }
+  if(text_size == 1)
+    return context.ends_line;
+  return context.last_character_starts_line;
+}
+
+void Tooltip::Renderer::add_code_block(const std::string &code, const std::string &language_id) {
+  auto start_offset = text_size;
+  insert_with_tag(code, code_block_tag);
+  auto tag = create_tag();
+  apply_tag(tag, start_offset, text_size);
+  code_blocks.emplace(tag, std::make_pair(code, language_id));
+}
+
+Tooltip::Runs Tooltip::Renderer::get_runs() {
+  Runs runs;
+  runs.text = rendered_text;
+  for(auto &tag : tag_ranges) {
+    if(tag.second.empty())
+      continue;
+    Runs::Run run;
+    if(tag.first < static_cast<Tag>(Runs::TagType::url))
+      run.type = static_cast<Runs::TagType>(tag.first);
+    else if(links.count(tag.first)) {
+      run.type = Runs::TagType::url;
+      run.value = links.at(tag.first);
+    }
+    else if(reference_links.count(tag.first)) {
+      run.type = Runs::TagType::reference_link;
+      run.value = reference_links.at(tag.first);
+    }
+    else {
+      auto it = code_blocks.find(tag.first);
+      if(it != code_blocks.end())
+        runs.code_blocks.push_back({tag.second.front().first, it->second.first, it->second.second});
+      continue;
+    }
+    run.ranges = tag.second;
+    runs.runs.emplace_back(std::move(run));
+  }
+  for(auto &reference : references) {
+    if(context.references.find(reference.first) == context.references.end())
+      runs.references.emplace_back(reference);
+  }
+  runs.remove_trailing_newlines = remove_trailing_newlines;
+  return runs;
+}
+
+std::shared_ptr<const Tooltip::Runs> Tooltip::get_runs(std::string key, const RenderContext &context, const std::function<void(Renderer &)> &render) {
+  key += '\0' + std::to_string(context.ends_line) + std::to_string(context.last_character_starts_line);
+  for(auto &reference : context.references)
+    key += '\0' + reference.first + '\0' + reference.second;
+
+  {
+    LockGuard lock(runs_cache_mutex);
+    auto it = runs_cache.find(key);
+    if(it != runs_cache.end())
+      return it->second;
+  }
+
+  Renderer renderer(context);
+  render(renderer);
+  auto runs = std::make_shared<const Runs>(renderer.get_runs());
+
+  LockGuard lock(runs_cache_mutex);
+  if(runs_cache.size() >= 500)
+    runs_cache.clear();
+  return runs_cache.emplace(std::move(key), std::move(runs)).first->second;
+}
+
+std::shared_ptr<const Tooltip::Runs> Tooltip::get_markdown_runs(const std::string &input, const RenderContext &context) {
+  return get_runs(std::string("markdown") + '\0' + input, context, [&input](Renderer &renderer) {
+    renderer.insert_markdown(input);
+  });
+}
+
+std::shared_ptr<const Tooltip::Runs> Tooltip::get_doxygen_runs(const std::string &input, bool remove_delimiters, const RenderContext &context) {
+  return get_runs(std::string("doxygen") + '\0' + std::to_string(remove_delimiters) + '\0' + context.language_id + '\0' + input, context, [&input, remove_delimiters](Renderer &renderer) {
+    renderer.insert_doxygen(input, remove_delimiters);
+  });
+}
+
+std::shared_ptr<const Tooltip::Runs> Tooltip::get_docstring_runs(const std::string &input, const RenderContext &context) {
+  return get_runs(std::string("docstring") + '\0' + input, context, [&input](Renderer &renderer) {
+    renderer.insert_docstring(input);
+  });
+}
+
+Tooltip::RenderContext Tooltip::get_render_context() {
+  RenderContext context;
+  auto end = buffer->end();
+  context.ends_line = end.starts_line();
+  context.last_character_starts_line = !end.backward_char() || end.starts_line();
+  context.references = references;
+  if(auto source_view = dynamic_cast<Source::View *>(view))
+    context.language_id = source_view->language_id;
+  return context;
+}
+
+void Tooltip::insert_runs(const Runs &runs) {
+  create_tags();
+
+  auto start_offset = buffer->get_insert()->get_iter().get_offset();
+  buffer->insert_at_cursor(runs.text);
+  auto run_tags = get_run_tags();
+  for(auto &run : runs.runs) {
+    Glib::RefPtr<Gtk::TextTag> tag;
+    if(run.type == Runs::TagType::url) {
+      tag = buffer->create_tag();
+      links.emplace(tag, run.value);
+    }
+    else if(run.type == Runs::TagType::reference_link) {
+      tag = buffer->create_tag();
+      reference_links.emplace(tag, run.value);
+    }
+    else
+      tag = *run_tags[static_cast<size_t>(run.type)].second;
+    for(auto &range : run.ranges)
+      buffer->apply_tag(tag, buffer->get_iter_at_offset(start_offset + range.first), buffer->get_iter_at_offset(start_offset + range.second));
+  }
+  for(auto &code_block : runs.code_blocks) {
+    if(auto language = get_language(code_block.language_id))
+      highlight_code(buffer->get_iter_at_offset(start_offset + code_block.offset), code_block.code, language);
+  }
+  for(auto &reference : runs.references)
+    references.emplace(reference);
+  if(runs.remove_trailing_newlines)
+    remove_trailing_newlines();
+}
+
 void Tooltip::insert_with_links_tagged(const std::string &text) {
   if(text.empty())
     return;
@@ -454,9 +781,24 @@ void Tooltip::insert_with_links_tagged(const std::string &text) {
     buffer->insert(buffer->get_insert()->get_iter(), &text[start_pos], text.c_str() + text.size());
 }
 
-void Tooltip::insert_markdown(const std::string &input) {
-  create_tags();
+void Tooltip::Renderer::insert_with_links_tagged(const std::string &text) {
+  if(text.empty())
+    return;
+  const static std::regex http_regex("https?://[\\w\\-.~:/?#%\\[\\]@!$&'()*+,;=]+[\\w\\-~/#@$*+;=]", std::regex::optimize);
+  std::smatch sm;
+  std::sregex_iterator it(text.begin(), text.end(), http_regex);
+  std::sregex_iterator end;
+  size_t start_pos = 0;
+  for(; it != end; ++it) {
+    insert(text.substr(start_pos, it->position() - start_pos));
+    insert_with_tag(text.substr(it->position(), it->length()), link_tag);
+    start_pos = it->position() + it->length();
+  }
+  if(start_pos < text.size())
+    insert(text.substr(start_pos));
+}
 
+void Tooltip::Renderer::insert_markdown(const std::string &input) {
   size_t i = 0;
 
   auto forward_to = [&](const std::vector<char> chars) {
@@ -568,15 +910,15 @@ void Tooltip::insert_markdown(const std::string &input) {
       }
       insert_with_links_tagged(partial);
       partial.clear();
-      auto start_offset = buffer->get_insert()->get_iter().get_offset();
+      auto start_offset = text_size;
       insert_text(start, i);
       if(prefix.size() == 1)
-        buffer->apply_tag(italic_tag, buffer->get_iter_at_offset(start_offset), buffer->get_insert()->get_iter());
+        apply_tag(italic_tag, start_offset, text_size);
       else if(prefix.size() == 2)
-        buffer->apply_tag(bold_tag, buffer->get_iter_at_offset(start_offset), buffer->get_insert()->get_iter());
+        apply_tag(bold_tag, start_offset, text_size);
       else {
-        buffer->apply_tag(italic_tag, buffer->get_iter_at_offset(start_offset), buffer->get_insert()->get_iter());
-        buffer->apply_tag(bold_tag, buffer->get_iter_at_offset(start_offset), buffer->get_insert()->get_iter());
+        apply_tag(italic_tag, start_offset, text_size);
+        apply_tag(bold_tag, start_offset, text_size);
       }
       i += prefix.size() - 1;
       return true;
@@ -598,9 +940,9 @@ void Tooltip::insert_markdown(const std::string &input) {
           }
           insert_with_links_tagged(partial);
           partial.clear();
-          auto start_offset = buffer->get_insert()->get_iter().get_offset();
+          auto start_offset = text_size;
           insert_text(start, i);
-          buffer->apply_tag(strikethrough_tag, buffer->get_iter_at_offset(start_offset), buffer->get_insert()->get_iter());
+          apply_tag(strikethrough_tag, start_offset, text_size);
           i++;
           return true;
         }
@@ -635,7 +977,7 @@ void Tooltip::insert_markdown(const std::string &input) {
             }
             insert_with_links_tagged(partial);
             partial.clear();
-            buffer->insert_with_tag(buffer->get_insert()->get_iter(), input.substr(start, i - start), code_tag);
+            insert_with_tag(input.substr(start, i - start), code_tag);
             if(two_backticks)
               i++;
             return true;
@@ -675,13 +1017,12 @@ void Tooltip::insert_markdown(const std::string &input) {
             }
             insert_with_links_tagged(partial);
             partial.clear();
-            auto start_offset = buffer->get_insert()->get_iter().get_offset();
+            auto start_offset = text_size;
             insert_text(text_start, text_end);
-            auto start = buffer->get_iter_at_offset(start_offset);
-            auto end = buffer->get_insert()->get_iter();
-            buffer->apply_tag(link_tag, start, end);
-            auto tag = buffer->create_tag();
-            buffer->apply_tag(tag, start, end);
+            auto end_offset = text_size;
+            apply_tag(link_tag, start_offset, end_offset);
+            auto tag = create_tag();
+            apply_tag(tag, start_offset, end_offset);
             links.emplace(tag, input.substr(link_start, i - link_start));
             return true;
           }
@@ -698,27 +1039,25 @@ void Tooltip::insert_markdown(const std::string &input) {
             }
             insert_with_links_tagged(partial);
             partial.clear();
-            auto start_offset = buffer->get_insert()->get_iter().get_offset();
+            auto start_offset = text_size;
             insert_text(text_start, text_end);
-            auto start = buffer->get_iter_at_offset(start_offset);
-            auto end = buffer->get_insert()->get_iter();
-            buffer->apply_tag(link_tag, start, end);
-            auto tag = buffer->create_tag();
-            buffer->apply_tag(tag, start, end);
+            auto end_offset = text_size;
+            apply_tag(link_tag, start_offset, end_offset);
+            auto tag = create_tag();
+            apply_tag(tag, start_offset, end_offset);
             reference_links.emplace(tag, input.substr(link_start, i - link_start));
             return true;
           }
           else if(text_start != text_end) {
             insert_with_links_tagged(partial);
             partial.clear();
-            auto start_offset = buffer->get_insert()->get_iter().get_offset();
+            auto start_offset = text_size;
             insert_text(text_start, text_end);
-            auto start = buffer->get_iter_at_offset(start_offset);
-            auto end = buffer->get_insert()->get_iter();
-            buffer->apply_tag(link_tag, start, end);
-            auto tag = buffer->create_tag();
-            buffer->apply_tag(tag, start, end);
-            reference_links.emplace(tag, buffer->get_text(start, end));
+            auto end_offset = text_size;
+            apply_tag(link_tag, start_offset, end_offset);
+            auto tag = create_tag();
+            apply_tag(tag, start_offset, end_offset);
+            reference_links.emplace(tag, get_text(start_offset, end_offset));
             i = text_end;
             return true;
           }
@@ -776,18 +1115,17 @@ void Tooltip::insert_markdown(const std::string &input) {
     forward_passed({' '});
     auto start = i;
     forward_to({'\n'});
-    auto end = buffer->end();
-    if(end.backward_char() && !end.starts_line())
-      buffer->insert_at_cursor("\n");
-    auto start_offset = buffer->get_insert()->get_iter().get_offset();
+    if(!last_character_starts_line())
+      insert("\n");
+    auto start_offset = text_size;
     insert_text(start, i);
     if(header == 1)
-      buffer->apply_tag(h1_tag, buffer->get_iter_at_offset(start_offset), buffer->get_insert()->get_iter());
+      apply_tag(h1_tag, start_offset, text_size);
     else if(header == 2)
-      buffer->apply_tag(h2_tag, buffer->get_iter_at_offset(start_offset), buffer->get_insert()->get_iter());
+      apply_tag(h2_tag, start_offset, text_size);
     else if(header == 3)
-      buffer->apply_tag(h3_tag, buffer->get_iter_at_offset(start_offset), buffer->get_insert()->get_iter());
-    buffer->insert_at_cursor("\n\n");
+      apply_tag(h3_tag, start_offset, text_size);
+    insert("\n\n");
     if(end_next_line != std::string::npos)
       i = end_next_line;
     return true;
@@ -811,9 +1149,9 @@ void Tooltip::insert_markdown(const std::string &input) {
       if(i == input.size() || input[i] == '\n') {
         if(i < input.size())
           ++i;
-        buffer->insert_at_cursor("---\n");
+        insert("---\n");
         if(is_empty_line())
-          buffer->insert_at_cursor("\n");
+          insert("\n");
         return true;
       }
     }
@@ -835,10 +1173,10 @@ void Tooltip::insert_markdown(const std::string &input) {
             i = i_saved;
             return false;
           }
-          insert_code(input.substr(start, i - start), language, true);
+          add_code_block(input.substr(start, i - start), language);
           i += 4;
           if(is_empty_line())
-            buffer->insert_at_cursor("\n");
+            insert("\n");
           return true;
         }
       }
@@ -868,12 +1206,10 @@ void Tooltip::insert_markdown(const std::string &input) {
           if(forward_passed({' ', '\n'})) {
             auto link_start = i;
             forward_to({' ', '\n'});
-            auto start_offset = buffer->get_insert()->get_iter().get_offset();
+            auto start_offset = text_size;
             insert_text(reference_start, reference_end);
-            auto start = buffer->get_iter_at_offset(start_offset);
-            auto end = buffer->get_insert()->get_iter();
-            references.emplace(buffer->get_text(start, end), input.substr(link_start, i - link_start));
-            buffer->erase(start, end);
+            references.emplace(get_text(start_offset, text_size), input.substr(link_start, i - link_start));
+            erase(start_offset, text_size);
             return true;
           }
         }
@@ -906,7 +1242,7 @@ void Tooltip::insert_markdown(const std::string &input) {
         }
         if(is_empty_line()) {
           insert_text(start, i - 1);
-          buffer->insert_at_cursor("\n\n");
+          insert("\n\n");
           break;
         }
         auto i_saved = i;
@@ -916,7 +1252,7 @@ void Tooltip::insert_markdown(const std::string &input) {
           if(starts_with(input, i, "- ") || starts_with(input, i, "+ ") || starts_with(input, i, "* ") || (is_number() && forward_passed_number() && starts_with(input, i, ". "))) {
             i = i_saved2;
             insert_text(start, i_saved - 1);
-            buffer->insert_at_cursor('\n' + input.substr(i_saved, i - i_saved));
+            insert('\n' + input.substr(i_saved, i - i_saved));
             insert_list();
             break;
           }
@@ -958,22 +1294,18 @@ void Tooltip::insert_markdown(const std::string &input) {
     while(start < i && (input[start] == ' ' || input[start] == '\t' || input[start] == '\n'))
       ++start;
     insert_text(start, i);
-    buffer->insert_at_cursor(ends_with_empty_line ? "\n\n" : "\n");
+    insert(ends_with_empty_line ? "\n\n" : "\n");
   }
 
   // Remove invalid reference links
   for(auto link_it = reference_links.begin(); link_it != reference_links.end();) {
     auto reference_it = references.find(link_it->second);
     if(reference_it == references.end()) {
-      auto it = buffer->begin();
-      if(it.begins_tag(link_it->first) || it.forward_to_tag_toggle(link_it->first)) {
-        auto start = it;
-        it.forward_to_tag_toggle(link_it->first);
-        buffer->remove_tag(link_tag, start, it);
-        buffer->remove_tag(link_it->first, buffer->begin(), buffer->end());
-        auto start_mark = Source::Mark(start);
-        buffer->insert(it, "]");
-        buffer->insert(start_mark->get_iter(), "[");
+      if(auto range = get_tag_range(link_it->first)) {
+        remove_tag(link_tag, range->first, range->second);
+        remove_tag(link_it->first, 0, text_size);
+        insert(range->second, "]");
+        insert(range->first, "[");
         link_it = reference_links.erase(link_it);
         continue;
       }
@@ -981,7 +1313,7 @@ void Tooltip::insert_markdown(const std::string &input) {
     ++link_it;
   }
 
-  remove_trailing_newlines();
+  remove_trailing_newlines = true;
 }
 
 void Tooltip::insert_code(const std::string &code, boost::variant<std::string, Glib::RefPtr<Gsv::Language>> language_variant, bool block) {
@@ -1003,55 +1335,8 @@ void Tooltip::insert_code(const std::string &code, boost::variant<std::string, G
 
   buffer->insert_with_tag(insert_iter, code, block ? code_block_tag : code_tag);
 
-  if(view) {
-    Glib::RefPtr<Gsv::Language> language;
-    if(auto language_ptr = boost::get<Glib::RefPtr<Gsv::Language>>(&language_variant))
-      language = *language_ptr;
-    else if(auto language_identifier = boost::get<std::string>(&language_variant)) {
-      if(!language_identifier->empty()) {
-        language = Source::LanguageManager::get_default()->get_language(*language_identifier);
-        if(!language)
-          language = Source::guess_language('.' + *language_identifier);
-        if(!language) {
-          if(auto source_view = dynamic_cast<Source::View *>(view))
-            language = Source::LanguageManager::get_default()->get_language(source_view->language_id);
-        }
-      }
-    }
-    if(language) {
-      Gsv::View tmp_view;
-      tmp_view.get_buffer()->set_text(code);
-      auto scheme = view->get_source_buffer()->get_style_scheme();
-      tmp_view.get_source_buffer()->set_style_scheme(scheme);
-      tmp_view.get_source_buffer()->set_language(language);
-      tmp_view.get_source_buffer()->set_highlight_syntax(true);
-      tmp_view.get_source_buffer()->ensure_highlight(tmp_view.get_buffer()->begin(), tmp_view.get_buffer()->end());
-
-      auto start_iter = start_mark->get_iter();
-      tmp_view.get_buffer()->get_tag_table()->foreach([this, &tmp_view, &start_iter](const Glib::RefPtr<Gtk::TextTag> &tmp_tag) {
-        if(tmp_tag->property_foreground_set()) {
-          auto tag = buffer->create_tag();
-          tag->property_foreground_rgba() = tmp_tag->property_foreground_rgba().get_value();
-
-          auto tmp_iter = tmp_view.get_source_buffer()->begin();
-          Gtk::TextIter tmp_start;
-          if(tmp_iter.begins_tag(tmp_tag))
-            tmp_start = tmp_iter;
-          while(tmp_iter.forward_to_tag_toggle(tmp_tag)) {
-            if(tmp_iter.ends_tag(tmp_tag)) {
-              auto start = start_iter;
-              start.forward_chars(tmp_start.get_offset());
-              auto end = start_iter;
-              end.forward_chars(tmp_iter.get_offset());
-              buffer->apply_tag(tag, start, end);
-            }
-            else
-              tmp_start = tmp_iter;
-          }
-        }
-      });
-    }
-  }
+  if(auto language = get_language(language_variant))
+    highlight_code(start_mark->get_iter(), code, language);
 
   // Make long type descriptions readable
   if(style_format_type_description) {
@@ -1091,9 +1376,74 @@ void Tooltip::insert_code(const std::string &code, boost::variant<std::string, G
   }
 }
 
-void Tooltip::insert_doxygen(const std::string &input_, bool remove_delimiters) {
-  create_tags();
+Glib::RefPtr<Gsv::Language> Tooltip::get_language(const boost::variant<std::string, Glib::RefPtr<Gsv::Language>> &language_variant) {
+  if(!view)
+    return {};
+  Glib::RefPtr<Gsv::Language> language;
+  if(auto language_ptr = boost::get<Glib::RefPtr<Gsv::Language>>(&language_variant))
+    language = *language_ptr;
+  else if(auto language_identifier = boost::get<std::string>(&language_variant)) {
+    if(!language_identifier->empty()) {
+      language = Source::LanguageManager::get_default()->get_language(*language_identifier);
+      if(!language)
+        language = Source::guess_language('.' + *language_identifier);
+      if(!language) {
+        if(auto source_view = dynamic_cast<Source::View *>(view))
+          language = Source::LanguageManager::get_default()->get_language(source_view->language_id);
+      }
+    }
+  }
+  return language;
+}
+
+void Tooltip::highlight_code(const Gtk::TextIter &start_iter, const std::string &code, const Glib::RefPtr<Gsv::Language> &language) {
+  auto scheme = view->get_source_buffer()->get_style_scheme();
+  auto key = (scheme ? scheme->get_id() : std::string()) + '\0' + language->get_id() + '\0' + code;
+  auto it = highlight_cache.find(key);
+  if(it == highlight_cache.end()) {
+    Gsv::View tmp_view;
+    tmp_view.get_buffer()->set_text(code);
+    tmp_view.get_source_buffer()->set_style_scheme(scheme);
+    tmp_view.get_source_buffer()->set_language(language);
+    tmp_view.get_source_buffer()->set_highlight_syntax(true);
+    tmp_view.get_source_buffer()->ensure_highlight(tmp_view.get_buffer()->begin(), tmp_view.get_buffer()->end());
+
+    std::vector<std::pair<Gdk::RGBA, std::vector<std::pair<int, int>>>> colors;
+    tmp_view.get_buffer()->get_tag_table()->foreach([&tmp_view, &colors](const Glib::RefPtr<Gtk::TextTag> &tmp_tag) {
+      if(tmp_tag->property_foreground_set()) {
+        colors.emplace_back(tmp_tag->property_foreground_rgba().get_value(), std::vector<std::pair<int, int>>());
+        auto tmp_iter = tmp_view.get_source_buffer()->begin();
+        Gtk::TextIter tmp_start;
+        if(tmp_iter.begins_tag(tmp_tag))
+          tmp_start = tmp_iter;
+        while(tmp_iter.forward_to_tag_toggle(tmp_tag)) {
+          if(tmp_iter.ends_tag(tmp_tag))
+            colors.back().second.emplace_back(tmp_start.get_offset(), tmp_iter.get_offset());
+          else
+            tmp_start = tmp_iter;
+        }
+      }
+    });
+
+    if(highlight_cache.size() >= 500)
+      highlight_cache.clear();
+    it = highlight_cache.emplace(std::move(key), std::move(colors)).first;
+  }
+
+  for(auto &color : it->second) {
+    auto tag = buffer->create_tag();
+    tag->property_foreground_rgba() = color.first;
+    for(auto &range : color.second) {
+      auto start = start_iter;
+      start.forward_chars(range.first);
+      auto end = start_iter;
+      end.forward_chars(range.second);
+      buffer->apply_tag(tag, start, end);
+    }
+  }
+}
 
+void Tooltip::Renderer::insert_doxygen(const std::string &input_, bool remove_delimiters) {
   auto get_text = [&] {
     auto &input = input_;
     size_t i = 0;
@@ -1285,10 +1635,8 @@ void Tooltip::insert_doxygen(const std::string &input_, bool remove_delimiters)
               ++i;
               auto token = get_token();
               if(token == "endcode") {
-                if(language_id.empty() && view) {
-                  if(auto source_view = dynamic_cast<Source::View *>(view))
-                    language_id = source_view->language_id;
-                }
+                if(language_id.empty())
+                  language_id = context.language_id;
                 markdown += "```" + language_id + '\n' + input.substr(start, end - start) + "\n```\n";
                 ++i;
                 break;
@@ -1452,9 +1800,7 @@ void Tooltip::insert_doxygen(const std::string &input_, bool remove_delimiters)
     insert_markdown(markdown);
 }
 
-void Tooltip::insert_docstring(const std::string &input_) {
-  create_tags();
-
+void Tooltip::Renderer::insert_docstring(const std::string &input_) {
   // Workaround for python-language-server that returns unnecessary function signatures
   const static std::regex regex("^([a-zA-Z0-9_]+\\([^\n]*\\)( -> [^\n]+)?(\n|$))+(\n|$)", std::regex::extended | std::regex::optimize);
   std::smatch sm;
@@ -1518,13 +1864,13 @@ void Tooltip::insert_docstring(const std::string &input_) {
     }
     insert_with_links_tagged(partial);
     partial.clear();
-    auto start_offset = buffer->get_insert()->get_iter().get_offset();
+    auto start_offset = text_size;
     insert_with_links_tagged(input.substr(i_saved, end_header - i_saved));
     if(header == 1)
-      buffer->apply_tag(h1_tag, buffer->get_iter_at_offset(start_offset), buffer->get_insert()->get_iter());
+      apply_tag(h1_tag, start_offset, text_size);
     else if(header == 2)
-      buffer->apply_tag(h2_tag, buffer->get_iter_at_offset(start_offset), buffer->get_insert()->get_iter());
-    buffer->insert_at_cursor("\n");
+      apply_tag(h2_tag, start_offset, text_size);
+    insert("\n");
     return true;
   };
 
@@ -1581,12 +1927,12 @@ void Tooltip::insert_docstring(const std::string &input_) {
     }
     insert_with_links_tagged(partial);
     partial.clear();
-    auto start_offset = buffer->get_insert()->get_iter().get_offset();
+    auto start_offset = text_size;
     insert_with_links_tagged(input.substr(start, i - start));
     if(prefix.size() == 1)
-      buffer->apply_tag(italic_tag, buffer->get_iter_at_offset(start_offset), buffer->get_insert()->get_iter());
+      apply_tag(italic_tag, start_offset, text_size);
     else if(prefix.size() == 2)
-      buffer->apply_tag(bold_tag, buffer->get_iter_at_offset(start_offset), buffer->get_insert()->get_iter());
+      apply_tag(bold_tag, start_offset, text_size);
     i += prefix.size() - 1;
     return true;
   };
@@ -1624,13 +1970,12 @@ void Tooltip::insert_docstring(const std::string &input_) {
               if(sm[1].length() == 0)
                 insert_with_links_tagged(sm[2].str());
               else {
-                auto start_offset = buffer->get_insert()->get_iter().get_offset();
-                buffer->insert_at_cursor(sm[1].str());
-                auto start = buffer->get_iter_at_offset(start_offset);
-                auto end = buffer->get_insert()->get_iter();
-                buffer->apply_tag(link_tag, start, end);
-                auto tag = buffer->create_tag();
-                buffer->apply_tag(tag, start, end);
+                auto start_offset = text_size;
+                insert(sm[1].str());
+                auto end_offset = text_size;
+                apply_tag(link_tag, start_offset, end_offset);
+                auto tag = create_tag();
+                apply_tag(tag, start_offset, end_offset);
                 links.emplace(tag, sm[2].str());
               }
             }
@@ -1639,7 +1984,7 @@ void Tooltip::insert_docstring(const std::string &input_) {
             ++i;
           }
           else {
-            buffer->insert_with_tag(buffer->get_insert()->get_iter(), input.substr(start, i - start), code_tag);
+            insert_with_tag(input.substr(start, i - start), code_tag);
             if(two_backticks)
               i++;
           }
@@ -1657,14 +2002,14 @@ void Tooltip::insert_docstring(const std::string &input_) {
       ++i;
       insert_with_links_tagged(partial.substr(0, partial.size() - 2)); // Remove one ':'
       partial.clear();
-      buffer->insert_at_cursor("\n\n");
+      insert("\n\n");
       auto start = i;
       for(; i < input.size(); ++i) {
         if(starts_with(input, i, "\n\n") && i + 2 < input.size() && !is_whitespace_character(i + 2))
           break;
       }
-      insert_code(input.substr(start, i - start), "python", true);
-      buffer->insert_at_cursor("\n");
+      add_code_block(input.substr(start, i - start), "python");
+      insert("\n");
       return true;
     }
     while(i < input.size() && input[i] != '\n' && is_whitespace_character(i))
@@ -1677,8 +2022,8 @@ void Tooltip::insert_docstring(const std::string &input_) {
         if(starts_with(input, i, "\n\n") && i + 2 < input.size() && !is_whitespace_character(i + 2))
           break;
       }
-      insert_code(input.substr(i_saved, i - i_saved), "python", true);
-      buffer->insert_at_cursor("\n");
+      add_code_block(input.substr(i_saved, i - i_saved), "python");
+      insert("\n");
       return true;
     }
     i = i_saved;
@@ -1698,6 +2043,32 @@ void Tooltip::insert_docstring(const std::string &input_) {
     insert_with_links_tagged(partial);
 }
 
+void Tooltip::insert_markdown(const std::string &input) {
+  insert_runs(*get_markdown_runs(input, get_render_context()));
+}
+
+void Tooltip::insert_doxygen(const std::string &input, bool remove_delimiters) {
+  insert_runs(*get_doxygen_runs(input, remove_delimiters, get_render_context()));
+}
+
+void Tooltip::insert_docstring(const std::string &input) {
+  insert_runs(*get_docstring_runs(input, get_render_context()));
+}
+
+void Tooltip::prerender_markdown(const std::string &input) {
+  get_markdown_runs(input, RenderContext());
+}
+
+void Tooltip::prerender_doxygen(const std::string &input, bool remove_delimiters, const std::string &language_id) {
+  RenderContext context;
+  context.language_id = language_id;
+  get_doxygen_runs(input, remove_delimiters, context);
+}
+
+void Tooltip::prerender_docstring(const std::string &input) {
+  get_docstring_runs(input, RenderContext());
+}
+
 void Tooltip::remove_trailing_newlines() {
   auto end = buffer->end();
   while(end.starts_line() && end.backward_char()) {
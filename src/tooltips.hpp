@@ -1,4 +1,5 @@
 #pragma once
+#include "mutex.hpp"
 #include "source_base.hpp"
 #include <boost/optional.hpp>
 #include <boost/variant.hpp>
@@ -34,6 +35,13 @@ public:
   /// Remove empty lines at end of buffer
   void remove_trailing_newlines();
 
+  /// Renders and caches markdown ahead of insert_markdown. Can be called from any thread.
+  static void prerender_markdown(const std::string &input);
+  /// Renders and caches doxygen ahead of insert_doxygen in a view with the given language. Can be called from any thread.
+  static void prerender_doxygen(const std::string &input, bool remove_delimiters, const std::string &language_id);
+  /// Renders and caches python docstring ahead of insert_docstring. Can be called from any thread.
+  static void prerender_docstring(const std::string &input);
+
 private:
   std::unique_ptr<Gtk::Window> window;
   Gtk::ScrolledWindow *scrolled_window = nullptr;
@@ -61,6 +69,60 @@ private:
   std::map<Glib::RefPtr<Gtk::TextTag>, std::string> reference_links;
   std::unordered_map<std::string, std::string> references;
 
+  class Renderer;
+
+  /// Text and tag ranges inserted by one insert_markdown, insert_doxygen or insert_docstring call
+  struct Runs {
+    enum class TagType { link, h1, h2, h3, code, code_block, bold, italic, strikethrough, url, reference_link };
+    struct Run {
+      TagType type;
+      /// Url or reference name of link tags
+      std::string value;
+      /// Character offsets relative to the start of text
+      std::vector<std::pair<int, int>> ranges;
+    };
+    /// Code block to syntax highlight when the runs are inserted
+    struct CodeBlock {
+      int offset;
+      std::string code;
+      std::string language_id;
+    };
+    std::string text;
+    std::vector<Run> runs;
+    std::vector<CodeBlock> code_blocks;
+    std::vector<std::pair<std::string, std::string>> references;
+    bool remove_trailing_newlines = false;
+  };
+  /// The buffer state that rendering depends on
+  struct RenderContext {
+    /// True if the buffer is empty or ends with a newline
+    bool ends_line = true;
+    /// True if the buffer is empty or its last character starts a line
+    bool last_character_starts_line = true;
+    std::unordered_map<std::string, std::string> references;
+    /// Language used for doxygen code blocks without a language
+    std::string language_id;
+  };
+
+  static Mutex runs_cache_mutex;
+  /// Rendered documentation keyed on the render function, its input and the render context
+  static std::unordered_map<std::string, std::shared_ptr<const Runs>> runs_cache GUARDED_BY(runs_cache_mutex);
+  /// Returns the cached runs for key, or renders and caches them. Can be called from any thread.
+  static std::shared_ptr<const Runs> get_runs(std::string key, const RenderContext &context, const std::function<void(Renderer &)> &render);
+  static std::shared_ptr<const Runs> get_markdown_runs(const std::string &input, const RenderContext &context);
+  static std::shared_ptr<const Runs> get_doxygen_runs(const std::string &input, bool remove_delimiters, const RenderContext &context);
+  static std::shared_ptr<const Runs> get_docstring_runs(const std::string &input, const RenderContext &context);
+
+  RenderContext get_render_context();
+  void insert_runs(const Runs &runs);
+  std::vector<std::pair<Runs::TagType, Glib::RefPtr<Gtk::TextTag> *>> get_run_tags();
+
+  /// Foreground colors and their character ranges, keyed on style scheme, language and code.
+  /// Only accessed from the main GUI thread.
+  static std::unordered_map<std::string, std::vector<std::pair<Gdk::RGBA, std::vector<std::pair<int, int>>>>> highlight_cache;
+  Glib::RefPtr<Gsv::Language> get_language(const boost::variant<std::string, Glib::RefPtr<Gsv::Language>> &language_variant);
+  void highlight_code(const Gtk::TextIter &start_iter, const std::string &code, const Glib::RefPtr<Gsv::Language> &language);
+
   void wrap_lines();
   void create_tags();
 };
@@ -76,10 +138,13 @@ public:
   void hide(const boost::optional<std::pair<int, int>> &last_mouse_pos = {}, const boost::optional<std::pair<int, int>> &mouse_pos = {});
   void clear() { tooltip_list.clear(); };
 
+  using iterator = std::list<Tooltip>::iterator;
   template <typename... Ts>
-  void emplace_back(Ts &&...params) {
+  iterator emplace_back(Ts &&...params) {
     tooltip_list.emplace_back(std::forward<Ts>(params)...);
+    return std::prev(tooltip_list.end());
   }
+  void erase(iterator it) { tooltip_list.erase(it); }
 
   std::function<void()> on_motion;
 
@@ -0,0 +1,185 @@
+#include "trace.hpp"
+#ifdef JUCI_ENABLE_TRACE
+#include "json.hpp"
+#include "mutex.hpp"
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <memory>
+#include <vector>
+
+namespace {
+  struct Event {
+    /// 'X' for complete events, 'b' for async events and 'C' for counters
+    char phase;
+    const char *name;
+    /// Microseconds since epoch
+    long long timestamp;
+    /// Duration in microseconds for complete and async events, and value for counters
+    long long value;
+    size_t id;
+    std::string args;
+  };
+
+  /// Events are only written by the owning thread, but read and cleared by start() and write()
+  class ThreadEvents {
+  public:
+    static const size_t capacity = 16384;
+
+    ThreadEvents(size_t id) : id(id) {}
+
+    const size_t id;
+    Mutex mutex;
+    std::string name GUARDED_BY(mutex);
+    /// Ring buffer where next is the position of the oldest event when full
+    std::vector<Event> events GUARDED_BY(mutex);
+    size_t next GUARDED_BY(mutex) = 0;
+
+    void add(Event &&event) {
+      LockGuard lock(mutex);
+      if(events.size() < capacity)
+        events.emplace_back(std::move(event));
+      else
+        events[next] = std::move(event);
+      next = (next + 1) % capacity;
+    }
+  };
+
+  std::atomic<bool> recording(false);
+  std::atomic<size_t> last_async_id(0);
+  const Trace::Clock::time_point epoch = Trace::Clock::now();
+
+  Mutex threads_events_mutex;
+  std::vector<std::shared_ptr<ThreadEvents>> threads_events GUARDED_BY(threads_events_mutex);
+  size_t last_thread_id GUARDED_BY(threads_events_mutex) = 0;
+
+  ThreadEvents &get_thread_events() {
+    thread_local std::shared_ptr<ThreadEvents> thread_events = [] {
+      LockGuard lock(threads_events_mutex);
+      // Remove events of exited threads that were not recorded during the current recording
+      threads_events.erase(std::remove_if(threads_events.begin(), threads_events.end(), [](const std::shared_ptr<ThreadEvents> &thread_events) {
+                             if(thread_events.use_count() > 1)
+                               return false;
+                             LockGuard lock(thread_events->mutex);
+                             return thread_events->events.empty();
+                           }),
+                           threads_events.end());
+      threads_events.emplace_back(std::make_shared<ThreadEvents>(++last_thread_id));
+      return threads_events.back();
+    }();
+    return *thread_events;
+  }
+
+  long long get_microseconds(Trace::Clock::time_point time_point) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(time_point - epoch).count();
+  }
+} // namespace
+
+void Trace::start() {
+  LockGuard lock(threads_events_mutex);
+  for(auto &thread_events : threads_events) {
+    LockGuard lock(thread_events->mutex);
+    thread_events->events.clear();
+    thread_events->next = 0;
+  }
+  recording = true;
+}
+
+void Trace::stop() noexcept {
+  recording = false;
+}
+
+bool Trace::is_recording() noexcept {
+  return recording.load(std::memory_order_relaxed);
+}
+
+void Trace::complete(const char *name, Clock::time_point start, Clock::time_point end, std::string args) noexcept {
+  if(!is_recording())
+    return;
+  try {
+    get_thread_events().add({'X', name, get_microseconds(start), std::chrono::duration_cast<std::chrono::microseconds>(end - start).count(), 0, std::move(args)});
+  }
+  catch(...) {
+  }
+}
+
+void Trace::async(const char *name, Clock::time_point start, Clock::time_point end, std::string args) noexcept {
+  if(!is_recording())
+    return;
+  try {
+    get_thread_events().add({'b', name, get_microseconds(start), std::chrono::duration_cast<std::chrono::microseconds>(end - start).count(), ++last_async_id, std::move(args)});
+  }
+  catch(...) {
+  }
+}
+
+void Trace::counter(const char *name, long long value) noexcept {
+  if(!is_recording())
+    return;
+  try {
+    get_thread_events().add({'C', name, get_microseconds(Clock::now()), value, 0, {}});
+  }
+  catch(...) {
+  }
+}
+
+void Trace::set_thread_name(std::string name) noexcept {
+  try {
+    auto &thread_events = get_thread_events();
+    LockGuard lock(thread_events.mutex);
+    thread_events.name = std::move(name);
+  }
+  catch(...) {
+  }
+}
+
+bool Trace::write(const boost::filesystem::path &path) {
+  std::ofstream stream(path.string(), std::ofstream::binary);
+  if(!stream)
+    return false;
+
+  stream << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+  bool first = true;
+  auto write_separator = [&first, &stream] {
+    if(!first)
+      stream << ",\n";
+    first = false;
+  };
+
+  LockGuard lock(threads_events_mutex);
+  for(auto &thread_events : threads_events) {
+    LockGuard lock(thread_events->mutex);
+    auto tid = std::to_string(thread_events->id);
+    if(!thread_events->name.empty()) {
+      write_separator();
+      stream << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << tid << ",\"args\":{\"name\":\"" << JSON::escape_string(thread_events->name) << "\"}}";
+    }
+    auto &events = thread_events->events;
+    auto oldest = events.size() < ThreadEvents::capacity ? 0 : thread_events->next;
+    for(size_t i = 0; i < events.size(); ++i) {
+      auto &event = events[(oldest + i) % events.size()];
+      auto name = JSON::escape_string(event.name);
+      write_separator();
+      stream << "{\"name\":\"" << name << "\",\"ph\":\"" << event.phase << "\",\"pid\":1,\"tid\":" << tid << ",\"ts\":" << event.timestamp;
+      if(event.phase == 'X' || event.phase == 'b') {
+        if(event.phase == 'X')
+          stream << ",\"dur\":" << event.value;
+        else
+          stream << ",\"cat\":\"async\",\"id\":" << event.id;
+        if(!event.args.empty())
+          stream << ",\"args\":{" << event.args << '}';
+      }
+      else
+        stream << ",\"args\":{\"value\":" << event.value << '}';
+      stream << '}';
+      if(event.phase == 'b') {
+        write_separator();
+        stream << "{\"name\":\"" << name << "\",\"ph\":\"e\",\"pid\":1,\"tid\":" << tid << ",\"ts\":" << event.timestamp + event.value << ",\"cat\":\"async\",\"id\":" << event.id << '}';
+      }
+    }
+  }
+  stream << "]}\n";
+
+  return static_cast<bool>(stream);
+}
+#endif
@@ -0,0 +1,73 @@
+#pragma once
+#include <boost/filesystem.hpp>
+#include <chrono>
+#include <string>
+
+/// Records spans and counters in per-thread ring buffers, and writes them in the Chrome trace event format
+/// that can be opened in https://ui.perfetto.dev or chrome://tracing.
+///
+/// Nothing is recorded before start() is called, either from the Window menu or by setting the environment
+/// variable JUCI_TRACE to the path of the resulting trace file.
+/// All recording is compiled out when JUCI_ENABLE_TRACE is not defined (cmake -DENABLE_TRACE=OFF).
+class Trace {
+public:
+  using Clock = std::chrono::steady_clock;
+
+#ifdef JUCI_ENABLE_TRACE
+  /// Records the time from construction to destruction as a complete event.
+  /// Name must be a string literal.
+  class Span {
+  public:
+    Span(const char *name) noexcept : name(name), recording(is_recording()) {
+      if(recording)
+        start = Clock::now();
+    }
+    ~Span() {
+      if(recording)
+        complete(name, start, Clock::now(), std::move(args));
+    }
+    /// Content of a JSON object, for instance "\"size\":10".
+    /// Construct args only when is_recording() returns true.
+    void set_args(std::string args_) noexcept { args = std::move(args_); }
+
+  private:
+    const char *name;
+    bool recording;
+    Clock::time_point start;
+    std::string args;
+  };
+
+  static void start();
+  static void stop() noexcept;
+  static bool is_recording() noexcept;
+
+  /// Records an event that started and ended at the given times on the calling thread.
+  /// Name must be a string literal.
+  static void complete(const char *name, Clock::time_point start, Clock::time_point end, std::string args = {}) noexcept;
+  /// Records an event that can overlap other events on the same thread, for instance concurrent requests.
+  /// Name must be a string literal.
+  static void async(const char *name, Clock::time_point start, Clock::time_point end, std::string args = {}) noexcept;
+  /// Name must be a string literal.
+  static void counter(const char *name, long long value) noexcept;
+  /// Names the calling thread in the written trace.
+  static void set_thread_name(std::string name) noexcept;
+
+  /// Writes the events recorded since the last start(). Returns false if the file could not be written.
+  static bool write(const boost::filesystem::path &path);
+#else
+  class Span {
+  public:
+    Span(const char *) noexcept {}
+    void set_args(std::string) noexcept {}
+  };
+
+  static void start() {}
+  static void stop() noexcept {}
+  static constexpr bool is_recording() noexcept { return false; }
+  static void complete(const char *, Clock::time_point, Clock::time_point, std::string = {}) noexcept {}
+  static void async(const char *, Clock::time_point, Clock::time_point, std::string = {}) noexcept {}
+  static void counter(const char *, long long) noexcept {}
+  static void set_thread_name(std::string) noexcept {}
+  static bool write(const boost::filesystem::path &) { return false; }
+#endif
+};
@@ -0,0 +1,187 @@
+#include "translation_unit_cache.hpp"
+#include "filesystem.hpp"
+#include "json.hpp"
+#include "utility.hpp"
+#include <algorithm>
+#include <ctime>
+#include <functional>
+
+const boost::filesystem::path TranslationUnitCache::cache_folder = ".translation_units_clang";
+const boost::uintmax_t TranslationUnitCache::max_cache_size = 512 * 1024 * 1024;
+
+TranslationUnitCache::TranslationUnitCache(const boost::filesystem::path &project_path, const boost::filesystem::path &build_path, const boost::filesystem::path &path,
+                                           const std::vector<std::string> &arguments, int flags, const std::string &buffer)
+    : path(path), arguments(arguments), flags(flags) {
+  if(project_path.empty() || build_path.empty())
+    return;
+
+  auto path_str = filesystem::get_relative_path(path, project_path).string();
+  if(path_str.empty())
+    return;
+  for(auto &chr : path_str) {
+    if(chr == '/' || chr == '\\')
+      chr = '_';
+  }
+  ast_path = build_path / cache_folder / (path_str + ".ast");
+  info_path = build_path / cache_folder / (path_str + ".json");
+
+  auto arguments_str = std::to_string(flags) + '\0';
+  for(auto &argument : arguments) {
+    arguments_str += argument;
+    arguments_str += '\0';
+  }
+  arguments_hash = std::hash<std::string>()(arguments_str);
+  key = get_key(buffer);
+}
+
+std::string TranslationUnitCache::get_key(const std::string &buffer) const {
+  auto buffer_hash = std::hash<std::string>()(buffer);
+  return std::to_string(arguments_hash) + '-' + std::to_string(buffer_hash);
+}
+
+CXTranslationUnit TranslationUnitCache::load(CXIndex cx_index) const {
+  if(ast_path.empty())
+    return nullptr;
+
+  boost::system::error_code ec;
+  if(!boost::filesystem::exists(ast_path, ec))
+    return nullptr;
+
+  try {
+    JSON info(info_path);
+    if(info.string("key") != key)
+      return nullptr;
+    for(auto &include : info.array("includes")) {
+      auto last_write_time = boost::filesystem::last_write_time(include.string("path"), ec);
+      if(ec || last_write_time != include.integer("time"))
+        return nullptr;
+    }
+  }
+  catch(...) {
+    return nullptr;
+  }
+
+  auto cx_tu = clang_createTranslationUnit(cx_index, ast_path.string().c_str());
+  if(cx_tu)
+    boost::filesystem::last_write_time(ast_path, std::time(nullptr), ec); // Used by erase_least_recently_used()
+  return cx_tu;
+}
+
+bool TranslationUnitCache::can_save(const std::string &buffer) const {
+  return !ast_path.empty() && get_key(buffer) == key;
+}
+
+bool TranslationUnitCache::save(const std::string &buffer) const {
+  if(!can_save(buffer))
+    return false;
+
+  auto cache_path = ast_path.parent_path();
+  boost::system::error_code ec;
+  if(!boost::filesystem::exists(cache_path, ec)) {
+    boost::filesystem::create_directory(cache_path, ec);
+    if(ec)
+      return false;
+  }
+  else if(!boost::filesystem::is_directory(cache_path, ec))
+    return false;
+
+  auto path_str = path.string();
+  std::vector<const char *> cx_arguments;
+  cx_arguments.reserve(arguments.size());
+  for(auto &argument : arguments)
+    cx_arguments.emplace_back(argument.c_str());
+  CXUnsavedFile cx_unsaved_file{path_str.c_str(), buffer.c_str(), static_cast<unsigned long>(buffer.size())};
+  auto cx_index = clang_createIndex(0, 0);
+  CXTranslationUnit cx_tu;
+  if(clang_parseTranslationUnit2(cx_index, path_str.c_str(), cx_arguments.data(), static_cast<int>(cx_arguments.size()), &cx_unsaved_file, 1,
+                                 flags & ~(CXTranslationUnit_PrecompiledPreamble | CXTranslationUnit_CacheCompletionResults), &cx_tu) != CXError_Success) {
+    clang_disposeIndex(cx_index);
+    return false;
+  }
+  ScopeGuard guard{[cx_index, cx_tu] {
+    clang_disposeTranslationUnit(cx_tu);
+    clang_disposeIndex(cx_index);
+  }};
+
+  JSON includes(JSON::StructureType::array);
+  clang_getInclusions(
+      cx_tu, [](CXFile included_file, CXSourceLocation *inclusion_stack, unsigned include_len, CXClientData client_data) {
+        if(include_len == 0) // The main file is validated by the key
+          return;
+        auto includes = static_cast<JSON *>(client_data);
+        auto cx_file_name = clang_getFileName(included_file);
+        JSON include;
+        include.set("path", clang_getCString(cx_file_name));
+        include.set("time", static_cast<long long>(clang_getFileTime(included_file)));
+        clang_disposeString(cx_file_name);
+        includes->emplace_back(std::move(include));
+      },
+      &includes);
+
+  auto tmp_ast_path = ast_path;
+  tmp_ast_path += ".tmp";
+  if(clang_saveTranslationUnit(cx_tu, tmp_ast_path.string().c_str(), clang_defaultSaveOptions(cx_tu)) != CXSaveError_None) {
+    boost::filesystem::remove(tmp_ast_path, ec);
+    return false;
+  }
+
+  // Remove the previous info first, so that a translation unit is never loaded with the wrong info
+  boost::filesystem::remove(info_path, ec);
+  boost::filesystem::rename(tmp_ast_path, ast_path, ec);
+  if(ec) {
+    boost::filesystem::remove(tmp_ast_path, ec);
+    return false;
+  }
+
+  JSON info;
+  info.set("key", key);
+  info.set("includes", std::move(includes));
+  try {
+    info.to_file(info_path);
+  }
+  catch(...) {
+    return false;
+  }
+
+  erase_least_recently_used();
+  return true;
+}
+
+void TranslationUnitCache::erase_least_recently_used() const {
+  struct SavedTranslationUnit {
+    std::time_t last_write_time;
+    boost::uintmax_t size;
+    boost::filesystem::path ast_path;
+  };
+  std::vector<SavedTranslationUnit> saved_translation_units;
+  boost::uintmax_t cache_size = 0;
+  boost::system::error_code ec;
+  for(boost::filesystem::directory_iterator it(ast_path.parent_path(), ec), end; it != end; it.increment(ec)) {
+    auto file_path = it->path();
+    if(file_path.extension() != ".ast")
+      continue;
+    auto size = boost::filesystem::file_size(file_path, ec);
+    if(ec)
+      continue;
+    auto last_write_time = boost::filesystem::last_write_time(file_path, ec);
+    if(ec)
+      continue;
+    cache_size += size;
+    saved_translation_units.push_back({last_write_time, size, std::move(file_path)});
+  }
+  if(cache_size <= max_cache_size)
+    return;
+
+  std::sort(saved_translation_units.begin(), saved_translation_units.end(), [](const SavedTranslationUnit &a, const SavedTranslationUnit &b) {
+    return a.last_write_time > b.last_write_time;
+  });
+  // The most recently used translation unit is kept even if it alone exceeds max_cache_size
+  while(cache_size > max_cache_size && saved_translation_units.size() > 1) {
+    auto &saved_translation_unit = saved_translation_units.back();
+    // Remove the info first, so that a translation unit is never loaded with the wrong info
+    boost::filesystem::remove(boost::filesystem::path(saved_translation_unit.ast_path).replace_extension(".json"), ec);
+    boost::filesystem::remove(saved_translation_unit.ast_path, ec);
+    cache_size -= saved_translation_unit.size;
+    saved_translation_units.pop_back();
+  }
+}
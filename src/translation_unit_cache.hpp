@@ -0,0 +1,42 @@
+#pragma once
+#include <boost/filesystem.hpp>
+#include <clang-c/Index.h>
+#include <string>
+#include <vector>
+
+/// Saves parsed translation units under the build directory, so that a reopened C/C++ file can be
+/// highlighted from its saved translation unit while the file is parsed again.
+/// A saved translation unit is only used if the compile arguments, parse flags and buffer are unchanged,
+/// and none of the included files have been modified since it was saved.
+class TranslationUnitCache {
+public:
+  static const boost::filesystem::path cache_folder;
+  /// The least recently used translation units are removed when the saved translation units of a build directory exceed this size
+  static const boost::uintmax_t max_cache_size;
+
+  TranslationUnitCache(const boost::filesystem::path &project_path, const boost::filesystem::path &build_path, const boost::filesystem::path &path,
+                       const std::vector<std::string> &arguments, int flags, const std::string &buffer);
+
+  /// Returns nullptr if no valid translation unit is saved.
+  /// The returned translation unit must be disposed with clang_disposeTranslationUnit.
+  CXTranslationUnit load(CXIndex cx_index) const;
+  /// Returns true if buffer is the same as the one given in the constructor.
+  bool can_save(const std::string &buffer) const;
+  /// Parses and saves a translation unit if buffer is the same as the one given in the constructor.
+  /// The translation unit is parsed separately, so that the translation unit of the view can be used while saving.
+  /// Returns true if the translation unit was saved.
+  bool save(const std::string &buffer) const;
+
+private:
+  boost::filesystem::path path;
+  std::vector<std::string> arguments;
+  int flags = 0;
+  boost::filesystem::path ast_path;
+  boost::filesystem::path info_path;
+  size_t arguments_hash = 0;
+  std::string key;
+
+  std::string get_key(const std::string &buffer) const;
+  /// Removes the least recently used translation units until the cache folder is below max_cache_size
+  void erase_least_recently_used() const;
+};
@@ -3,6 +3,8 @@
 #include "config.hpp"
 #include "dialog.hpp"
 #include "filesystem.hpp"
+#include "json.hpp"
+#include "trace.hpp"
 #include "utility.hpp"
 #include <chrono>
 #include <fstream>
@@ -124,6 +126,10 @@ boost::optional<std::vector<Usages::Clang::Usages>> Usages::Clang::get_usages(co
   if(spelling.empty())
     return {};
 
+  Trace::Span span("Usages::Clang::get_usages");
+  if(Trace::is_recording())
+    span.set_args("\"spelling\":\"" + JSON::escape_string(spelling) + '"');
+
   PathSet visited;
 
   auto usr_extended = cursor.get_usr_extended();
@@ -15,12 +15,16 @@
 #include "menu.hpp"
 #include "notebook.hpp"
 #include "project.hpp"
+#include "project_files.hpp"
 #include "selection_dialog.hpp"
+#include "startup_profile.hpp"
 #include "terminal.hpp"
+#include "trace.hpp"
 #include <boost/algorithm/string.hpp>
 
 Window::Window() {
   Gsv::init();
+  StartupProfile::phase("initialize sourceview");
 
   set_title("juCi++");
   get_style_context()->add_class("juci_window");
@@ -169,12 +173,15 @@ Window::Window() {
   about.set_comments("This is an open source IDE with high-end features to make your programming experience juicy");
   about.set_license_type(Gtk::License::LICENSE_MIT_X11);
   about.set_transient_for(*this);
+  StartupProfile::phase("create window");
 } // Window constructor
 
 void Window::configure() {
   Config::get().load();
+  StartupProfile::phase("load config");
   Snippets::get().load();
   Commands::get().load();
+  StartupProfile::phase("load snippets and commands");
   auto screen = get_screen();
 
   static Glib::RefPtr<Gtk::CssProvider> css_provider_theme;
@@ -272,6 +279,7 @@ void Window::configure() {
                                         ".juci_tooltip_text_view *:not(:selected) {color: " + foreground_value + ";background-color: " + background_value + ";}");
 #endif
   get_style_context()->add_provider_for_screen(screen, css_provider_tooltips, GTK_STYLE_PROVIDER_PRIORITY_APPLICATION);
+  StartupProfile::phase("load theme and style");
 
   Menu::get().set_keys();
   Terminal::get().configure();
@@ -568,6 +576,7 @@ void Window::set_menu_actions() {
           return;
       }
     }
+    Notebook::get().close_placeholders(project_path);
     Directories::get().close(project_path);
   });
   menu.add_action("file_close_other_files", []() {
@@ -580,6 +589,7 @@ void Window::set_menu_actions() {
           return;
       }
     }
+    Notebook::get().close_placeholders();
   });
 
   menu.add_action("file_print", [this]() {
@@ -978,37 +988,38 @@ void Window::set_menu_actions() {
     for(auto view : Notebook::get().get_views())
       open_files.emplace(view->file_path.string());
 
-    std::vector<boost::filesystem::path> files;
-    // populate with all files in search_path
-    boost::system::error_code ec;
-    for(boost::filesystem::recursive_directory_iterator it(view_folder, ec), end; it != end; it++) {
-      auto path = it->path();
-      // ignore folders
-      if(!boost::filesystem::is_regular_file(path, ec)) {
-        auto filename = path.filename();
-        if(std::any_of(exclude_folders.begin(), exclude_folders.end(), [&filename](const std::string &exclude_folder) {
-             return filename == exclude_folder;
-           }))
-          it.no_push();
-        continue;
-      }
-
-      auto row = filesystem::get_relative_path(path, view_folder).string();
-      SelectionDialog::get()->add_row(open_files.count(path.string()) ? "<b>" + row + "</b>" : row);
-      files.emplace_back(path);
-    }
+    auto get_row = [view_folder, open_files = std::move(open_files)](const std::string &file) -> std::string {
+      return open_files.count((view_folder / file).string()) ? "<b>" + Glib::Markup::escape_text(file) + "</b>" : Glib::Markup::escape_text(file);
+    };
 
-    if(files.empty()) {
+    // Show the files found so far, and update the rows when the project has been crawled
+    auto project_files = ProjectFiles::get(view_folder, exclude_folders);
+    auto files = std::make_shared<std::vector<std::string>>(project_files->get_files());
+    if(files->empty() && project_files->is_ready()) {
       Info::get().print("No files found in current project");
       return;
     }
+    for(auto &file : *files)
+      SelectionDialog::get()->add_row(get_row(file));
 
-    SelectionDialog::get()->on_select = [files = std::move(files)](unsigned int index, const std::string &text, bool hide_window) {
-      if(Notebook::get().open(files[index])) {
+    SelectionDialog::get()->on_select = [view_folder, files](unsigned int index, const std::string &text, bool hide_window) {
+      if(Notebook::get().open(view_folder / (*files)[index])) {
         auto view = Notebook::get().get_current_view();
         view->hide_tooltips();
       }
     };
+    // files is owned by the dialog, and is released when the dialog is replaced
+    project_files->on_changed = [project_files = project_files.get(), files = std::weak_ptr<std::vector<std::string>>(files), get_row = std::move(get_row)] {
+      auto dialog_files = files.lock();
+      if(!dialog_files || !SelectionDialog::get() || !SelectionDialog::get()->is_visible())
+        return;
+      *dialog_files = project_files->get_files();
+      std::vector<std::string> rows;
+      rows.reserve(dialog_files->size());
+      for(auto &file : *dialog_files)
+        rows.emplace_back(get_row(file));
+      SelectionDialog::get()->replace_rows(rows);
+    };
 
     if(view)
       view->hide_tooltips();
@@ -1793,6 +1804,29 @@ void Window::set_menu_actions() {
   menu.add_action("window_clear_terminal", [] {
     Terminal::get().clear();
   });
+  menu.add_action("window_toggle_trace_recording", [] {
+#ifdef JUCI_ENABLE_TRACE
+    if(!Trace::is_recording()) {
+      Trace::start();
+      Info::get().print("Trace recording started");
+      return;
+    }
+    Trace::stop();
+    boost::system::error_code ec;
+    auto path = boost::filesystem::temp_directory_path(ec);
+    if(ec) {
+      Terminal::get().print("\e[31mError\e[m: could not find temporary directory: " + ec.message() + "\n", true);
+      return;
+    }
+    path /= boost::filesystem::unique_path("juci-trace-%%%%-%%%%.json");
+    if(Trace::write(path))
+      Terminal::get().print("Trace written to " + path.string() + ", which can be opened in https://ui.perfetto.dev\n");
+    else
+      Terminal::get().print("\e[31mError\e[m: could not write trace to " + path.string() + "\n", true);
+#else
+    Terminal::get().print("\e[31mError\e[m: juCi++ was built without trace support (cmake -DENABLE_TRACE=ON)\n", true);
+#endif
+  });
 
   menu.toggle_menu_items = [] {
     auto &menu = Menu::get();
@@ -2074,6 +2108,7 @@ bool Window::on_delete_event(GdkEventAny *event) {
     if(!Notebook::get().close(c))
       return true;
   }
+  Notebook::get().close_placeholders();
   Terminal::get().kill_async_processes();
 
   if(Source::View::prettier_background_process) {
@@ -2342,13 +2377,12 @@ void Window::save_session() {
     last_session.set("folder", Directories::get().path.string());
 
     auto files = JSON(JSON::StructureType::array);
-    for(auto &notebook_view : Notebook::get().get_notebook_views()) {
+    for(auto &tab_location : Notebook::get().get_tab_locations()) {
       auto file = JSON();
-      file.set("path", notebook_view.second->file_path.string());
-      file.set("notebook", notebook_view.first);
-      auto iter = notebook_view.second->get_buffer()->get_insert()->get_iter();
-      file.set("line", iter.get_line());
-      file.set("line_offset", iter.get_line_offset());
+      file.set("path", tab_location.file_path.string());
+      file.set("notebook", tab_location.notebook_index);
+      file.set("line", tab_location.line);
+      file.set("line_offset", tab_location.line_offset);
       files.emplace_back(std::move(file));
     }
     last_session.set("files", std::move(files));
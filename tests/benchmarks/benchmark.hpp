@@ -0,0 +1,96 @@
+#pragma once
+#include "json.hpp"
+#include <algorithm>
+#include <chrono>
+#include <ctime>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+/// Small benchmark harness. The number of iterations per sample is doubled until a sample takes at least 5 milliseconds,
+/// and then each benchmark is timed over a fixed number of samples. Median and minimum time per iteration are reported.
+class Benchmark {
+  using Clock = std::chrono::steady_clock;
+
+  class Result {
+  public:
+    std::string name;
+    size_t iterations;
+    double median_nanoseconds;
+    double min_nanoseconds;
+    size_t bytes;
+  };
+
+  std::string filter;
+  std::vector<Result> results;
+
+public:
+  static const size_t samples = 10;
+
+  /// Only benchmarks with names containing filter are run
+  Benchmark(std::string filter = {}) : filter(std::move(filter)) {}
+
+  /// Prevents the compiler from optimizing away the computation of value
+  template <class T>
+  static void do_not_optimize(const T &value) {
+    asm volatile(""
+                 :
+                 : "g"(&value)
+                 : "memory");
+  }
+
+  /// Set bytes to the size of the input processed by each call to function to also report throughput
+  void run(const std::string &name, const std::function<void()> &function, size_t bytes = 0) {
+    if(!filter.empty() && name.find(filter) == std::string::npos)
+      return;
+
+    auto time = [&function](size_t iterations) {
+      auto start = Clock::now();
+      for(size_t i = 0; i < iterations; ++i)
+        function();
+      return Clock::now() - start;
+    };
+
+    size_t iterations = 1;
+    while(time(iterations) < std::chrono::milliseconds(5))
+      iterations *= 2;
+
+    std::vector<double> nanoseconds;
+    nanoseconds.reserve(samples);
+    for(size_t sample = 0; sample < samples; ++sample)
+      nanoseconds.emplace_back(std::chrono::duration<double, std::nano>(time(iterations)).count() / iterations);
+    std::sort(nanoseconds.begin(), nanoseconds.end());
+
+    results.emplace_back(Result{name, iterations, nanoseconds[samples / 2], nanoseconds.front(), bytes});
+
+    auto &result = results.back();
+    std::cerr << std::left << std::setw(48) << name << std::right << std::setw(14) << std::fixed << std::setprecision(0) << result.median_nanoseconds << " ns";
+    if(bytes > 0)
+      std::cerr << std::setw(12) << std::setprecision(1) << bytes / result.median_nanoseconds * 1000.0 << " MB/s";
+    std::cerr << std::endl;
+  }
+
+  JSON to_json() const {
+    JSON json;
+    char date[32];
+    auto time = std::time(nullptr);
+    std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&time));
+    json.set("date", date);
+    JSON benchmarks(JSON::StructureType::array);
+    for(auto &result : results) {
+      JSON benchmark;
+      benchmark.set("name", result.name);
+      benchmark.set("iterations", result.iterations);
+      benchmark.set("samples", samples);
+      benchmark.set("median_ns", result.median_nanoseconds);
+      benchmark.set("min_ns", result.min_nanoseconds);
+      if(result.bytes > 0)
+        benchmark.set("bytes_per_second", result.bytes / result.median_nanoseconds * 1.0e9);
+      benchmarks.emplace_back(std::move(benchmark));
+    }
+    json.set("benchmarks", std::move(benchmarks));
+    return json;
+  }
+};
@@ -0,0 +1,258 @@
+#include "benchmark.hpp"
+#include "clangmm.hpp"
+#include "cmake.hpp"
+#include "compile_commands.hpp"
+#include "ctags.hpp"
+#include "git.hpp"
+#include "grep.hpp"
+#include "source.hpp"
+#include "terminal.hpp"
+#include "usages_clang.hpp"
+#include "utility.hpp"
+#include <boost/archive/text_iarchive.hpp>
+#include <boost/archive/text_oarchive.hpp>
+#include <fstream>
+#include <sstream>
+
+//Requires display server to work
+//However, it is possible to use the Broadway backend if the benchmarks are run in a pure terminal environment:
+//broadwayd&
+//./juci_bench
+
+/// Returns a C++ source of the given number of lines with some variation between the lines
+std::string get_source(size_t lines, size_t variant = 0) {
+  std::string source;
+  for(size_t c = 0; c < lines; ++c) {
+    if(c % 10 == 0)
+      source += "// Comment æøå " + std::to_string(c) + '\n';
+    else if((c + variant) % 17 == 0)
+      source += "  auto value" + std::to_string(c) + " = changed(" + std::to_string(variant) + ");\n";
+    else
+      source += "  auto value" + std::to_string(c) + " = function(value, \"string\");\n";
+  }
+  return source;
+}
+
+void benchmark_git(Benchmark &benchmark) {
+  auto old_buffer = get_source(5000);
+  auto new_buffer = get_source(5000, 1);
+  benchmark.run("Git::Repository::Diff::get_hunks", [&] {
+    auto hunks = Git::Repository::Diff::get_hunks(old_buffer, new_buffer);
+    Benchmark::do_not_optimize(hunks);
+  },
+                old_buffer.size() + new_buffer.size());
+}
+
+void benchmark_replace_text(Benchmark &benchmark, const boost::filesystem::path &tmp_path) {
+  Source::View view(tmp_path / "benchmark.cpp", Glib::RefPtr<Gsv::Language>());
+  std::string texts[] = {get_source(2000), get_source(2000, 1)};
+  view.get_buffer()->set_text(texts[0]);
+  size_t c = 0;
+  benchmark.run("BaseView::replace_text", [&] {
+    view.replace_text(texts[++c % 2]);
+  },
+                texts[0].size());
+}
+
+void benchmark_grep(Benchmark &benchmark) {
+  Grep grep({}, {}, false, false);
+  std::string line("\x1b[35m\x1b[Ksrc/source_base.cpp\x1b[m\x1b[K\x1b[36m\x1b[K:\x1b[m\x1b[K\x1b[32m\x1b[K1234\x1b[m\x1b[K\x1b[36m\x1b[K:\x1b[m\x1b[K"
+                   "  auto \x1b[01;31m\x1b[Kiter\x1b[m\x1b[K = get_buffer()->get_iter_at_line(line); // Find \x1b[01;31m\x1b[Kiter\x1b[m\x1b[K & <line>");
+  benchmark.run("Grep::get_location", [&] {
+    auto location = grep.get_location(line, true, true);
+    Benchmark::do_not_optimize(location);
+  },
+                line.size());
+}
+
+void benchmark_ctags(Benchmark &benchmark) {
+  Ctags ctags({}, true, true);
+  std::string line("get_location\tsrc/ctags.cpp\t/^Ctags::Location Ctags::get_location(const std::string &line_, bool add_markup, bool symbol_ends_with_open_parenthesis) const {$/;\"\tf\tline:91\tclass:Ctags");
+  benchmark.run("Ctags::get_location", [&] {
+    auto location = ctags.get_location(line, true, true);
+    Benchmark::do_not_optimize(location);
+  },
+                line.size());
+}
+
+void benchmark_terminal(Benchmark &benchmark) {
+  std::vector<std::string> lines = {
+      "/home/user/project/src/main.cpp:7:41: error: expected ';' after expression.",
+      "In file included from ./test/test.cc:2,",
+      "  --> src/main.rs:16:4",
+      "[100%] Built target juci with a line that does not contain a link to any file in the project"};
+  size_t bytes = 0;
+  for(auto &line : lines)
+    bytes += line.size();
+  benchmark.run("Terminal::find_link", [&] {
+    for(auto &line : lines) {
+      auto link = Terminal::find_link(line);
+      Benchmark::do_not_optimize(link);
+    }
+  },
+                bytes);
+}
+
+void benchmark_json(Benchmark &benchmark) {
+  // Payloads with the same structure as completion and diagnostics messages received from language servers
+  std::string completion(R"({"jsonrpc":"2.0","id":42,"result":{"isIncomplete":false,"items":[)");
+  for(size_t c = 0; c < 2000; ++c) {
+    if(c > 0)
+      completion += ',';
+    auto label = "get_value_" + std::to_string(c);
+    completion += R"({"label":")" + label + R"(","kind":3,"detail":"fn(&self, index: usize) -> Option<&T>","documentation":{"kind":"markdown","value":"Returns a reference to an element.\n\n```rust\nlet v = [1, 2];\n```"},"sortText":"ffff)" + std::to_string(c) +
+                  R"(","filterText":")" + label + R"(","textEdit":{"range":{"start":{"line":10,"character":4},"end":{"line":10,"character":8}},"newText":")" + label + R"((${1:index})"},"insertTextFormat":2})";
+  }
+  completion += "]}}";
+
+  std::string diagnostics(R"({"jsonrpc":"2.0","method":"textDocument/publishDiagnostics","params":{"uri":"file:///home/user/project/src/main.rs","diagnostics":[)");
+  for(size_t c = 0; c < 500; ++c) {
+    if(c > 0)
+      diagnostics += ',';
+    diagnostics += R"({"range":{"start":{"line":)" + std::to_string(c) + R"(,"character":4},"end":{"line":)" + std::to_string(c) +
+                   R"(,"character":12}},"severity":2,"code":"unused_variables","source":"rustc","message":"unused variable: `value`\nif this is intentional, prefix it with an underscore: `_value`","relatedInformation":[{"location":{"uri":"file:///home/user/project/src/main.rs","range":{"start":{"line":1,"character":0},"end":{"line":1,"character":4}}},"message":"original diagnostic"}]})";
+  }
+  diagnostics += "]}}";
+
+  benchmark.run("JSON completion response", [&] {
+    JSON json(completion);
+    size_t size = 0;
+    for(auto &item : json.object("result").array("items"))
+      size += item.string("label").size() + item.string_or("detail", "").size();
+    Benchmark::do_not_optimize(size);
+  },
+                completion.size());
+  benchmark.run("JSON publishDiagnostics notification", [&] {
+    JSON json(diagnostics);
+    size_t size = 0;
+    for(auto &diagnostic : json.object("params").array("diagnostics"))
+      size += diagnostic.string("message").size() + diagnostic.object("range").object("start").integer("line");
+    Benchmark::do_not_optimize(size);
+  },
+                diagnostics.size());
+}
+
+void benchmark_usages_clang(Benchmark &benchmark, const boost::filesystem::path &tests_path) {
+  auto project_path = boost::filesystem::canonical(tests_path / "usages_clang_test_files");
+  auto build_path = project_path / "build";
+  auto path = project_path / "main.cpp";
+  std::ifstream stream(path.string(), std::ifstream::binary);
+  std::string buffer;
+  buffer.assign(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>());
+
+  auto index = std::make_shared<clangmm::Index>(1, 0);
+  clangmm::TranslationUnit translation_unit(index, path.string(), CompileCommands::get_arguments(build_path, path), &buffer);
+  auto tokens = translation_unit.get_tokens();
+  auto before_parse_time = std::time(nullptr);
+
+  benchmark.run("Usages::Clang::Cache", [&] {
+    Usages::Clang::Cache cache(project_path, build_path, path, before_parse_time, &translation_unit, tokens.get());
+    Benchmark::do_not_optimize(cache);
+  });
+
+  Usages::Clang::Cache cache(project_path, build_path, path, before_parse_time, &translation_unit, tokens.get());
+  auto serialize = [&cache] {
+    std::stringstream stream;
+    {
+      boost::archive::text_oarchive text_oarchive(stream);
+      text_oarchive << cache;
+    }
+    return stream.str();
+  };
+  auto serialized = serialize();
+  benchmark.run("Usages::Clang::Cache serialize", [&] {
+    auto serialized = serialize();
+    Benchmark::do_not_optimize(serialized);
+  },
+                serialized.size());
+  benchmark.run("Usages::Clang::Cache deserialize", [&] {
+    std::stringstream stream(serialized);
+    boost::archive::text_iarchive text_iarchive(stream);
+    Usages::Clang::Cache cache;
+    text_iarchive >> cache;
+    Benchmark::do_not_optimize(cache);
+  },
+                serialized.size());
+}
+
+void benchmark_cmake(Benchmark &benchmark) {
+  std::string src;
+  for(size_t c = 0; c < 200; ++c) {
+    auto target = "target" + std::to_string(c);
+    src += "# Target " + std::to_string(c) + '\n';
+    src += "set(" + target + "_FILES\n  src/" + target + ".cpp\n  src/" + target + "_utility.cpp\n)\n";
+    src += "add_executable(" + target + " ${" + target + "_FILES})\n";
+    src += "target_link_libraries(" + target + " ${Boost_LIBRARIES} \"quoted argument\")\n";
+  }
+  benchmark.run("CMake::parse_file", [&] {
+    std::map<std::string, std::list<std::string>> variables;
+    size_t count = 0;
+    CMake::parse_file(src, variables, [&count](CMake::Function &&function) {
+      count += function.parameters.size();
+    });
+    Benchmark::do_not_optimize(count);
+  },
+                src.size());
+}
+
+void benchmark_utility(Benchmark &benchmark) {
+  auto text = get_source(2000);
+  benchmark.run("utf8_character_count", [&] {
+    auto count = utf8_character_count(text);
+    Benchmark::do_not_optimize(count);
+  },
+                text.size());
+  auto code_units = utf16_code_unit_count(text);
+  benchmark.run("utf16_code_unit_count", [&] {
+    auto count = utf16_code_unit_count(text);
+    Benchmark::do_not_optimize(count);
+  },
+                text.size());
+  benchmark.run("utf16_code_units_byte_count", [&] {
+    auto count = utf16_code_units_byte_count(text, code_units);
+    Benchmark::do_not_optimize(count);
+  },
+                text.size());
+}
+
+/// Usage: juci_bench [--filter=<part of benchmark name>] [--output=<path to JSON results>]
+/// Results are written to standard output if no output path is given.
+int main(int argc, char *argv[]) {
+  std::string filter;
+  boost::filesystem::path output_path;
+  for(int c = 1; c < argc; ++c) {
+    std::string argument(argv[c]);
+    if(starts_with(argument, "--filter="))
+      filter = argument.substr(9);
+    else if(starts_with(argument, "--output="))
+      output_path = argument.substr(9);
+    else {
+      std::cerr << "Usage: " << argv[0] << " [--filter=<part of benchmark name>] [--output=<path to JSON results>]" << std::endl;
+      return 1;
+    }
+  }
+
+  auto app = Gtk::Application::create();
+  Gsv::init();
+
+  auto tests_path = boost::filesystem::canonical(JUCI_TESTS_PATH);
+  auto tmp_path = tests_path / "tmp";
+  boost::filesystem::create_directories(tmp_path);
+
+  Benchmark benchmark(filter);
+  benchmark_git(benchmark);
+  benchmark_replace_text(benchmark, tmp_path);
+  benchmark_grep(benchmark);
+  benchmark_ctags(benchmark);
+  benchmark_terminal(benchmark);
+  benchmark_json(benchmark);
+  benchmark_usages_clang(benchmark, tests_path);
+  benchmark_cmake(benchmark);
+  benchmark_utility(benchmark);
+
+  auto json = benchmark.to_json();
+  if(output_path.empty())
+    std::cout << json.to_string(2) << std::endl;
+  else
+    json.to_file(output_path, 2);
+}
@@ -2,8 +2,11 @@
 #include "config.hpp"
 #include "process.hpp"
 #include "project_build.hpp"
+#include <algorithm>
 #include <boost/filesystem.hpp>
+#include <fstream>
 #include <glib.h>
+#include <thread>
 
 int main() {
   {
@@ -374,11 +377,14 @@ int main() {
 
     {
       CMake cmake(project_path);
+      CMake::write_file_api_query(project_path / "build");
       TinyProcessLib::Process process("cmake -DCMAKE_EXPORT_COMPILE_COMMANDS=ON ..", (project_path / "build").string(), [](const char *bytes, size_t n) {});
       g_assert(process.get_exit_status() == 0);
 
       g_assert(cmake.get_executable(project_path / "build", project_path) == "");
       g_assert(cmake.get_executable(project_path / "build" / "non_existing_file.cpp", project_path) == "");
+      // Executables added in other cmake files are used if none of this project's cmake files match
+      g_assert(cmake.get_executable(project_path / "build", project_path / "src" / "juci.cpp") == project_path / "build" / "src" / "juci");
     }
     {
       CMake cmake(project_path / "src");
@@ -396,6 +402,17 @@ int main() {
       g_assert(cmake.get_executable(project_path / "build", tests_path / "cmake_build_test.cpp") == project_path / "build" / "tests" / "cmake_build_test");
       g_assert(cmake.get_executable(project_path / "build", tests_path / "non_existing_file.cpp").parent_path() == project_path / "build" / "tests");
     }
+    {
+      auto code_model = CMake::get_code_model(project_path / "build");
+      g_assert(code_model);
+      g_assert(CMake::get_code_model(project_path / "build") == code_model);
+      auto it = std::find_if(code_model->executables.begin(), code_model->executables.end(), [&project_path](const CMake::CodeModel::Executable &executable) {
+        return executable.path == project_path / "build" / "tests" / "cmake_build_test";
+      });
+      g_assert(it != code_model->executables.end());
+      g_assert(it->cmake_directory == project_path / "tests");
+      g_assert(std::find(it->sources.begin(), it->sources.end(), project_path / "tests" / "cmake_build_test.cpp") != it->sources.end());
+    }
 
     auto build = Project::Build::create(tests_path);
     g_assert(dynamic_cast<Project::CMakeBuild *>(build.get()));
@@ -427,4 +444,50 @@ int main() {
     g_assert(cmake.get_executable(project_path / "build", project_path / "non_existing_file.cpp") == boost::filesystem::path(".") / "test");
     g_assert(cmake.get_executable(project_path / "build", project_path) == boost::filesystem::path(".") / "test");
   }
+  {
+    auto tests_path = boost::filesystem::canonical(JUCI_TESTS_PATH);
+    auto path = tests_path / "tmp" / "project_build_cache_test";
+    boost::filesystem::create_directories(path);
+
+    auto build = Project::Build::create(path);
+    g_assert(dynamic_cast<Project::CMakeBuild *>(build.get()));
+    g_assert(build->project_path == tests_path.parent_path());
+
+    build = Project::Build::create(path / "main.rs");
+    g_assert(dynamic_cast<Project::CMakeBuild *>(build.get()));
+    g_assert(build->project_path == tests_path.parent_path());
+
+    std::ofstream(path.string() + "/Cargo.toml") << "[package]\n";
+    Project::Build::clear_cache();
+    build = Project::Build::create(path);
+    g_assert(dynamic_cast<Project::CargoBuild *>(build.get()));
+    g_assert(build->project_path == path);
+
+    boost::filesystem::remove_all(path);
+    Project::Build::clear_cache();
+  }
+  {
+    // Adding a build file is detected without clear_cache(), when the cached build is validated after one second
+    auto tests_path = boost::filesystem::canonical(JUCI_TESTS_PATH);
+    auto path = tests_path / "tmp" / "project_build_invalidation_test";
+    boost::filesystem::create_directories(path);
+    // Last write times within a second of resolving are never trusted, so the new directories are made older
+    boost::filesystem::last_write_time(path, std::time(nullptr) - 10);
+    boost::filesystem::last_write_time(path.parent_path(), std::time(nullptr) - 10);
+
+    auto build = Project::Build::create(path);
+    g_assert(dynamic_cast<Project::CMakeBuild *>(build.get()));
+
+    std::ofstream(path.string() + "/Cargo.toml") << "[package]\n";
+    build = Project::Build::create(path);
+    g_assert(dynamic_cast<Project::CMakeBuild *>(build.get()));
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(1100));
+    build = Project::Build::create(path);
+    g_assert(dynamic_cast<Project::CargoBuild *>(build.get()));
+    g_assert(build->project_path == path);
+
+    boost::filesystem::remove_all(path);
+    Project::Build::clear_cache();
+  }
 }
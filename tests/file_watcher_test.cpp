@@ -0,0 +1,71 @@
+#include "file_watcher.hpp"
+#include "filesystem.hpp"
+#include <chrono>
+#include <glib.h>
+#include <thread>
+
+int main() {
+  Gio::init();
+
+  auto tests_path = boost::filesystem::canonical(JUCI_TESTS_PATH);
+  auto path = tests_path / "tmp" / "file_watcher_test";
+  boost::filesystem::remove_all(path);
+  boost::filesystem::create_directories(path);
+
+  auto run_main_loop = [](const std::function<bool()> &done) {
+    auto start = std::chrono::steady_clock::now();
+    while(!done() && std::chrono::steady_clock::now() - start < std::chrono::seconds(5)) {
+      while(Glib::MainContext::get_default()->iteration(false)) {
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+  };
+
+  std::vector<std::vector<boost::filesystem::path>> directory_changes;
+  auto directory_subscription = FileWatcher::get().subscribe(
+      path, true, [&directory_changes](std::vector<boost::filesystem::path> &&paths) {
+        directory_changes.emplace_back(std::move(paths));
+      },
+      100);
+  std::vector<std::vector<boost::filesystem::path>> file_changes;
+  auto file_subscription = FileWatcher::get().subscribe(
+      path / "a.txt", false, [&file_changes](std::vector<boost::filesystem::path> &&paths) {
+        file_changes.emplace_back(std::move(paths));
+      },
+      100);
+
+  // Both subscriptions share the monitor of the directory
+  g_assert(directory_subscription->directory == file_subscription->directory);
+  g_assert(FileWatcher::get().directories.size() == 1);
+
+  // Changes are coalesced
+  filesystem::write(path / "a.txt", "a");
+  filesystem::write(path / "b.txt", "b");
+  filesystem::write(path / "a.txt", "aa");
+  run_main_loop([&] { return !directory_changes.empty() && !file_changes.empty(); });
+  g_assert(directory_changes.size() == 1);
+  g_assert(directory_changes[0].size() == 2);
+  g_assert(file_changes.size() == 1);
+  g_assert(file_changes[0] == std::vector<boost::filesystem::path>{path / "a.txt"});
+
+  // Changes to other files are not reported to file subscriptions
+  filesystem::write(path / "b.txt", "bb");
+  run_main_loop([&] { return directory_changes.size() == 2; });
+  g_assert(directory_changes.size() == 2);
+  g_assert(file_changes.size() == 1);
+
+  // Ended subscriptions are not called
+  file_subscription = nullptr;
+  filesystem::write(path / "a.txt", "aaa");
+  run_main_loop([&] { return directory_changes.size() == 3; });
+  g_assert(directory_changes.size() == 3);
+  g_assert(file_changes.size() == 1);
+
+  // The directory monitor is removed when the last subscription has ended
+  directory_subscription = nullptr;
+  FileWatcher::get().subscribe(tests_path / "tmp", true, [](std::vector<boost::filesystem::path> &&) {});
+  g_assert(FileWatcher::get().directories.size() == 1);
+  g_assert(FileWatcher::get().directories.count(path.string()) == 0);
+
+  boost::filesystem::remove_all(path);
+}
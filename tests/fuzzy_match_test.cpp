@@ -0,0 +1,70 @@
+#include "fuzzy_match.hpp"
+#include <glib.h>
+
+int main() {
+  {
+    FuzzyMatch::Candidate candidate("<b>a&amp;b</b> &lt;c&gt;", true);
+    g_assert(candidate.text == "a&b <c>");
+    g_assert(candidate.text_lc == "a&b <c>");
+  }
+  {
+    FuzzyMatch::Candidate candidate("Source/Main.CPP");
+    g_assert(candidate.text == "Source/Main.CPP");
+    g_assert(candidate.text_lc == "source/main.cpp");
+  }
+
+  {
+    FuzzyMatch fuzzy_match("");
+    g_assert_cmpint(fuzzy_match.score(FuzzyMatch::Candidate("test")), ==, 0);
+  }
+  {
+    FuzzyMatch fuzzy_match("smc");
+    g_assert_cmpint(fuzzy_match.score(FuzzyMatch::Candidate("source/main.cpp")), >, 0);
+    g_assert_cmpint(fuzzy_match.score(FuzzyMatch::Candidate("SourceMain.cpp")), >, 0);
+    g_assert_cmpint(fuzzy_match.score(FuzzyMatch::Candidate("source/main.hpp")), ==, -1);
+    g_assert_cmpint(fuzzy_match.score(FuzzyMatch::Candidate("csm")), ==, -1);
+    g_assert_cmpint(fuzzy_match.score(FuzzyMatch::Candidate("")), ==, -1);
+  }
+  {
+    FuzzyMatch fuzzy_match("main");
+    // Consecutive and word boundary matches should score higher
+    g_assert_cmpint(fuzzy_match.score(FuzzyMatch::Candidate("src/main.cpp")), >, fuzzy_match.score(FuzzyMatch::Candidate("src/m_a_i_n.cpp")));
+    g_assert_cmpint(fuzzy_match.score(FuzzyMatch::Candidate("src/main.cpp")), >, fuzzy_match.score(FuzzyMatch::Candidate("src/domain.cpp")));
+    g_assert_cmpint(fuzzy_match.score(FuzzyMatch::Candidate("MAIN")), >, 0);
+  }
+
+  {
+    std::vector<FuzzyMatch::Candidate> candidates;
+    candidates.emplace_back("src/domain.cpp");
+    candidates.emplace_back("tests/test.cpp");
+    candidates.emplace_back("src/main.cpp");
+    candidates.emplace_back("src/m_a_i_n.cpp");
+
+    auto indices = FuzzyMatch("").filter(candidates);
+    g_assert(indices == std::vector<size_t>({0, 1, 2, 3}));
+
+    indices = FuzzyMatch("mai").filter(candidates);
+    g_assert(indices == std::vector<size_t>({2, 3, 0}));
+
+    FuzzyMatch fuzzy_match("main");
+    g_assert(fuzzy_match.refines("mai"));
+    g_assert(!fuzzy_match.refines("man"));
+    indices = fuzzy_match.filter(candidates, &indices);
+    g_assert(indices == std::vector<size_t>({2, 3, 0}));
+
+    indices = FuzzyMatch("test").filter(candidates);
+    g_assert(indices == std::vector<size_t>({1}));
+  }
+
+  {
+    std::vector<FuzzyMatch::Candidate> candidates;
+    for(size_t i = 0; i < 100000; ++i)
+      candidates.emplace_back("file" + std::to_string(i) + ".cpp");
+    auto indices = FuzzyMatch("file99999").filter(candidates);
+    g_assert_cmpuint(indices.size(), ==, 1);
+    g_assert_cmpuint(indices[0], ==, 99999);
+    indices = FuzzyMatch("cpp").filter(candidates);
+    g_assert_cmpuint(indices.size(), ==, candidates.size());
+    g_assert_cmpuint(indices[0], ==, 0);
+  }
+}
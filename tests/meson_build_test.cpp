@@ -1,5 +1,6 @@
 #include "meson.hpp"
 #include "project.hpp"
+#include <algorithm>
 #include <glib.h>
 
 int main() {
@@ -33,6 +34,8 @@ int main() {
 
     build = Project::Build::create(meson_test_files_path / "a_subdir");
     g_assert(dynamic_cast<Project::MesonBuild *>(build.get()));
+
+    g_assert(!Meson::get_introspection(meson_test_files_path / "build"));
   }
 
   // Test new meson versions
@@ -66,5 +69,13 @@ int main() {
 
     build = Project::Build::create(meson_test_files_path / "a_subdir");
     g_assert(dynamic_cast<Project::MesonBuild *>(build.get()));
+
+    auto introspection = Meson::get_introspection(meson_test_files_path / "build");
+    g_assert(introspection);
+    g_assert(Meson::get_introspection(meson_test_files_path / "build") == introspection);
+    g_assert(introspection->executables.size() == 3);
+    auto it = introspection->parameters.find(virtual_test_files_path / "a_subdir" / "main.cpp");
+    g_assert(it != introspection->parameters.end());
+    g_assert(std::find(it->second->begin(), it->second->end(), "-std=c++11") != it->second->end());
   }
 }
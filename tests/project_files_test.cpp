@@ -0,0 +1,78 @@
+#include "filesystem.hpp"
+#include "project_files.hpp"
+#include <chrono>
+#include <glib.h>
+#include <gtkmm.h>
+#include <thread>
+
+int main() {
+  auto app = Gtk::Application::create();
+
+  auto tests_path = boost::filesystem::canonical(JUCI_TESTS_PATH);
+  auto project_path = tests_path / "tmp" / "project_files";
+  boost::filesystem::remove_all(project_path);
+  boost::filesystem::create_directories(project_path / "src");
+  boost::filesystem::create_directories(project_path / "src-extra");
+  boost::filesystem::create_directories(project_path / "build");
+  filesystem::write(project_path / "main.cpp");
+  filesystem::write(project_path / "src" / "test.cpp");
+  filesystem::write(project_path / "src" / "test.hpp");
+  filesystem::write(project_path / "src-extra" / "extra.cpp");
+  filesystem::write(project_path / "build" / "main.o");
+
+  auto project_files = ProjectFiles::get(project_path, {"build"});
+  g_assert(ProjectFiles::get(project_path, {"build"}) == project_files);
+
+  bool changed = false;
+  project_files->on_changed = [&changed] {
+    changed = true;
+  };
+  auto wait_for_changed = [&changed] {
+    auto start = std::chrono::steady_clock::now();
+    while(!changed && std::chrono::steady_clock::now() - start < std::chrono::seconds(5)) {
+      while(Gtk::Main::events_pending())
+        Gtk::Main::iteration();
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    g_assert(changed);
+    changed = false;
+  };
+
+  wait_for_changed();
+  g_assert(project_files->is_ready());
+  g_assert(project_files->get_files() == std::vector<std::string>({"main.cpp", "src-extra/extra.cpp", "src/test.cpp", "src/test.hpp"}));
+
+  filesystem::write(project_path / "src" / "new.cpp");
+  project_files->on_file_changed(project_path / "src" / "new.cpp");
+  g_assert(project_files->get_files() == std::vector<std::string>({"main.cpp", "src-extra/extra.cpp", "src/new.cpp", "src/test.cpp", "src/test.hpp"}));
+
+  boost::filesystem::create_directories(project_path / "new" / "sub");
+  filesystem::write(project_path / "new" / "sub" / "a.cpp");
+  project_files->on_file_changed(project_path / "new"); // New directories are crawled in the crawler thread
+  wait_for_changed();
+  g_assert(project_files->get_files() == std::vector<std::string>({"main.cpp", "new/sub/a.cpp", "src-extra/extra.cpp", "src/new.cpp", "src/test.cpp", "src/test.hpp"}));
+
+  boost::filesystem::remove_all(project_path / "src");
+  project_files->on_file_changed(project_path / "src");
+  g_assert(project_files->get_files() == std::vector<std::string>({"main.cpp", "new/sub/a.cpp", "src-extra/extra.cpp"}));
+
+  boost::filesystem::remove(project_path / "main.cpp");
+  project_files->on_file_changed(project_path / "main.cpp");
+  g_assert(project_files->get_files() == std::vector<std::string>({"new/sub/a.cpp", "src-extra/extra.cpp"}));
+
+  // Changes made while a full crawl is running are kept regardless of when the crawler reads the directories
+  project_files->start_crawl();
+  boost::filesystem::remove(project_path / "src-extra" / "extra.cpp");
+  project_files->on_file_changed(project_path / "src-extra" / "extra.cpp");
+  filesystem::write(project_path / "src-extra" / "extra2.cpp");
+  project_files->on_file_changed(project_path / "src-extra" / "extra2.cpp");
+  wait_for_changed();
+  g_assert(project_files->get_files() == std::vector<std::string>({"new/sub/a.cpp", "src-extra/extra2.cpp"}));
+  project_files->on_changed = nullptr;
+
+  boost::filesystem::create_directories(project_path / "build" / "sub");
+  project_files->on_file_changed(project_path / "build" / "sub");
+  g_assert(project_files->get_files() == std::vector<std::string>({"new/sub/a.cpp", "src-extra/extra2.cpp"}));
+
+  boost::filesystem::remove_all(project_path);
+}
@@ -61,6 +61,35 @@ int main() {
   locations = clang_view->get_methods();
   g_assert_cmpuint(locations.size(), >, 0);
 
+  //test similar tokens index
+  {
+    clang_view->place_cursor_at_line_index(0, 6);
+    auto identifier = clang_view->get_identifier();
+    g_assert(identifier);
+    auto usrs = identifier.cursor.get_all_usr_extended();
+    auto offsets = clang_view->clang_tokens->get_similar_token_offsets(identifier.kind, identifier.spelling, usrs);
+    auto token_indices = clang_view->similar_tokens.get_token_indices(identifier.kind, identifier.spelling, usrs);
+    g_assert_cmpuint(token_indices.size(), >, 1);
+    g_assert_cmpuint(token_indices.size(), ==, offsets.size());
+    for(size_t c = 0; c < token_indices.size(); ++c) {
+      auto &token_offsets = clang_view->clang_tokens_offsets[token_indices[c]];
+      g_assert_cmpuint(token_offsets.first.line, ==, offsets[c].first.line);
+      g_assert_cmpuint(token_offsets.first.index, ==, offsets[c].first.index);
+    }
+  }
+
+  //test type tooltip content
+  {
+    clang_view->place_cursor_at_line_index(0, 6);
+    auto identifier = clang_view->get_identifier();
+    auto token_indices = clang_view->similar_tokens.get_token_indices(identifier.kind, identifier.spelling, identifier.cursor.get_all_usr_extended());
+    g_assert(!token_indices.empty());
+    LockGuard lock(clang_view->parse_mutex);
+    auto content = clang_view->get_type_tooltip_content((*clang_view->clang_tokens)[token_indices[0]]);
+    g_assert(content);
+    g_assert(content->type_description.find("TestClass") != std::string::npos);
+  }
+
   //Test rename class (error if not constructor and destructor is renamed as well)
   auto saved_main = clang_view->get_buffer()->get_text();
   clang_view->place_cursor_at_line_index(0, 6);
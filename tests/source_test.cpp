@@ -2,6 +2,8 @@
 #include "filesystem.hpp"
 #include "source.hpp"
 #include <glib.h>
+#include <map>
+#include <random>
 
 std::string hello_world = R"(#include <iostream>  
     
@@ -39,6 +41,139 @@ int main() {
   view.cleanup_whitespace_characters();
   g_assert(view.get_buffer()->get_text() == hello_world_cleaned);
 
+  {
+    auto snapshot = view.get_snapshot();
+    g_assert(*snapshot == hello_world_cleaned);
+    g_assert(view.get_snapshot() == snapshot);
+    view.get_buffer()->insert(view.get_buffer()->end(), "\n");
+    auto new_snapshot = view.get_snapshot();
+    g_assert(new_snapshot != snapshot);
+    g_assert(*snapshot == hello_world_cleaned);
+    g_assert(*new_snapshot == hello_world_cleaned + '\n');
+  }
+
+  // CurlyBrackets tests, compared to scanning the brackets
+  {
+    Source::View::CurlyBrackets curly_brackets;
+    std::map<int, bool> brackets;
+    std::minstd_rand random_engine;
+    auto check = [&curly_brackets, &brackets] {
+      long depth = 0;
+      for(auto &bracket : brackets)
+        depth += bracket.second ? 1 : -1;
+      g_assert(curly_brackets.depth() == depth);
+      for(int offset = 0; offset <= 42; ++offset) {
+        boost::optional<int> close, open;
+        depth = 0;
+        for(auto it = brackets.lower_bound(offset); it != brackets.end() && !close; ++it) {
+          depth += it->second ? 1 : -1;
+          if(depth < 0)
+            close = it->first;
+        }
+        depth = 0;
+        for(auto it = brackets.upper_bound(offset); it != brackets.begin() && !open;) {
+          --it;
+          depth += it->second ? 1 : -1;
+          if(depth > 0)
+            open = it->first;
+        }
+        g_assert(curly_brackets.find_close(offset) == close);
+        g_assert(curly_brackets.find_open(offset) == open);
+      }
+    };
+    for(size_t c = 0; c < 500; ++c) {
+      auto offset = static_cast<int>(random_engine() % 40);
+      auto operation = random_engine() % 3;
+      if(operation == 0 && !brackets.count(offset)) {
+        bool open = random_engine() % 2 == 0;
+        curly_brackets.insert(offset, open);
+        brackets.emplace(offset, open);
+      }
+      else if(operation == 1) {
+        auto end = offset + static_cast<int>(random_engine() % 5);
+        curly_brackets.erase(offset, end);
+        brackets.erase(brackets.lower_bound(offset), brackets.lower_bound(end));
+        curly_brackets.shift(offset, offset - end);
+        std::map<int, bool> shifted_brackets;
+        for(auto &bracket : brackets)
+          shifted_brackets.emplace(bracket.first >= end ? bracket.first - (end - offset) : bracket.first, bracket.second);
+        brackets = std::move(shifted_brackets);
+      }
+      else if(operation == 2 && (brackets.empty() || brackets.rbegin()->first < 38)) {
+        curly_brackets.shift(offset, 2);
+        std::map<int, bool> shifted_brackets;
+        for(auto &bracket : brackets)
+          shifted_brackets.emplace(bracket.first >= offset ? bracket.first + 2 : bracket.first, bracket.second);
+        brackets = std::move(shifted_brackets);
+      }
+      check();
+    }
+  }
+
+  // Curly brackets are kept up to date on buffer changes
+  {
+    auto buffer = view.get_buffer();
+    buffer->set_text("{\n  {\n  }\n}\n");
+    Gtk::TextIter found_iter;
+    g_assert(view.find_close_symbol_forward(buffer->get_iter_at_offset(1), found_iter, '{', '}'));
+    g_assert(found_iter.get_offset() == 10);
+    g_assert(view.find_open_symbol_backward(buffer->get_iter_at_offset(9), found_iter, '{', '}'));
+    g_assert(found_iter.get_offset() == 0);
+
+    buffer->insert(buffer->get_iter_at_offset(1), "}");
+    g_assert(view.find_close_symbol_forward(buffer->get_iter_at_offset(1), found_iter, '{', '}'));
+    g_assert(found_iter.get_offset() == 1);
+    g_assert(!view.find_open_symbol_backward(buffer->get_iter_at_offset(10), found_iter, '{', '}'));
+    g_assert(view.get_curly_brackets().depth() == -1);
+
+    buffer->erase(buffer->get_iter_at_offset(1), buffer->get_iter_at_offset(2));
+    g_assert(view.find_close_symbol_forward(buffer->get_iter_at_offset(1), found_iter, '{', '}'));
+    g_assert(found_iter.get_offset() == 10);
+    g_assert(view.get_curly_brackets().depth() == 0);
+
+    buffer->insert(buffer->end(), "{");
+    g_assert(view.get_curly_brackets().depth() == 1);
+    g_assert(!view.find_close_symbol_forward(buffer->get_iter_at_offset(12), found_iter, '{', '}'));
+  }
+
+  // Incremental diagnostics update tests
+  {
+    auto buffer = view.get_buffer();
+    buffer->set_text("int a;\nint b;\n");
+    auto error_tag = buffer->get_tag_table()->lookup("def:error_underline");
+    auto warning_tag = buffer->get_tag_table()->lookup("def:warning_underline");
+
+    view.begin_diagnostics_update();
+    view.add_diagnostic_tooltip(buffer->get_iter_at_offset(0), buffer->get_iter_at_offset(3), true, "first", [](Tooltip &) {});
+    view.add_diagnostic_tooltip(buffer->get_iter_at_offset(7), buffer->get_iter_at_offset(10), false, "second", [](Tooltip &) {});
+    view.end_diagnostics_update();
+    g_assert(view.diagnostics.size() == 2);
+    auto first_tooltip = view.diagnostics.front().tooltip;
+
+    view.begin_diagnostics_update();
+    view.add_diagnostic_tooltip(buffer->get_iter_at_offset(0), buffer->get_iter_at_offset(3), true, "first", [](Tooltip &) {});
+    view.add_diagnostic_tooltip(buffer->get_iter_at_offset(7), buffer->get_iter_at_offset(10), false, "changed", [](Tooltip &) {});
+    view.end_diagnostics_update();
+    g_assert(view.diagnostics.size() == 2);
+    g_assert(view.diagnostics.front().tooltip == first_tooltip);
+    g_assert(view.diagnostics.back().message == "changed");
+    g_assert(buffer->get_iter_at_offset(0).has_tag(error_tag));
+    g_assert(buffer->get_iter_at_offset(7).has_tag(warning_tag));
+
+    buffer->remove_tag(warning_tag, buffer->get_iter_at_offset(7), buffer->get_iter_at_offset(10)); // For instance removed by an edit
+    view.begin_diagnostics_update();
+    view.add_diagnostic_tooltip(buffer->get_iter_at_offset(7), buffer->get_iter_at_offset(10), false, "changed", [](Tooltip &) {});
+    view.end_diagnostics_update();
+    g_assert(view.diagnostics.size() == 1);
+    g_assert(!buffer->get_iter_at_offset(0).has_tag(error_tag));
+    g_assert(buffer->get_iter_at_offset(7).has_tag(warning_tag));
+    g_assert(view.diagnostic_offsets == std::set<int>{7});
+
+    view.clear_diagnostic_tooltips();
+    g_assert(view.diagnostics.empty());
+    g_assert(!buffer->get_iter_at_offset(7).has_tag(warning_tag));
+  }
+
   g_assert(boost::filesystem::remove(source_file));
   g_assert(!boost::filesystem::exists(source_file));
 
@@ -871,5 +1006,35 @@ int main() {
       view.on_key_press_event(&event);
       g_assert(buffer->get_text() == "\\begin{te}\n  t\n\\end{te}\n\\begin{te}\n  t\n\\end{te}");
     }
+    {
+      view.clear_snippet_marks();
+      view.extra_cursors.clear();
+      buffer->set_text("\n\n");
+      buffer->place_cursor(buffer->begin());
+      event.keyval = GDK_KEY_Down;
+      event.state = GDK_MOD1_MASK;
+      view.on_key_press_event(&event);
+      view.on_key_press_event(&event);
+      event.state = 0;
+      g_assert(view.extra_cursors.size() == 2);
+
+      size_t changed_count = 0;
+      auto connection = buffer->signal_changed().connect([&changed_count] {
+        ++changed_count;
+      });
+      event.keyval = GDK_KEY_t;
+      view.on_key_press_event(&event);
+      g_assert(buffer->get_text() == "t\nt\nt");
+      g_assert(changed_count == 1);
+
+      changed_count = 0;
+      view.enable_multiple_cursors = true;
+      auto iter = buffer->get_insert()->get_iter();
+      buffer->backspace(iter);
+      view.enable_multiple_cursors = false;
+      g_assert(buffer->get_text() == "\n\n");
+      g_assert(changed_count == 1);
+      connection.disconnect();
+    }
   }
 }
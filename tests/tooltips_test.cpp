@@ -2,6 +2,7 @@
 #include <glib.h>
 #include <gtkmm.h>
 #include <iostream>
+#include <thread>
 
 int main() {
   auto app = Gtk::Application::create();
@@ -528,6 +529,48 @@ int main() {
     tooltip->wrap_lines();
     g_assert(tooltip->buffer->get_text() == "testtesttesttesttesttesttesttesttesttesttesttesttesttesttesttesttesttesttesttesttesttesttesttest\ntest test");
   }
+  {
+    auto input = "# Header\n\n[`text`][test] and [link](http://link.com)\n\n[test]: http://test.com";
+    Tooltip::runs_cache.clear();
+    auto tooltip = get_markdown_tooltip(input);
+    g_assert(Tooltip::runs_cache.size() == 1);
+    auto cached_tooltip = get_markdown_tooltip(input);
+    g_assert(Tooltip::runs_cache.size() == 1);
+
+    g_assert(cached_tooltip->buffer->get_text() == tooltip->buffer->get_text());
+    g_assert(cached_tooltip->buffer->get_text() == "Header\n\ntext and link");
+    auto buffer = cached_tooltip->buffer;
+    g_assert(buffer->begin().starts_tag(cached_tooltip->h1_tag));
+    g_assert(buffer->get_iter_at_offset(6).ends_tag(cached_tooltip->h1_tag));
+    g_assert(buffer->get_iter_at_offset(8).starts_tag(cached_tooltip->link_tag));
+    g_assert(buffer->get_iter_at_offset(8).starts_tag(cached_tooltip->code_tag));
+    g_assert(buffer->get_iter_at_offset(12).ends_tag(cached_tooltip->code_tag));
+    g_assert(buffer->get_iter_at_offset(17).starts_tag(cached_tooltip->link_tag));
+
+    g_assert(cached_tooltip->links.size() == 1);
+    g_assert(cached_tooltip->links.begin()->second == "http://link.com");
+    g_assert(cached_tooltip->reference_links.size() == 1);
+    g_assert(cached_tooltip->reference_links.begin()->second == "test");
+    g_assert(cached_tooltip->references.size() == 1);
+    g_assert(cached_tooltip->references.begin()->second == "http://test.com");
+  }
+  {
+    auto input = "Some *documentation*\n\n```\ncode\n```";
+    Tooltip::runs_cache.clear();
+    std::thread thread([&input] {
+      Tooltip::prerender_markdown(input);
+    });
+    thread.join();
+    g_assert(Tooltip::runs_cache.size() == 1);
+    auto tooltip = get_markdown_tooltip(input);
+    g_assert(Tooltip::runs_cache.size() == 1);
+
+    g_assert(tooltip->buffer->get_text() == "Some documentation\n\ncode");
+    auto buffer = tooltip->buffer;
+    g_assert(buffer->get_iter_at_offset(5).starts_tag(tooltip->italic_tag));
+    g_assert(buffer->get_iter_at_offset(18).ends_tag(tooltip->italic_tag));
+    g_assert(buffer->get_iter_at_offset(20).starts_tag(tooltip->code_block_tag));
+  }
 
   // Testing insert_doxygen
   {
@@ -0,0 +1,60 @@
+#include "json.hpp"
+#include "trace.hpp"
+#include <glib.h>
+#include <thread>
+
+int main() {
+#ifdef JUCI_ENABLE_TRACE
+  auto tests_path = boost::filesystem::canonical(JUCI_TESTS_PATH);
+  auto trace_path = tests_path / "tmp" / "trace_test.json";
+  boost::filesystem::create_directories(trace_path.parent_path());
+
+  {
+    Trace::Span span("not recorded");
+  }
+
+  Trace::set_thread_name("main");
+  Trace::start();
+  g_assert(Trace::is_recording());
+  {
+    Trace::Span span("span");
+    span.set_args("\"size\":1");
+    std::thread thread([] {
+      Trace::Span span("thread span");
+    });
+    thread.join();
+    Trace::counter("counter", 2);
+    auto start = Trace::Clock::now();
+    Trace::async("async", start, start + std::chrono::milliseconds(1), "\"method\":\"\\\"test\\\"\"");
+  }
+  Trace::stop();
+  g_assert(!Trace::is_recording());
+  {
+    Trace::Span span("not recorded");
+  }
+
+  g_assert(Trace::write(trace_path));
+
+  JSON json(trace_path);
+  auto events = json.array("traceEvents");
+  g_assert(events.size() == 6);
+
+  g_assert(events[0].string("ph") == "M");
+  g_assert(events[0].object("args").string("name") == "main");
+  g_assert(events[1].string("name") == "counter");
+  g_assert(events[1].string("ph") == "C");
+  g_assert(events[1].object("args").integer("value") == 2);
+  g_assert(events[2].string("name") == "async");
+  g_assert(events[2].string("ph") == "b");
+  g_assert(events[2].object("args").string("method") == "\"test\"");
+  g_assert(events[3].string("ph") == "e");
+  g_assert(events[3].integer("ts") - events[2].integer("ts") == 1000);
+  g_assert(events[4].string("name") == "span");
+  g_assert(events[4].string("ph") == "X");
+  g_assert(events[4].object("args").integer("size") == 1);
+  g_assert(events[5].string("name") == "thread span");
+  g_assert(events[5].integer("tid") != events[4].integer("tid"));
+
+  boost::filesystem::remove(trace_path);
+#endif
+}
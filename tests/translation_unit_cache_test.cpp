@@ -0,0 +1,79 @@
+#include "compile_commands.hpp"
+#include "translation_unit_cache.hpp"
+#include <fstream>
+#include <glib.h>
+
+int main() {
+  auto tests_path = boost::filesystem::canonical(JUCI_TESTS_PATH);
+  auto project_path = tests_path / "usages_clang_test_files";
+  auto build_path = tests_path / "tmp" / "translation_unit_cache_test";
+  boost::filesystem::create_directories(build_path);
+
+  auto path = project_path / "main.cpp";
+  std::ifstream stream(path.string(), std::ifstream::binary);
+  g_assert(stream);
+  std::string buffer;
+  buffer.assign(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>());
+  auto arguments = CompileCommands::get_arguments(project_path / "build", path);
+
+  auto cx_index = clang_createIndex(0, 0);
+  {
+    TranslationUnitCache cache(project_path, build_path, path, arguments, 0, buffer);
+    g_assert(!cache.load(cx_index));
+    g_assert(!cache.can_save(buffer + '\n'));
+    g_assert(!cache.save(buffer + '\n'));
+    g_assert(cache.can_save(buffer));
+    g_assert(cache.save(buffer));
+    g_assert(boost::filesystem::exists(build_path / TranslationUnitCache::cache_folder / "main.cpp.ast"));
+
+    auto cx_tu = cache.load(cx_index);
+    g_assert(cx_tu);
+    clang_disposeTranslationUnit(cx_tu);
+  }
+  {
+    TranslationUnitCache cache(project_path, build_path, path, arguments, 0, buffer + '\n');
+    g_assert(!cache.load(cx_index));
+  }
+  {
+    TranslationUnitCache cache(project_path, build_path, path, {}, 0, buffer);
+    g_assert(!cache.load(cx_index));
+  }
+  {
+    TranslationUnitCache cache(project_path, build_path, path, arguments, 1, buffer);
+    g_assert(!cache.load(cx_index));
+  }
+  {
+    // Modifying an included file invalidates the saved translation unit
+    auto include_path = project_path / "test.hpp";
+    auto last_write_time = boost::filesystem::last_write_time(include_path);
+    boost::filesystem::last_write_time(include_path, last_write_time + 1);
+    TranslationUnitCache cache(project_path, build_path, path, arguments, 0, buffer);
+    g_assert(!cache.load(cx_index));
+    boost::filesystem::last_write_time(include_path, last_write_time);
+    auto cx_tu = cache.load(cx_index);
+    g_assert(cx_tu);
+    clang_disposeTranslationUnit(cx_tu);
+  }
+  {
+    // The least recently used translation units are removed when the cache folder exceeds max_cache_size
+    auto cache_path = build_path / TranslationUnitCache::cache_folder;
+    auto old_ast_path = cache_path / "old.cpp.ast";
+    auto old_info_path = cache_path / "old.cpp.json";
+    {
+      std::ofstream stream(old_ast_path.string());
+      std::ofstream info_stream(old_info_path.string());
+    }
+    boost::filesystem::resize_file(old_ast_path, TranslationUnitCache::max_cache_size); // Sparse file
+    boost::filesystem::last_write_time(old_ast_path, boost::filesystem::last_write_time(cache_path / "main.cpp.ast") - 10);
+
+    TranslationUnitCache cache(project_path, build_path, path, arguments, 0, buffer);
+    g_assert(cache.save(buffer));
+    g_assert(!boost::filesystem::exists(old_ast_path));
+    g_assert(!boost::filesystem::exists(old_info_path));
+    g_assert(boost::filesystem::exists(cache_path / "main.cpp.ast"));
+    g_assert(boost::filesystem::exists(cache_path / "main.cpp.json"));
+  }
+  clang_disposeIndex(cx_index);
+
+  boost::filesystem::remove_all(build_path);
+}